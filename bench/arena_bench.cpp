@@ -0,0 +1,295 @@
+// Global heap allocations of a simulated fleet, at setup and in its
+// steady-state loop.
+//
+// Simulates --vehicles vehicles without MAVSDK. A control thread ticks at
+// --rate-hz for --seconds and, per vehicle and tick, publishes a position
+// sample to the vehicle's BusTopic (whose subscriber logs the altitude through
+// the vehicle's AsyncLog) and posts a mission step to a shared WorkerPool,
+// like the fleet mode does.
+//
+// Three variants separate the two changes:
+// - before: rings and log records on the global heap, steps capturing a
+//   shared_ptr, as the fleet used to.
+// - this: the same, with steps that only capture `this`.
+// - arena: also the rings and log records from a sealed per-vehicle
+//   VehicleArena.
+// Both of the first two preallocate their rings, so the steady-state drop is
+// all the captures'; the arena takes the setup memory off the global heap
+// and shows whether the loop ever needs more. Global operator new is replaced
+// here to count every heap allocation on any thread, at setup and after a
+// warm-up second.
+//
+// This is a model of the fleet loop. hot_path_alloc_bench --fleet N checks
+// the real Fleet against mock autopilots.
+//
+// Usage: arena_bench [--vehicles 1,8,32,128] [--rate-hz HZ] [--seconds S]
+//                    [--workers N]
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "async_log.h"
+#include "bench_util.h"
+#include "deadline_timer.h"
+#include "telemetry_bus.h"
+#include "vehicle_arena.h"
+#include "worker_pool.h"
+
+using bench::Clock;
+using Position = mavsdk::Telemetry::Position;
+
+namespace {
+
+std::atomic<uint64_t> heap_allocations{0};
+
+} // namespace
+
+void* operator new(size_t size)
+{
+    heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+// std::pmr's default resource asks for over-aligned blocks, like the rings'
+// cache-line aligned slots, through these.
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    const auto align = std::max(static_cast<size_t>(alignment), sizeof(void*));
+    // aligned_alloc() wants a multiple of the alignment.
+    const size_t rounded = (std::max<size_t>(size, 1) + align - 1) / align * align;
+    if (void* p = std::aligned_alloc(align, rounded)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+namespace {
+
+FILE* null_output()
+{
+    static FILE* out = std::fopen("/dev/null", "w");
+    return out;
+}
+
+enum class Mode {
+    Before,
+    ThisCapture,
+    Arena,
+};
+
+class SimVehicle : public std::enable_shared_from_this<SimVehicle> {
+public:
+    SimVehicle(WorkerPool& pool, Mode mode) :
+        _pool(pool),
+        _mode(mode),
+        _log(log_options(_arena, mode == Mode::Arena)),
+        _position(mode == Mode::Arena ? _arena.resource() : std::pmr::get_default_resource())
+    {
+        _subscription = _position.subscribe(
+            [this](const Stamped<Position>& sample) {
+                _log.log("altitude {} m\n", sample.value.relative_altitude_m);
+            },
+            64);
+    }
+
+    ~SimVehicle() { _position.unsubscribe(_subscription); }
+
+    void seal() { _arena.seal(); }
+    uint64_t arena_allocations() const { return _arena.allocations_since_seal(); }
+    uint64_t steps() const { return _steps.load(std::memory_order_relaxed); }
+
+    // One control tick: a telemetry sample in, a step out.
+    void tick(float altitude_m)
+    {
+        Position position{};
+        position.relative_altitude_m = altitude_m;
+        _position.publish(position);
+
+        if (_step_requests.fetch_add(1, std::memory_order_acq_rel) != 0) {
+            return;
+        }
+        if (_mode != Mode::Before) {
+            _keep_alive = shared_from_this();
+            _pool.post([this]() {
+                const auto self = std::move(_keep_alive);
+                run_steps();
+            });
+        } else {
+            _pool.post([self = shared_from_this()]() { self->run_steps(); });
+        }
+    }
+
+private:
+    static AsyncLog::Options log_options(VehicleArena& arena, bool use_arena)
+    {
+        AsyncLog::Options options;
+        options.capacity = 256;
+        options.out = null_output();
+        if (use_arena) {
+            options.resource = arena.resource();
+        }
+        return options;
+    }
+
+    void run_steps()
+    {
+        auto requests = _step_requests.load(std::memory_order_acquire);
+        while (true) {
+            _steps.fetch_add(1, std::memory_order_relaxed);
+            if (_step_requests.compare_exchange_strong(requests, 0, std::memory_order_acq_rel)) {
+                return;
+            }
+        }
+    }
+
+    WorkerPool& _pool;
+    const Mode _mode;
+    VehicleArena _arena;
+    AsyncLog _log;
+    BusTopic<Position> _position;
+    std::shared_ptr<BusTopic<Position>::Subscription> _subscription;
+
+    std::shared_ptr<SimVehicle> _keep_alive;
+    std::atomic<uint32_t> _step_requests{0};
+    std::atomic<uint64_t> _steps{0};
+};
+
+struct Result {
+    uint64_t setup_allocations{0};
+    uint64_t steps{0};
+    uint64_t heap_allocations{0};
+    uint64_t arena_allocations{0};
+    double seconds{0.0};
+};
+
+Result run(size_t vehicles, Mode mode, double rate_hz, double seconds, size_t workers)
+{
+    Result result;
+    WorkerPool pool{workers};
+    std::vector<std::shared_ptr<SimVehicle>> fleet;
+    fleet.reserve(vehicles);
+    const auto setup_before = heap_allocations.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < vehicles; ++i) {
+        fleet.push_back(std::make_shared<SimVehicle>(pool, mode));
+    }
+    result.setup_allocations = heap_allocations.load(std::memory_order_relaxed) - setup_before;
+
+    const auto period = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(1.0 / rate_hz));
+    const auto ticks = [&](double duration_s, float& altitude_m) {
+        auto deadline = Clock::now();
+        const auto end = deadline + std::chrono::duration_cast<Clock::duration>(
+                                        std::chrono::duration<double>(duration_s));
+        while (deadline < end) {
+            for (auto& vehicle : fleet) {
+                vehicle->tick(altitude_m);
+            }
+            altitude_m += 0.01f;
+            deadline += period;
+            sleep_until_deadline(deadline);
+        }
+    };
+
+    // Warm-up: threads, stdio buffers and the queue's blocks settle.
+    float altitude_m = 0.0f;
+    ticks(1.0, altitude_m);
+    pool.wait_idle();
+    for (auto& vehicle : fleet) {
+        vehicle->seal();
+    }
+
+    uint64_t steps_before = 0;
+    for (auto& vehicle : fleet) {
+        steps_before += vehicle->steps();
+    }
+    const auto allocations_before = heap_allocations.load(std::memory_order_relaxed);
+    const auto started = Clock::now();
+    ticks(seconds, altitude_m);
+    pool.wait_idle();
+    result.heap_allocations =
+        heap_allocations.load(std::memory_order_relaxed) - allocations_before;
+    result.seconds = std::chrono::duration<double>(Clock::now() - started).count();
+
+    for (auto& vehicle : fleet) {
+        result.steps += vehicle->steps();
+        result.arena_allocations += vehicle->arena_allocations();
+    }
+    result.steps -= steps_before;
+    return result;
+}
+
+void print(const char* mode, size_t vehicles, const Result& result)
+{
+    std::printf(
+        "%-6s %9zu %12llu %10llu %13llu %14.1f %11llu\n",
+        mode,
+        vehicles,
+        static_cast<unsigned long long>(result.setup_allocations),
+        static_cast<unsigned long long>(result.steps),
+        static_cast<unsigned long long>(result.heap_allocations),
+        static_cast<double>(result.heap_allocations) / result.seconds,
+        static_cast<unsigned long long>(result.arena_allocations));
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const auto vehicle_counts =
+        bench::parse_list(bench::arg_value(argc, argv, "--vehicles", "1,8,32,128"));
+    const double rate_hz = bench::arg_double(argc, argv, "--rate-hz", 50.0);
+    const double seconds = bench::arg_double(argc, argv, "--seconds", 3.0);
+    const auto workers = static_cast<size_t>(bench::arg_long(argc, argv, "--workers", 4));
+
+    std::printf(
+        "%.0f Hz ticks for %.1f s after 1 s of warm-up, %zu workers\n\n",
+        rate_hz,
+        seconds,
+        workers);
+    std::printf(
+        "%-6s %9s %12s %10s %13s %14s %11s\n",
+        "mode",
+        "vehicles",
+        "setup allocs",
+        "steps",
+        "heap allocs",
+        "heap allocs/s",
+        "arena grew");
+
+    for (const long count : vehicle_counts) {
+        const auto vehicles = static_cast<size_t>(std::max(count, 1L));
+        print("before", vehicles, run(vehicles, Mode::Before, rate_hz, seconds, workers));
+        print("this", vehicles, run(vehicles, Mode::ThisCapture, rate_hz, seconds, workers));
+        print("arena", vehicles, run(vehicles, Mode::Arena, rate_hz, seconds, workers));
+    }
+    return 0;
+}
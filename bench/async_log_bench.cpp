@@ -0,0 +1,71 @@
+// Callback-thread stall time: std::cout vs. AsyncLog.
+//
+// Simulates the position callback logging one line per sample and measures how
+// long each call keeps the callback thread busy. Log output goes to stdout,
+// results to stderr, so run it with stdout on a terminal, a file or /dev/null
+// to compare the cost of each destination:
+//
+//   async_log_bench > /dev/null
+//   async_log_bench > log.txt
+//
+// Usage: async_log_bench [--samples N] [--rate-hz HZ]
+
+#include <iostream>
+#include <thread>
+
+#include "async_log.h"
+#include "bench_util.h"
+
+using bench::Clock;
+
+int main(int argc, char** argv)
+{
+    const long samples = bench::arg_long(argc, argv, "--samples", 20000);
+    const double rate_hz = bench::arg_double(argc, argv, "--rate-hz", 0.0);
+
+    const auto period = rate_hz > 0.0 ? std::chrono::duration_cast<Clock::duration>(
+                                            std::chrono::duration<double>(1.0 / rate_hz)) :
+                                        Clock::duration::zero();
+
+    const auto run = [&](bench::LatencyStats& stats, auto&& log_line) {
+        stats.reserve(static_cast<size_t>(samples));
+        auto next = Clock::now();
+        for (long i = 0; i < samples; ++i) {
+            const float altitude_m = 0.001f * static_cast<float>(i);
+            const auto before = Clock::now();
+            log_line(altitude_m);
+            stats.add(Clock::now() - before);
+
+            if (period != Clock::duration::zero()) {
+                next += period;
+                std::this_thread::sleep_until(next);
+            }
+        }
+    };
+
+    bench::LatencyStats sync_stats;
+    run(sync_stats, [](float altitude_m) {
+        std::cout << "[Telem] Altitude (rel): " << altitude_m << " m\n";
+    });
+    std::cout.flush();
+
+    bench::LatencyStats async_stats;
+    uint64_t dropped = 0;
+    {
+        AsyncLog::Options options;
+        options.capacity = 1 << 16;
+        AsyncLog async_log{options};
+        run(async_stats, [&](float altitude_m) {
+            async_log.log("[Telem] Altitude (rel): {} m\n", altitude_m);
+        });
+        async_log.flush();
+        dropped = async_log.dropped();
+    }
+
+    std::fprintf(stderr, "callback stall per log call, %ld samples\n", samples);
+    sync_stats.print("std::cout", stderr);
+    async_stats.print("AsyncLog", stderr);
+    std::fprintf(
+        stderr, "AsyncLog dropped %llu records\n", static_cast<unsigned long long>(dropped));
+    return 0;
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+// Small helpers shared by the benchmark executables.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace bench {
+
+using Clock = std::chrono::steady_clock;
+
+inline double to_us(Clock::duration duration)
+{
+    return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+// Collects latency samples and reports percentiles.
+class LatencyStats {
+public:
+    void reserve(size_t count) { _samples_us.reserve(count); }
+    void add(Clock::duration duration) { _samples_us.push_back(to_us(duration)); }
+    void add_us(double us) { _samples_us.push_back(us); }
+
+    size_t count() const { return _samples_us.size(); }
+
+    // p in [0, 1]. Sorts lazily.
+    double percentile_us(double p)
+    {
+        if (_samples_us.empty()) {
+            return 0.0;
+        }
+        if (!_sorted) {
+            std::sort(_samples_us.begin(), _samples_us.end());
+            _sorted = true;
+        }
+        const auto index = static_cast<size_t>(p * static_cast<double>(_samples_us.size() - 1));
+        return _samples_us[index];
+    }
+
+    double mean_us() const
+    {
+        if (_samples_us.empty()) {
+            return 0.0;
+        }
+        double sum = 0.0;
+        for (double sample : _samples_us) {
+            sum += sample;
+        }
+        return sum / static_cast<double>(_samples_us.size());
+    }
+
+    void print(const std::string& label, FILE* out = stdout)
+    {
+        std::fprintf(
+            out,
+            "%-32s n=%-7zu mean=%10.1f us  p50=%10.1f us  p99=%10.1f us  p999=%10.1f us  "
+            "max=%10.1f us\n",
+            label.c_str(),
+            count(),
+            mean_us(),
+            percentile_us(0.5),
+            percentile_us(0.99),
+            percentile_us(0.999),
+            percentile_us(1.0));
+    }
+
+private:
+    std::vector<double> _samples_us;
+    bool _sorted{false};
+};
+
+// CPU time and resident memory of this process.
+struct ProcessUsage {
+    double cpu_s{0.0};
+    double rss_mb{0.0};
+
+    static ProcessUsage now()
+    {
+        ProcessUsage usage;
+#if defined(__linux__)
+        rusage ru{};
+        if (getrusage(RUSAGE_SELF, &ru) == 0) {
+            usage.cpu_s = static_cast<double>(ru.ru_utime.tv_sec + ru.ru_stime.tv_sec) +
+                          static_cast<double>(ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+        }
+        if (FILE* statm = std::fopen("/proc/self/statm", "r")) {
+            unsigned long size_pages = 0;
+            unsigned long resident_pages = 0;
+            if (std::fscanf(statm, "%lu %lu", &size_pages, &resident_pages) == 2) {
+                usage.rss_mb = static_cast<double>(resident_pages) *
+                               static_cast<double>(sysconf(_SC_PAGESIZE)) / (1024.0 * 1024.0);
+            }
+            std::fclose(statm);
+        }
+#endif
+        return usage;
+    }
+};
+
+// Splits a comma-separated list of integers, e.g. "1,8,32".
+inline std::vector<long> parse_list(const std::string& list)
+{
+    std::vector<long> values;
+    size_t start = 0;
+    while (start < list.size()) {
+        const auto end = list.find(',', start);
+        values.push_back(std::strtol(list.substr(start, end - start).c_str(), nullptr, 10));
+        if (end == std::string::npos) {
+            break;
+        }
+        start = end + 1;
+    }
+    return values;
+}
+
+// Returns the value following `--name` on the command line, or `fallback`.
+inline std::string arg_value(int argc, char** argv, const char* name, const std::string& fallback)
+{
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::strcmp(argv[i], name) == 0) {
+            return argv[i + 1];
+        }
+    }
+    return fallback;
+}
+
+inline long arg_long(int argc, char** argv, const char* name, long fallback)
+{
+    const auto value = arg_value(argc, argv, name, "");
+    return value.empty() ? fallback : std::strtol(value.c_str(), nullptr, 10);
+}
+
+inline double arg_double(int argc, char** argv, const char* name, double fallback)
+{
+    const auto value = arg_value(argc, argv, name, "");
+    return value.empty() ? fallback : std::strtod(value.c_str(), nullptr);
+}
+
+inline bool arg_flag(int argc, char** argv, const char* name)
+{
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace bench
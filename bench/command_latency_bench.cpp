@@ -0,0 +1,166 @@
+// Action command round-trip latency against a local mock autopilot.
+//
+// Each iteration issues set_takeoff_altitude, arm, takeoff and land. The sync
+// variant calls them one after another; the async variant issues all four
+// *_async calls at once and waits for their results. Reports p50/p99/p999 per
+// command and the command throughput of each variant.
+//
+// `--max-p99-ms` turns the run into a regression check: the exit code is
+// non-zero if any command's p99 exceeds it.
+//
+// Usage: command_latency_bench [--iterations N] [--port PORT] [--max-p99-ms MS]
+
+#include <array>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+
+#include <mavsdk/mavsdk.h>
+#include <mavsdk/plugins/action/action.h>
+
+#include "bench_util.h"
+#include "mock_autopilot.h"
+
+using namespace mavsdk;
+using bench::Clock;
+
+namespace {
+
+constexpr size_t command_count = 4;
+constexpr std::array<const char*, command_count> command_names{
+    {"set_takeoff_altitude", "arm", "takeoff", "land"}};
+
+struct Variant {
+    std::array<bench::LatencyStats, command_count> latency;
+    uint64_t failures{0};
+    double commands_per_s{0.0};
+};
+
+void run_sync(Action& action, long iterations, Variant& variant)
+{
+    const auto started = Clock::now();
+    for (long i = 0; i < iterations; ++i) {
+        const std::array<std::function<Action::Result()>, command_count> commands{
+            {[&]() { return action.set_takeoff_altitude(2.0f); },
+             [&]() { return action.arm(); },
+             [&]() { return action.takeoff(); },
+             [&]() { return action.land(); }}};
+
+        for (size_t c = 0; c < command_count; ++c) {
+            const auto before = Clock::now();
+            const auto result = commands[c]();
+            variant.latency[c].add(Clock::now() - before);
+            if (result != Action::Result::Success) {
+                ++variant.failures;
+            }
+        }
+    }
+    const double elapsed = std::chrono::duration<double>(Clock::now() - started).count();
+    variant.commands_per_s = static_cast<double>(iterations * command_count) / elapsed;
+}
+
+void run_async(Action& action, long iterations, Variant& variant)
+{
+    std::mutex mutex;
+    std::condition_variable cv;
+
+    const auto started = Clock::now();
+    for (long i = 0; i < iterations; ++i) {
+        size_t pending = command_count;
+        const auto issued = Clock::now();
+
+        const auto callback_for = [&](size_t c) {
+            return [&, c](Action::Result result) {
+                const auto latency = Clock::now() - issued;
+                std::lock_guard<std::mutex> lock(mutex);
+                variant.latency[c].add(latency);
+                if (result != Action::Result::Success) {
+                    ++variant.failures;
+                }
+                if (--pending == 0) {
+                    cv.notify_one();
+                }
+            };
+        };
+
+        action.set_takeoff_altitude_async(2.0f, callback_for(0));
+        action.arm_async(callback_for(1));
+        action.takeoff_async(callback_for(2));
+        action.land_async(callback_for(3));
+
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&]() { return pending == 0; });
+    }
+    const double elapsed = std::chrono::duration<double>(Clock::now() - started).count();
+    variant.commands_per_s = static_cast<double>(iterations * command_count) / elapsed;
+}
+
+void report(const char* name, Variant& variant)
+{
+    std::printf(
+        "%s: %.0f commands/s, %llu failures\n",
+        name,
+        variant.commands_per_s,
+        static_cast<unsigned long long>(variant.failures));
+    for (size_t c = 0; c < command_count; ++c) {
+        variant.latency[c].print(std::string("  ") + command_names[c]);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const long iterations = bench::arg_long(argc, argv, "--iterations", 200);
+    const auto port = static_cast<uint16_t>(bench::arg_long(argc, argv, "--port", 14561));
+    const double max_p99_ms = bench::arg_double(argc, argv, "--max-p99-ms", 0.0);
+
+    MockAutopilot::Options mock_options;
+    mock_options.remote_port = port;
+    MockAutopilot mock{mock_options};
+    if (!mock.start()) {
+        std::cerr << "Could not start mock autopilot\n";
+        return 1;
+    }
+
+    Mavsdk mavsdk{Mavsdk::Configuration{ComponentType::GroundStation}};
+    if (mavsdk.add_any_connection("udpin://0.0.0.0:" + std::to_string(port)) !=
+        ConnectionResult::Success) {
+        std::cerr << "Connection failed\n";
+        return 1;
+    }
+    auto system = mavsdk.first_autopilot(5.0);
+    if (!system) {
+        std::cerr << "Timed out waiting for mock autopilot\n";
+        return 1;
+    }
+    Action action{system.value()};
+
+    Variant sync_variant;
+    Variant async_variant;
+    run_sync(action, iterations, sync_variant);
+    run_async(action, iterations, async_variant);
+
+    std::printf("%ld iterations of 4 commands\n", iterations);
+    report("sync", sync_variant);
+    report("async", async_variant);
+
+    if (max_p99_ms > 0.0) {
+        bool regressed = false;
+        for (auto* variant : {&sync_variant, &async_variant}) {
+            for (size_t c = 0; c < command_count; ++c) {
+                const double p99_ms = variant->latency[c].percentile_us(0.99) / 1000.0;
+                if (p99_ms > max_p99_ms) {
+                    std::printf(
+                        "REGRESSION: %s p99 %.2f ms > %.2f ms\n",
+                        command_names[c],
+                        p99_ms,
+                        max_p99_ms);
+                    regressed = true;
+                }
+            }
+        }
+        return regressed ? 1 : 0;
+    }
+    return 0;
+}
@@ -0,0 +1,163 @@
+// Fleet scaling: CPU, memory and command latency vs. number of vehicles.
+//
+// For every fleet size, starts that many mock autopilots in a child process
+// (so their CPU time and memory are not counted here), waits for all of them
+// and flies the fleet mission. With `--url` the mocks are skipped and the
+// vehicles have to come from a multi-vehicle simulation on that connection.
+//
+// Usage: fleet_bench [--vehicles 1,8,32,128] [--workers N] [--max-wait-s S]
+//                    [--port PORT] [--time-scale X] [--url URL]
+
+#include <array>
+#include <csignal>
+#include <iostream>
+#include <memory>
+#include <sstream>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <mavsdk/mavsdk.h>
+
+#include "bench_util.h"
+#include "fleet.h"
+#include "mock_autopilot.h"
+
+using bench::Clock;
+
+namespace {
+
+// Forks a child running `count` mock autopilots until it is killed.
+pid_t spawn_mocks(size_t count, uint16_t port, double time_scale)
+{
+    const pid_t pid = fork();
+    if (pid != 0) {
+        return pid;
+    }
+
+    std::vector<std::unique_ptr<MockAutopilot>> autopilots;
+    for (size_t i = 0; i < count; ++i) {
+        MockAutopilot::Options options;
+        options.system_id = static_cast<uint8_t>(i + 1);
+        options.remote_port = port;
+        options.time_scale = time_scale;
+        autopilots.push_back(std::make_unique<MockAutopilot>(options));
+        if (!autopilots.back()->start()) {
+            _exit(1);
+        }
+    }
+    while (true) {
+        pause();
+    }
+}
+
+void kill_mocks(pid_t pid)
+{
+    if (pid > 0) {
+        kill(pid, SIGKILL);
+        waitpid(pid, nullptr, 0);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const auto external_url = bench::arg_value(argc, argv, "--url", "");
+    const auto sizes = bench::parse_list(bench::arg_value(argc, argv, "--vehicles", "1,8,32,128"));
+    const long workers = bench::arg_long(argc, argv, "--workers", 0);
+    const auto port = static_cast<uint16_t>(bench::arg_long(argc, argv, "--port", 14560));
+    const double time_scale = bench::arg_double(argc, argv, "--time-scale", 5.0);
+    // Defaults to the 20 s of rotate's flight in simulated time.
+    const double max_wait_s = bench::arg_double(
+        argc, argv, "--max-wait-s", external_url.empty() ? 20.0 / time_scale : 20.0);
+
+    const bool use_mocks = external_url.empty();
+    const auto url = use_mocks ? "udpin://0.0.0.0:" + std::to_string(port) : external_url;
+
+    std::printf(
+        "%-9s %-8s %10s %10s %10s %10s\n",
+        "vehicles",
+        "landed",
+        "wall s",
+        "cpu s",
+        "cpu %",
+        "rss MB");
+
+    std::vector<std::array<bench::LatencyStats, Fleet::command_count>> latencies;
+
+    for (const long size : sizes) {
+        if (size < 1 || size > 255) {
+            std::cerr << "Fleet sizes must be 1..255\n";
+            return 1;
+        }
+        const pid_t mocks =
+            use_mocks ? spawn_mocks(static_cast<size_t>(size), port, time_scale) : 0;
+
+        const auto before = bench::ProcessUsage::now();
+        const auto started = Clock::now();
+
+        size_t landed = 0;
+        std::array<bench::LatencyStats, Fleet::command_count> command_latency;
+        double peak_rss_mb = 0.0;
+        {
+            mavsdk::Mavsdk mavsdk{
+                mavsdk::Mavsdk::Configuration{mavsdk::ComponentType::GroundStation}};
+            if (mavsdk.add_any_connection(url) != mavsdk::ConnectionResult::Success) {
+                std::cerr << "Connection to " << url << " failed\n";
+                kill_mocks(mocks);
+                return 1;
+            }
+
+            Fleet::Options options;
+            options.vehicles = static_cast<size_t>(size);
+            options.workers = static_cast<size_t>(workers);
+            options.mission.max_wait =
+                std::chrono::milliseconds(static_cast<long>(max_wait_s * 1000.0));
+
+            Fleet fleet{mavsdk, options};
+            if (fleet.discover() < options.vehicles) {
+                std::cerr << "Found fewer than " << size << " vehicles on " << url << "\n";
+                kill_mocks(mocks);
+                return 1;
+            }
+            fleet.run();
+            peak_rss_mb = bench::ProcessUsage::now().rss_mb;
+
+            for (const auto& report : fleet.reports()) {
+                if (report.outcome == Fleet::Outcome::Landed) {
+                    ++landed;
+                }
+                for (size_t i = 0; i < Fleet::command_count; ++i) {
+                    if (report.command_latency_ms[i] >= 0.0) {
+                        command_latency[i].add_us(report.command_latency_ms[i] * 1000.0);
+                    }
+                }
+            }
+        }
+
+        kill_mocks(mocks);
+
+        const double wall_s = std::chrono::duration<double>(Clock::now() - started).count();
+        const double cpu_s = bench::ProcessUsage::now().cpu_s - before.cpu_s;
+        std::printf(
+            "%-9ld %-8zu %10.2f %10.2f %10.1f %10.1f\n",
+            size,
+            landed,
+            wall_s,
+            cpu_s,
+            100.0 * cpu_s / wall_s,
+            peak_rss_mb);
+        latencies.push_back(std::move(command_latency));
+    }
+
+    std::printf("\ncommand round-trip latency\n");
+    for (size_t s = 0; s < sizes.size(); ++s) {
+        for (size_t i = 0; i < Fleet::command_count; ++i) {
+            std::ostringstream label;
+            label << sizes[s] << " vehicles, " << static_cast<Fleet::Command>(i);
+            latencies[s][i].print(label.str());
+        }
+    }
+    return 0;
+}
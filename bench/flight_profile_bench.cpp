@@ -0,0 +1,151 @@
+// Setpoint law cost: compiled flight profile vs. runtime-configured parameters.
+//
+// Runs the rotate-while-climbing setpoint law over a simulated stream of
+// deadlines, one period apart with an occasional missed one, and reports the
+// time per setpoint. ClimbRotateLaw<X500Sitl> has its rates and period as
+// constants; RuntimeClimbRotateLaw reads the same values (or a --profile file)
+// at runtime. Each is timed called directly and through the
+// SetpointStreamer::Generator the streaming thread calls, and the yaw
+// sequences are compared.
+//
+// Usage: flight_profile_bench [--ticks N] [--profile FILE]
+
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+
+#include "bench_util.h"
+#include "flight_profile.h"
+
+using bench::Clock;
+
+namespace {
+
+using Profile = flight_profiles::X500Sitl;
+using Law = ClimbRotateLaw<Profile>;
+
+struct Run {
+    double ns_per_tick{0.0};
+    float final_yaw_deg{0.0f};
+    double checksum{0.0};
+};
+
+// One deadline in this many is late by a whole period.
+constexpr long miss_every = 1000;
+
+template<typename Next> Run run(long ticks, Next&& next)
+{
+    ClimbRotateState state{};
+    auto deadline = SetpointStreamer::Clock::time_point{} + std::chrono::seconds(1);
+    double checksum = 0.0;
+
+    const auto started = Clock::now();
+    for (long i = 0; i < ticks; ++i) {
+        deadline += Law::period;
+        if (i % miss_every == miss_every - 1) {
+            deadline += Law::period;
+        }
+        const Setpoint setpoint = next(state, deadline);
+        checksum += setpoint.velocity.yaw_deg + setpoint.velocity.down_m_s;
+    }
+    const auto elapsed = Clock::now() - started;
+
+    Run result;
+    result.ns_per_tick = std::chrono::duration<double, std::nano>(elapsed).count() /
+                         static_cast<double>(ticks);
+    result.final_yaw_deg = state.yaw_deg;
+    result.checksum = checksum;
+    return result;
+}
+
+void print(const char* label, const Run& result)
+{
+    std::printf(
+        "%-36s %8.2f ns/setpoint   final yaw %8.3f deg\n",
+        label,
+        result.ns_per_tick,
+        result.final_yaw_deg);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const long ticks = bench::arg_long(argc, argv, "--ticks", 20'000'000);
+    const auto profile_path = bench::arg_value(argc, argv, "--profile", "");
+
+    // Read through a volatile so the compiler cannot fold the defaults into
+    // the runtime law and turn it back into the compiled one.
+    MissionParams params = Profile::params;
+    volatile float yaw_rate = params.yaw_rate_deg_s;
+    params.yaw_rate_deg_s = yaw_rate;
+    if (!profile_path.empty()) {
+        std::string error;
+        if (!load_mission_params(profile_path, params, error)) {
+            std::cerr << error << '\n';
+            return 1;
+        }
+        if (params.setpoint_rate_hz != Profile::params.setpoint_rate_hz) {
+            std::cerr << "The profile's setpoint_rate_hz must match the compiled one to compare\n";
+            return 1;
+        }
+    }
+
+    const Law compiled{};
+    const RuntimeClimbRotateLaw runtime{params};
+
+    std::printf(
+        "%ld setpoints at %.0f Hz, one deadline in %ld missed\n\n",
+        ticks,
+        Profile::params.setpoint_rate_hz,
+        miss_every);
+
+    const auto compiled_direct = run(ticks, [&](ClimbRotateState& state, auto deadline) {
+        return compiled.next(state, true, deadline);
+    });
+    const auto runtime_direct = run(ticks, [&](ClimbRotateState& state, auto deadline) {
+        return runtime.next(state, true, deadline);
+    });
+
+    // As the streaming thread sees them: one type-erased call per setpoint.
+    ClimbRotateState* current = nullptr;
+    const SetpointStreamer::Generator compiled_generator =
+        [&](SetpointStreamer::Clock::time_point deadline) {
+            return compiled.next(*current, true, deadline);
+        };
+    const SetpointStreamer::Generator runtime_generator =
+        [&](SetpointStreamer::Clock::time_point deadline) {
+            return runtime.next(*current, true, deadline);
+        };
+    const auto compiled_erased = run(ticks, [&](ClimbRotateState& state, auto deadline) {
+        current = &state;
+        return compiled_generator(deadline);
+    });
+    const auto runtime_erased = run(ticks, [&](ClimbRotateState& state, auto deadline) {
+        current = &state;
+        return runtime_generator(deadline);
+    });
+
+    print("compiled profile", compiled_direct);
+    print("runtime profile", runtime_direct);
+    print("compiled profile, via Generator", compiled_erased);
+    print("runtime profile, via Generator", runtime_erased);
+
+    std::printf(
+        "\nspeedup %.2fx direct, %.2fx via Generator\n",
+        runtime_direct.ns_per_tick / compiled_direct.ns_per_tick,
+        runtime_erased.ns_per_tick / compiled_erased.ns_per_tick);
+    if (profile_path.empty()) {
+        std::printf(
+            "yaw difference after %ld setpoints: %.4f deg\n",
+            ticks,
+            std::fabs(compiled_direct.final_yaw_deg - runtime_direct.final_yaw_deg));
+    }
+    // Keeps the checksums, and so the loops, from being optimized away.
+    if (compiled_direct.checksum + runtime_direct.checksum + compiled_erased.checksum +
+            runtime_erased.checksum ==
+        0.0) {
+        std::printf("\n");
+    }
+    return 0;
+}
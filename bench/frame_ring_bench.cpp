@@ -0,0 +1,176 @@
+// Camera frame hand-off through the shared-memory FrameRing vs. a copy per
+// consumer.
+//
+// A synthetic publisher copies frames into the ring, as camera_ingest does with
+// each ROS message, either as fast as it can or at --rate-hz. Each consumer
+// maps the ring separately, as another process would, and takes the latest
+// frame. In "in place" mode it reads the pixels where they are. In "copy" mode
+// it first copies them into its own buffer, which is what np.frombuffer plus
+// cvtColor amount to in vision.py. Reports frames/s published and consumed,
+// drops, and publish-to-consumer latency.
+//
+// Usage: frame_ring_bench [--width W] [--height H] [--seconds S]
+//                         [--consumers N] [--rate-hz HZ]
+
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "bench_util.h"
+#include "deadline_timer.h"
+#include "frame_ring.h"
+
+using bench::Clock;
+
+namespace {
+
+const char* ring_name = "/rotate_frame_ring_bench";
+
+struct Result {
+    uint64_t published{0};
+    uint64_t dropped{0};
+    std::vector<uint64_t> consumed;
+    std::vector<bench::LatencyStats> latency;
+    // Keeps the pixel reads from being optimized away.
+    uint64_t checksum{0};
+};
+
+int64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               Clock::now().time_since_epoch())
+        .count();
+}
+
+Result run(
+    uint32_t width, uint32_t height, double seconds, size_t consumers, double rate_hz, bool copy)
+{
+    const size_t frame_bytes = static_cast<size_t>(width) * height * 3;
+    auto ring = FrameRing::create(ring_name, 8, frame_bytes);
+    if (!ring) {
+        std::cerr << "Could not create " << ring_name << '\n';
+        std::exit(1);
+    }
+
+    Result result;
+    result.consumed.resize(consumers);
+    result.latency.resize(consumers);
+    std::atomic<bool> running{true};
+    std::atomic<uint64_t> checksum{0};
+
+    std::vector<std::thread> threads;
+    for (size_t c = 0; c < consumers; ++c) {
+        threads.emplace_back([&, c]() {
+            auto reader = FrameRing::open(ring_name);
+            std::vector<uint8_t> own(copy ? frame_bytes : 0);
+            uint64_t last = 0;
+            uint64_t sum = 0;
+            while (running.load(std::memory_order_relaxed)) {
+                auto frame = reader->acquire_latest(last);
+                if (!frame) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                const int64_t received_ns = now_ns();
+                last = frame.info().sequence;
+
+                const uint8_t* pixels = frame.data();
+                if (copy) {
+                    std::memcpy(own.data(), frame.data(), frame.info().size);
+                    pixels = own.data();
+                }
+                // Touch one byte per cache line, as a consumer scanning the
+                // image would.
+                for (size_t i = 0; i < frame.info().size; i += 64) {
+                    sum += pixels[i];
+                }
+                result.latency[c].add_us(
+                    static_cast<double>(received_ns - frame.info().publish_ns) / 1000.0);
+                ++result.consumed[c];
+            }
+            checksum.fetch_add(sum, std::memory_order_relaxed);
+        });
+    }
+
+    // What the ROS message would hold.
+    std::vector<uint8_t> source(frame_bytes);
+    for (size_t i = 0; i < frame_bytes; ++i) {
+        source[i] = static_cast<uint8_t>(i * 7);
+    }
+
+    const auto started = Clock::now();
+    const auto end = started + std::chrono::duration_cast<Clock::duration>(
+                                   std::chrono::duration<double>(seconds));
+    const auto period = rate_hz > 0.0 ? std::chrono::duration_cast<Clock::duration>(
+                                            std::chrono::duration<double>(1.0 / rate_hz)) :
+                                        Clock::duration::zero();
+    auto next = started;
+    while (Clock::now() < end) {
+        if (rate_hz > 0.0) {
+            next += period;
+            sleep_until_deadline(next);
+        }
+        uint8_t* slot = ring->claim(frame_bytes);
+        if (slot == nullptr) {
+            continue;
+        }
+        std::memcpy(slot, source.data(), frame_bytes);
+        FrameRing::FrameInfo info;
+        info.width = width;
+        info.height = height;
+        info.step = width * 3;
+        info.encoding = FrameRing::Encoding::Rgb8;
+        info.stamp_ns = now_ns();
+        info.size = frame_bytes;
+        ring->publish(info);
+    }
+    running = false;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    result.published = ring->published();
+    result.dropped = ring->dropped();
+    result.checksum = checksum.load();
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const auto width = static_cast<uint32_t>(bench::arg_long(argc, argv, "--width", 1280));
+    const auto height = static_cast<uint32_t>(bench::arg_long(argc, argv, "--height", 720));
+    const double seconds = bench::arg_double(argc, argv, "--seconds", 3.0);
+    const auto consumers = static_cast<size_t>(bench::arg_long(argc, argv, "--consumers", 2));
+    const double rate_hz = bench::arg_double(argc, argv, "--rate-hz", 0.0);
+
+    std::printf(
+        "%ux%u rgb8, %zu consumers, %s\n",
+        width,
+        height,
+        consumers,
+        rate_hz > 0.0 ? "fixed rate" : "publisher unthrottled");
+
+    for (const bool copy : {false, true}) {
+        const auto result = run(width, height, seconds, consumers, rate_hz, copy);
+        const char* mode = copy ? "copy" : "in place";
+        std::printf(
+            "%s: published %.0f frames/s, dropped %llu (checksum %llu)\n",
+            mode,
+            static_cast<double>(result.published) / seconds,
+            static_cast<unsigned long long>(result.dropped),
+            static_cast<unsigned long long>(result.checksum));
+        for (size_t c = 0; c < consumers; ++c) {
+            std::printf(
+                "  consumer %zu: %.0f frames/s\n",
+                c,
+                static_cast<double>(result.consumed[c]) / seconds);
+            auto latency = result.latency[c];
+            latency.print(std::string("  consumer ") + std::to_string(c) + " publish->read");
+        }
+    }
+    return 0;
+}
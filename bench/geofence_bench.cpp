@@ -0,0 +1,178 @@
+// Geofence check throughput over large keep-out sets.
+//
+// Builds fences with a 5 km inclusion circle and a growing number of random
+// keep-out polygons, then checks random points with the two PolygonIndex
+// lookups of Geofence::check_local() and with a naive winding-number test over
+// every edge.
+// Reports build time, grid size and checks/s for both, and counts points where
+// the two disagree, which must be none. The last column is how many vehicles
+// the indexed check could serve at --rate-hz position samples each, on one
+// core.
+//
+// Usage: geofence_bench [--polygons 10,100,1000,10000] [--vertices N]
+//                       [--checks N] [--rate-hz HZ]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "bench_util.h"
+#include "geofence.h"
+
+using bench::Clock;
+using Point = PolygonIndex::Point;
+
+namespace {
+
+constexpr double pi = 3.14159265358979323846;
+constexpr float fence_radius_m = 5000.0f;
+
+double seconds_since(Clock::time_point started)
+{
+    return std::chrono::duration<double>(Clock::now() - started).count();
+}
+
+// A star-shaped polygon of `vertices` points around (x, y), in local metres.
+std::vector<Point> random_polygon(std::mt19937& rng, float x, float y, size_t vertices)
+{
+    std::uniform_real_distribution<float> radius(15.0f, 60.0f);
+    std::vector<Point> polygon;
+    for (size_t i = 0; i < vertices; ++i) {
+        const double angle = 2.0 * pi * static_cast<double>(i) / static_cast<double>(vertices);
+        const float r = radius(rng);
+        polygon.push_back(
+            {x + r * static_cast<float>(std::cos(angle)),
+             y + r * static_cast<float>(std::sin(angle))});
+    }
+    return polygon;
+}
+
+// Winding numbers summed over the polygons, visiting every edge.
+int naive_winding(const std::vector<std::vector<Point>>& polygons, Point p)
+{
+    int total = 0;
+    for (const auto& polygon : polygons) {
+        int winding = 0;
+        for (size_t i = 0; i < polygon.size(); ++i) {
+            const Point a = polygon[i];
+            const Point b = polygon[(i + 1) % polygon.size()];
+            const double side = (double{b.x} - a.x) * (double{p.y} - a.y) -
+                                (double{p.x} - a.x) * (double{b.y} - a.y);
+            if (a.y <= p.y && b.y > p.y && side > 0.0) {
+                ++winding;
+            } else if (a.y > p.y && b.y <= p.y && side < 0.0) {
+                --winding;
+            }
+        }
+        total += std::abs(winding);
+    }
+    return total;
+}
+
+// Soaks up results so the loops are not optimized away.
+volatile int sink;
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const auto polygon_counts =
+        bench::parse_list(bench::arg_value(argc, argv, "--polygons", "10,100,1000,10000"));
+    const auto vertices = static_cast<size_t>(bench::arg_long(argc, argv, "--vertices", 32));
+    const auto checks = static_cast<size_t>(bench::arg_long(argc, argv, "--checks", 2'000'000));
+    const double rate_hz = bench::arg_double(argc, argv, "--rate-hz", 100.0);
+
+    std::printf(
+        "%zu-vertex keep-out polygons in a %.0f m inclusion circle, %zu checks\n\n",
+        vertices,
+        fence_radius_m,
+        checks);
+    std::printf(
+        "%8s %9s %10s %9s %9s %12s %12s %10s %12s\n",
+        "polygons",
+        "build ms",
+        "grid",
+        "entries",
+        "max/cell",
+        "index/s",
+        "naive/s",
+        "mismatch",
+        "vehicles");
+
+    for (const long count : polygon_counts) {
+        std::mt19937 rng(static_cast<uint32_t>(count));
+        std::uniform_real_distribution<float> coordinate(-fence_radius_m, fence_radius_m);
+
+        // In local metres, as Geofence indexes them after projecting.
+        std::vector<std::vector<Point>> inclusion{random_polygon(rng, 0.0f, 0.0f, 256)};
+        for (auto& point : inclusion[0]) {
+            const float scale = fence_radius_m / std::hypot(point.x, point.y);
+            point = {point.x * scale, point.y * scale};
+        }
+        std::vector<std::vector<Point>> keep_out;
+        for (long i = 0; i < count; ++i) {
+            keep_out.push_back(random_polygon(rng, coordinate(rng), coordinate(rng), vertices));
+        }
+
+        const auto build_started = Clock::now();
+        const PolygonIndex inclusion_index{inclusion};
+        const PolygonIndex keep_out_index{keep_out};
+        const double build_seconds = seconds_since(build_started);
+        const auto stats = keep_out_index.stats();
+
+        std::vector<Point> points(checks);
+        for (auto& point : points) {
+            point = {coordinate(rng) * 1.05f, coordinate(rng) * 1.05f};
+        }
+
+        // The same two lookups as Geofence::check_local(), without the
+        // altitude compares.
+        int breaches = 0;
+        const auto index_started = Clock::now();
+        for (const auto& point : points) {
+            breaches += !inclusion_index.covers(point.x, point.y) ||
+                        keep_out_index.covers(point.x, point.y);
+        }
+        const double index_seconds = seconds_since(index_started);
+        sink = breaches;
+
+        // The naive test on a subsample; it is linear in the edge count.
+        const size_t naive_checks = std::max<size_t>(
+            1000, checks / std::max<size_t>(1, static_cast<size_t>(count) * vertices / 64));
+        const size_t naive_count = std::min(naive_checks, checks);
+        std::vector<int> naive_inclusion(naive_count);
+        std::vector<int> naive_keep_out(naive_count);
+        const auto naive_started = Clock::now();
+        for (size_t i = 0; i < naive_count; ++i) {
+            naive_inclusion[i] = naive_winding(inclusion, points[i]);
+            naive_keep_out[i] = naive_winding(keep_out, points[i]);
+        }
+        const double naive_seconds = seconds_since(naive_started);
+
+        size_t mismatches = 0;
+        for (size_t i = 0; i < naive_count; ++i) {
+            const Point point = points[i];
+            mismatches += naive_inclusion[i] != inclusion_index.winding(point.x, point.y) ||
+                          naive_keep_out[i] != keep_out_index.winding(point.x, point.y);
+        }
+
+        const double index_rate = static_cast<double>(checks) / index_seconds;
+        const double naive_rate = static_cast<double>(naive_count) / naive_seconds;
+        char grid[24];
+        std::snprintf(grid, sizeof(grid), "%ux%u", stats.columns, stats.rows);
+        std::printf(
+            "%8ld %9.1f %10s %9zu %9zu %12.3g %12.3g %10zu %12.3g\n",
+            count,
+            build_seconds * 1e3,
+            grid,
+            stats.cell_entries,
+            stats.max_cell_entries,
+            index_rate,
+            naive_rate,
+            mismatches,
+            index_rate / rate_hz);
+    }
+    return 0;
+}
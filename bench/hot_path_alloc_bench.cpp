@@ -0,0 +1,106 @@
+// Hot-path allocation check: a full rotate flight under allocation tracking.
+//
+// Starts a mock autopilot and runs rotate_alloc_tracked against it with
+// ROTATE_ALLOC_ABORT=1, so the first heap allocation inside a hot region (a
+// telemetry handler, the setpoint law, a bus publish) aborts the flight with
+// a backtrace. rotate_alloc_tracked prints its allocations per phase and per
+// thread when it lands. The exit code is non-zero if the flight did not land
+// cleanly, which makes this a regression check like command_latency_bench.
+//
+// With --count-only the flight is not aborted, and every hot-region
+// allocation is counted and reported instead. With --fleet N it starts N mock
+// autopilots and flies them with `rotate --fleet N`, whose hot regions are the
+// vehicles' mission steps (apart from the MAVSDK calls they make), their
+// command callbacks and the control thread's ticks. Each vehicle's arena
+// also reports whether it grew after the flight started.
+//
+// Usage: hot_path_alloc_bench [--rotate PATH] [--port PORT] [--time-scale X]
+//                             [--count-only] [--fleet N]
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "bench_util.h"
+#include "mock_autopilot.h"
+
+using bench::Clock;
+
+int main(int argc, char** argv)
+{
+    const auto rotate = bench::arg_value(argc, argv, "--rotate", ROTATE_ALLOC_TRACKED_PATH);
+    const auto port = static_cast<uint16_t>(bench::arg_long(argc, argv, "--port", 14564));
+    const double time_scale = bench::arg_double(argc, argv, "--time-scale", 4.0);
+    const bool count_only = bench::arg_flag(argc, argv, "--count-only");
+    const long fleet = bench::arg_long(argc, argv, "--fleet", 0);
+    if (fleet < 0 || fleet > 255) {
+        std::cerr << "--fleet must be 0..255\n";
+        return 1;
+    }
+
+    std::vector<std::unique_ptr<MockAutopilot>> mocks;
+    for (long i = 0; i < std::max(fleet, 1L); ++i) {
+        MockAutopilot::Options mock_options;
+        mock_options.system_id = static_cast<uint8_t>(i + 1);
+        mock_options.remote_port = port;
+        mock_options.time_scale = time_scale;
+        mocks.push_back(std::make_unique<MockAutopilot>(mock_options));
+        if (!mocks.back()->start()) {
+            std::cerr << "Could not start mock autopilot\n";
+            return 1;
+        }
+    }
+
+    const auto url = "udpin://0.0.0.0:" + std::to_string(port);
+    const auto started = Clock::now();
+    const pid_t pid = fork();
+    if (pid == 0) {
+        setenv("ROTATE_ALLOC_ABORT", count_only ? "0" : "1", 1);
+        if (fleet > 0) {
+            const auto vehicles = std::to_string(fleet);
+            execl(
+                rotate.c_str(),
+                rotate.c_str(),
+                url.c_str(),
+                "--fleet",
+                vehicles.c_str(),
+                static_cast<char*>(nullptr));
+        } else {
+            execl(rotate.c_str(), rotate.c_str(), url.c_str(), static_cast<char*>(nullptr));
+        }
+        std::cerr << "Could not run " << rotate << ": " << std::strerror(errno) << '\n';
+        _exit(127);
+    }
+    if (pid < 0) {
+        std::cerr << "fork failed: " << std::strerror(errno) << '\n';
+        return 1;
+    }
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    for (auto& mock : mocks) {
+        mock->stop();
+    }
+
+    const double seconds = std::chrono::duration<double>(Clock::now() - started).count();
+    if (WIFSIGNALED(status)) {
+        std::cout << "\nFAIL: rotate_alloc_tracked died with signal " << WTERMSIG(status)
+                  << (WTERMSIG(status) == SIGABRT ? " (allocation in a hot region?)" : "")
+                  << " after " << seconds << " s\n";
+        return 1;
+    }
+    const int code = WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+    std::cout << '\n'
+              << (code == 0 ? "PASS" : "FAIL") << ": flight exited with " << code << " after "
+              << seconds << " s\n";
+    return code == 0 ? 0 : 1;
+}
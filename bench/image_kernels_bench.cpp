@@ -0,0 +1,159 @@
+// Camera kernels vs. the OpenCV calls vision.py makes, at 640x480, 1280x720
+// and 1920x1080.
+//
+// Times RGB -> BGR (cv::cvtColor), RGB -> BGR with 2x area downscale (cvtColor
+// followed by cv::resize INTER_AREA, fused into one pass here) and mono 2x
+// downscale, for every instruction set the CPU supports. OpenCV is only
+// measured when the benchmark was built with it; its output is also compared
+// with the kernels'.
+//
+// Usage: image_kernels_bench [--frames N] [--sizes 640x480,1280x720,...]
+
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef ROTATE_HAVE_OPENCV
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+#endif
+
+#include "bench_util.h"
+#include "image_kernels.h"
+
+using bench::Clock;
+using namespace image_kernels;
+
+namespace {
+
+struct Size {
+    uint32_t width;
+    uint32_t height;
+};
+
+std::vector<Size> parse_sizes(const std::string& list)
+{
+    std::vector<Size> sizes;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        const auto x = item.find('x');
+        if (x != std::string::npos) {
+            sizes.push_back(
+                {static_cast<uint32_t>(std::stoul(item.substr(0, x))),
+                 static_cast<uint32_t>(std::stoul(item.substr(x + 1)))});
+        }
+    }
+    return sizes;
+}
+
+// Mean time per call in microseconds.
+double time_us(long frames, const std::function<void()>& fn)
+{
+    fn(); // Warm up caches and page in the buffers.
+    const auto started = Clock::now();
+    for (long i = 0; i < frames; ++i) {
+        fn();
+    }
+    return bench::to_us(Clock::now() - started) / static_cast<double>(frames);
+}
+
+void report(const char* op, const Size& size, const std::string& impl, double us)
+{
+    const double megapixels = static_cast<double>(size.width) * size.height / 1e6;
+    std::printf(
+        "%-22s %5ux%-5u %-8s %10.1f us %10.1f MP/s\n",
+        op,
+        size.width,
+        size.height,
+        impl.c_str(),
+        us,
+        megapixels / (us / 1e6));
+}
+
+std::string isa_name(Isa isa)
+{
+    std::ostringstream str;
+    str << isa;
+    return str.str();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const long frames = bench::arg_long(argc, argv, "--frames", 200);
+    const auto sizes =
+        parse_sizes(bench::arg_value(argc, argv, "--sizes", "640x480,1280x720,1920x1080"));
+
+    std::vector<Isa> isas{Isa::Scalar};
+    if (best_isa() >= Isa::Sse41) {
+        isas.push_back(Isa::Sse41);
+    }
+    if (best_isa() >= Isa::Avx2) {
+        isas.push_back(Isa::Avx2);
+    }
+    std::cout << "Best instruction set: " << best_isa() << '\n';
+
+    for (const auto& size : sizes) {
+        const uint32_t w = size.width;
+        const uint32_t h = size.height;
+        std::vector<uint8_t> rgb(size_t{w} * h * 3);
+        std::vector<uint8_t> mono(size_t{w} * h);
+        for (size_t i = 0; i < rgb.size(); ++i) {
+            rgb[i] = static_cast<uint8_t>(i * 31 + (i >> 11));
+        }
+        for (size_t i = 0; i < mono.size(); ++i) {
+            mono[i] = static_cast<uint8_t>(i * 17 + (i >> 9));
+        }
+        std::vector<uint8_t> out(size_t{w} * h * 3);
+
+        for (const Isa isa : isas) {
+            set_isa(isa);
+            report("rgb->bgr", size, isa_name(isa), time_us(frames, [&]() {
+                       rgb_to_bgr(rgb.data(), w * 3, out.data(), w * 3, w, h);
+                   }));
+            report("rgb->bgr + 2x area", size, isa_name(isa), time_us(frames, [&]() {
+                       downscale2x_rgb(rgb.data(), w * 3, out.data(), w / 2 * 3, w, h, true);
+                   }));
+            report("mono 2x area", size, isa_name(isa), time_us(frames, [&]() {
+                       downscale2x_mono(mono.data(), w, out.data(), w / 2, w, h);
+                   }));
+        }
+        set_isa(best_isa());
+
+#ifdef ROTATE_HAVE_OPENCV
+        const cv::Mat rgb_mat(static_cast<int>(h), static_cast<int>(w), CV_8UC3, rgb.data());
+        const cv::Mat mono_mat(static_cast<int>(h), static_cast<int>(w), CV_8UC1, mono.data());
+        cv::Mat bgr_mat;
+        cv::Mat small_mat;
+        report("rgb->bgr", size, "opencv", time_us(frames, [&]() {
+                   cv::cvtColor(rgb_mat, bgr_mat, cv::COLOR_RGB2BGR);
+               }));
+        report("rgb->bgr + 2x area", size, "opencv", time_us(frames, [&]() {
+                   cv::cvtColor(rgb_mat, bgr_mat, cv::COLOR_RGB2BGR);
+                   cv::resize(bgr_mat, small_mat, cv::Size(), 0.5, 0.5, cv::INTER_AREA);
+               }));
+        report("mono 2x area", size, "opencv", time_us(frames, [&]() {
+                   cv::resize(mono_mat, small_mat, cv::Size(), 0.5, 0.5, cv::INTER_AREA);
+               }));
+
+        // Same pixels as OpenCV? Area averaging may round differently by one.
+        cv::cvtColor(rgb_mat, bgr_mat, cv::COLOR_RGB2BGR);
+        cv::resize(bgr_mat, small_mat, cv::Size(), 0.5, 0.5, cv::INTER_AREA);
+        downscale2x_rgb(rgb.data(), w * 3, out.data(), w / 2 * 3, w, h, true);
+        const cv::Mat ours(
+            static_cast<int>(h / 2), static_cast<int>(w / 2), CV_8UC3, out.data());
+        double max_diff = 0.0;
+        cv::minMaxLoc(cv::abs(small_mat - ours).reshape(1), nullptr, &max_diff);
+        std::printf("  max difference to opencv (rgb->bgr + 2x area): %.0f\n", max_diff);
+#endif
+    }
+
+#ifndef ROTATE_HAVE_OPENCV
+    std::cout << "Built without OpenCV; configure with OpenCV available to compare.\n";
+#endif
+    return 0;
+}
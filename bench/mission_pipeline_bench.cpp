@@ -0,0 +1,235 @@
+// Mission wall time: blocking commands vs. overlapped AsyncAction futures.
+//
+// Flies takeoff -> climb to --altitude -> land on a mock autopilot, --missions
+// times with each variant. Both start by switching to the climb rate profile
+// (four set_rate_* requests) and setting the takeoff altitude. The sequential
+// variant makes every request a blocking call, as rotate used to. The
+// pipelined one sends the rates, the takeoff altitude and arm at once and only
+// waits where the next step needs a result. Reports the wall time per mission
+// and how much of it was spent waiting on commands.
+//
+// Usage: mission_pipeline_bench [--missions N] [--time-scale X] [--altitude M]
+//                               [--port PORT]
+
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+#include <mavsdk/mavsdk.h>
+#include <mavsdk/plugins/action/action.h>
+#include <mavsdk/plugins/telemetry/telemetry.h>
+
+#include "async_action.h"
+#include "bench_util.h"
+#include "mock_autopilot.h"
+#include "rate_profile.h"
+
+using namespace mavsdk;
+using bench::Clock;
+
+namespace {
+
+// Altitude and in-air state from the subscriptions, for waiting on them.
+class Flight {
+public:
+    explicit Flight(Telemetry& telemetry) : _telemetry(telemetry)
+    {
+        _position_handle = telemetry.subscribe_position([this](Telemetry::Position position) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _altitude_m = position.relative_altitude_m;
+            _cv.notify_all();
+        });
+        _in_air_handle = telemetry.subscribe_in_air([this](bool in_air) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _in_air = in_air;
+            _cv.notify_all();
+        });
+    }
+
+    ~Flight()
+    {
+        _telemetry.unsubscribe_position(_position_handle);
+        _telemetry.unsubscribe_in_air(_in_air_handle);
+    }
+
+    bool wait_altitude(float altitude_m)
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        return _cv.wait_for(lock, timeout, [&]() { return _altitude_m >= altitude_m; });
+    }
+
+    bool wait_landed()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        return _cv.wait_for(lock, timeout, [&]() { return !_in_air; });
+    }
+
+private:
+    static constexpr std::chrono::seconds timeout{30};
+
+    Telemetry& _telemetry;
+    Telemetry::PositionHandle _position_handle{};
+    Telemetry::InAirHandle _in_air_handle{};
+
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    float _altitude_m{0.0f};
+    bool _in_air{false};
+};
+
+struct Variant {
+    bench::LatencyStats mission;
+    bench::LatencyStats commands;
+    long failures{0};
+};
+
+// Times the calls made through it.
+class CommandTimer {
+public:
+    template<typename Fn> auto operator()(Fn&& fn)
+    {
+        const auto before = Clock::now();
+        auto result = fn();
+        _waited += Clock::now() - before;
+        return result;
+    }
+
+    Clock::duration waited() const { return _waited; }
+
+private:
+    Clock::duration _waited{};
+};
+
+// One blocking set_rate_* call at a time.
+void set_rates(Telemetry& telemetry, const RateProfile& profile)
+{
+    telemetry.set_rate_position(profile.position_hz);
+    telemetry.set_rate_attitude_euler(profile.attitude_hz);
+    telemetry.set_rate_velocity_ned(profile.velocity_ned_hz);
+    telemetry.set_rate_in_air(profile.in_air_hz);
+}
+
+bool fly_sequential(
+    Telemetry& telemetry, Action& action, Flight& flight, float altitude_m, CommandTimer& timed)
+{
+    timed([&]() {
+        set_rates(telemetry, rate_profiles::climb);
+        return true;
+    });
+    timed([&]() { return action.set_takeoff_altitude(altitude_m); });
+    if (timed([&]() { return action.arm(); }) != Action::Result::Success ||
+        timed([&]() { return action.takeoff(); }) != Action::Result::Success) {
+        return false;
+    }
+    if (!flight.wait_altitude(altitude_m * 0.95f)) {
+        return false;
+    }
+    return timed([&]() { return action.land(); }) == Action::Result::Success &&
+           flight.wait_landed();
+}
+
+bool fly_pipelined(
+    Telemetry& telemetry,
+    AsyncAction& action,
+    Flight& flight,
+    float altitude_m,
+    CommandTimer& timed)
+{
+    // A new switcher has no current profile, so it sends all four rates.
+    RateSwitcher rates{telemetry};
+    rates.apply(rate_profiles::climb);
+    auto takeoff_altitude = action.set_takeoff_altitude(altitude_m);
+    auto armed = action.arm();
+    if (timed([&]() { return wait_all(takeoff_altitude, armed); }) != Action::Result::Success ||
+        timed([&]() { return action.takeoff().get(); }) != Action::Result::Success) {
+        return false;
+    }
+    // The rate requests have long been answered by now.
+    if (!flight.wait_altitude(altitude_m * 0.95f)) {
+        return false;
+    }
+    return timed([&]() { return action.land().get(); }) == Action::Result::Success &&
+           flight.wait_landed();
+}
+
+void report(const char* name, Variant& variant)
+{
+    std::printf("%s: %ld failed missions\n", name, variant.failures);
+    variant.mission.print("  mission wall time");
+    variant.commands.print("  waiting on commands");
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const long missions = bench::arg_long(argc, argv, "--missions", 10);
+    const double time_scale = bench::arg_double(argc, argv, "--time-scale", 10.0);
+    const auto altitude_m = static_cast<float>(bench::arg_double(argc, argv, "--altitude", 2.0));
+    const auto port = static_cast<uint16_t>(bench::arg_long(argc, argv, "--port", 14562));
+
+    MockAutopilot::Options mock_options;
+    mock_options.remote_port = port;
+    mock_options.time_scale = time_scale;
+    MockAutopilot mock{mock_options};
+    if (!mock.start()) {
+        std::cerr << "Could not start mock autopilot\n";
+        return 1;
+    }
+
+    Mavsdk mavsdk{Mavsdk::Configuration{ComponentType::GroundStation}};
+    if (mavsdk.add_any_connection("udpin://0.0.0.0:" + std::to_string(port)) !=
+        ConnectionResult::Success) {
+        std::cerr << "Connection failed\n";
+        return 1;
+    }
+    auto system = mavsdk.first_autopilot(5.0);
+    if (!system) {
+        std::cerr << "Timed out waiting for mock autopilot\n";
+        return 1;
+    }
+    Telemetry telemetry{system.value()};
+    Action action{system.value()};
+    AsyncAction async_action{action};
+    Flight flight{telemetry};
+
+    while (!telemetry.health_all_ok()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    Variant sequential;
+    Variant pipelined;
+    for (long i = 0; i < missions; ++i) {
+        for (auto* variant : {&sequential, &pipelined}) {
+            set_rates(telemetry, rate_profiles::idle);
+
+            CommandTimer timed;
+            const auto started = Clock::now();
+            const bool ok = variant == &pipelined
+                                ? fly_pipelined(telemetry, async_action, flight, altitude_m, timed)
+                                : fly_sequential(telemetry, action, flight, altitude_m, timed);
+            if (!ok) {
+                ++variant->failures;
+                continue;
+            }
+            variant->mission.add(Clock::now() - started);
+            variant->commands.add(timed.waited());
+        }
+    }
+
+    std::printf(
+        "%ld missions per variant to %.1f m, mock at %.0fx real time\n",
+        missions,
+        altitude_m,
+        time_scale);
+    report("sequential", sequential);
+    report("pipelined", pipelined);
+    if (sequential.mission.count() > 0 && pipelined.mission.count() > 0) {
+        std::printf(
+            "\nmission wall time p50: %.1f ms sequential, %.1f ms pipelined\n",
+            sequential.mission.percentile_us(0.5) / 1000.0,
+            pipelined.mission.percentile_us(0.5) / 1000.0);
+    }
+    return sequential.failures + pipelined.failures == 0 ? 0 : 1;
+}
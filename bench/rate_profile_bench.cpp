@@ -0,0 +1,140 @@
+// MAVLink bandwidth of each telemetry rate profile against a mock autopilot.
+//
+// First measures the link with the mock's default stream rates plus the old
+// hard-coded set_rate_position(5.0). Then it switches through the rate profiles
+// and measures each one. For every profile it reports the bytes/s the
+// autopilot sends and the saving against that baseline. It also reports how
+// long the switch took with the batched async requests vs. the same requests
+// made one blocking set_rate_* call at a time.
+//
+// Usage: rate_profile_bench [--seconds S] [--port PORT]
+
+#include <iostream>
+#include <thread>
+
+#include <mavsdk/mavsdk.h>
+#include <mavsdk/plugins/telemetry/telemetry.h>
+
+#include "bench_util.h"
+#include "mock_autopilot.h"
+#include "rate_profile.h"
+
+using namespace mavsdk;
+using bench::Clock;
+
+namespace {
+
+struct Bandwidth {
+    double bytes_per_s{0.0};
+    double messages_per_s{0.0};
+};
+
+Bandwidth measure(const MockAutopilot& mock, double seconds)
+{
+    // Let streams whose rate just changed settle on their new interval.
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    const auto before = mock.stats();
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    const auto after = mock.stats();
+    return {
+        static_cast<double>(after.bytes_sent - before.bytes_sent) / seconds,
+        static_cast<double>(after.messages_sent - before.messages_sent) / seconds};
+}
+
+double sequential_switch_ms(Telemetry& telemetry, const RateProfile& profile)
+{
+    const auto started = Clock::now();
+    telemetry.set_rate_position(profile.position_hz);
+    telemetry.set_rate_attitude_euler(profile.attitude_hz);
+    telemetry.set_rate_velocity_ned(profile.velocity_ned_hz);
+    telemetry.set_rate_in_air(profile.in_air_hz);
+    return bench::to_us(Clock::now() - started) / 1000.0;
+}
+
+void print_row(
+    const char* name, const Bandwidth& bandwidth, double baseline_bytes_per_s, size_t requests)
+{
+    std::printf(
+        "%-17s %10.0f %8.0f %7.1f%% %9zu",
+        name,
+        bandwidth.bytes_per_s,
+        bandwidth.messages_per_s,
+        100.0 * (1.0 - bandwidth.bytes_per_s / baseline_bytes_per_s),
+        requests);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const double seconds = bench::arg_double(argc, argv, "--seconds", 3.0);
+    const auto port = static_cast<uint16_t>(bench::arg_long(argc, argv, "--port", 14562));
+
+    MockAutopilot::Options mock_options;
+    mock_options.remote_port = port;
+    MockAutopilot mock{mock_options};
+    if (!mock.start()) {
+        std::cerr << "Could not start mock autopilot\n";
+        return 1;
+    }
+
+    Mavsdk mavsdk{Mavsdk::Configuration{ComponentType::GroundStation}};
+    if (mavsdk.add_any_connection("udpin://0.0.0.0:" + std::to_string(port)) !=
+        ConnectionResult::Success) {
+        std::cerr << "Connection failed\n";
+        return 1;
+    }
+    auto system = mavsdk.first_autopilot(5.0);
+    if (!system) {
+        std::cerr << "Timed out waiting for mock autopilot\n";
+        return 1;
+    }
+    Telemetry telemetry{system.value()};
+
+    // What rotate used to do: default rates, position at 5 Hz.
+    if (telemetry.set_rate_position(5.0) != Telemetry::Result::Success) {
+        std::cerr << "Setting the baseline rate failed\n";
+        return 1;
+    }
+    const auto baseline = measure(mock, seconds);
+
+    std::printf(
+        "%-17s %10s %8s %8s %9s %11s %14s\n",
+        "profile",
+        "bytes/s",
+        "msgs/s",
+        "saved",
+        "requests",
+        "batched ms",
+        "sequential ms");
+    print_row("fixed (baseline)", baseline, baseline.bytes_per_s, 1);
+    std::printf("\n");
+
+    const RateProfile profiles[] = {
+        rate_profiles::idle,
+        rate_profiles::climb,
+        rate_profiles::offboard_control,
+        rate_profiles::landing};
+
+    RateSwitcher switcher{telemetry};
+    for (const auto& profile : profiles) {
+        const auto started = Clock::now();
+        const size_t requests = switcher.apply(profile);
+        if (!switcher.wait(std::chrono::seconds(5))) {
+            std::cerr << "Switching to " << profile.name << " timed out\n";
+            return 1;
+        }
+        const double batched_ms = bench::to_us(Clock::now() - started) / 1000.0;
+        const auto bandwidth = measure(mock, seconds);
+        const double sequential_ms = sequential_switch_ms(telemetry, profile);
+
+        print_row(profile.name, bandwidth, baseline.bytes_per_s, requests);
+        std::printf(" %11.2f %14.2f\n", batched_ms, sequential_ms);
+    }
+
+    if (switcher.failures() > 0) {
+        std::cerr << switcher.failures() << " rate requests failed\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,290 @@
+// Phase-transition latency: sleep_for polling loop vs. MissionSequencer.
+//
+// A feed thread plays the role of the autopilot and publishes a climbing
+// altitude at a fixed telemetry rate. For every trial we record the instant the
+// first sample above the climb threshold is published and the instant the
+// mission notices it and moves on to the next phase.
+//
+// With `--mock` the altitude comes from a mock autopilot over MAVLink instead:
+// every trial is a takeoff, watched by both variants at once. The baseline
+// polls Telemetry::position() as rotate once did, the sequencer is fed by
+// subscribe_position(), and the crossing is the first position callback above
+// the threshold. --rate-hz is then the position rate asked of the mock, in
+// simulated time.
+//
+// Usage: sequencer_bench [--trials N] [--poll-ms MS] [--rate-hz HZ]
+//                        [--mock] [--port PORT] [--time-scale X]
+
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+
+#include "bench_util.h"
+#include "mission_sequencer.h"
+
+#ifdef ROTATE_HAVE_MOCK_AUTOPILOT
+#include <mavsdk/mavsdk.h>
+#include <mavsdk/plugins/action/action.h>
+#include <mavsdk/plugins/telemetry/telemetry.h>
+
+#include "mock_autopilot.h"
+#endif
+
+using bench::Clock;
+
+namespace {
+
+constexpr float climb_threshold_m = 1.7f;
+constexpr float climb_step_m = 0.05f;
+
+// Publishes an altitude ramp at `rate_hz`, starting after a random offset so the
+// threshold crossing is uncorrelated with the polling period.
+template<typename Publish>
+void run_feed(
+    double rate_hz,
+    Clock::duration start_offset,
+    const std::atomic<bool>& done,
+    Clock::time_point& crossed_at,
+    Publish&& publish)
+{
+    const auto period = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(1.0 / rate_hz));
+
+    auto next = Clock::now() + start_offset;
+    float altitude_m = 0.0f;
+    bool crossed = false;
+
+    while (!done.load(std::memory_order_relaxed)) {
+        std::this_thread::sleep_until(next);
+        next += period;
+
+        altitude_m += climb_step_m;
+        if (!crossed && altitude_m >= climb_threshold_m) {
+            crossed_at = Clock::now();
+            crossed = true;
+        }
+        publish(altitude_m);
+    }
+}
+
+#ifdef ROTATE_HAVE_MOCK_AUTOPILOT
+// Climbs well past the threshold, so both variants see it before landing.
+constexpr float mock_takeoff_altitude_m = 2.5f;
+
+int run_mock(long trials, std::chrono::milliseconds poll, double rate_hz, int argc, char** argv)
+{
+    using namespace mavsdk;
+
+    MockAutopilot::Options mock_options;
+    const auto port = static_cast<uint16_t>(bench::arg_long(argc, argv, "--port", 14565));
+    mock_options.remote_port = port;
+    mock_options.time_scale = bench::arg_double(argc, argv, "--time-scale", 5.0);
+    MockAutopilot mock{mock_options};
+    if (!mock.start()) {
+        std::cerr << "Could not start mock autopilot\n";
+        return 1;
+    }
+
+    Mavsdk mavsdk{Mavsdk::Configuration{ComponentType::GroundStation}};
+    if (mavsdk.add_any_connection("udpin://0.0.0.0:" + std::to_string(port)) !=
+        ConnectionResult::Success) {
+        std::cerr << "Connection failed\n";
+        return 1;
+    }
+    auto system = mavsdk.first_autopilot(5.0);
+    if (!system) {
+        std::cerr << "Timed out waiting for mock autopilot\n";
+        return 1;
+    }
+    Telemetry telemetry{system.value()};
+    Action action{system.value()};
+    if (telemetry.set_rate_position(rate_hz) != Telemetry::Result::Success ||
+        action.set_takeoff_altitude(mock_takeoff_altitude_m) != Action::Result::Success) {
+        std::cerr << "Setting up the mock autopilot failed\n";
+        return 1;
+    }
+
+    bench::LatencyStats polling;
+    bench::LatencyStats event_driven;
+
+    for (long trial = 0; trial < trials; ++trial) {
+        MissionSequencer sequencer;
+        bool crossed = false;
+        Clock::time_point crossed_at{};
+        Clock::time_point observed_at{};
+        Clock::time_point polled_at{};
+
+        const auto started = Clock::now();
+        auto& climb = sequencer.add_phase("climb");
+        climb.done = [](const FlightState& state) {
+            return state.relative_altitude_m >= climb_threshold_m;
+        };
+        climb.deadline = [started]() { return started + std::chrono::seconds(30); };
+        sequencer.add_phase("observed").enter = [&]() {
+            observed_at = Clock::now();
+            return true;
+        };
+
+        // MAVSDK calls this on one thread, before or after updating what
+        // position() returns; the polling latency is clamped at 0 for that.
+        auto handle = telemetry.subscribe_position([&](Telemetry::Position position) {
+            if (!crossed && position.relative_altitude_m >= climb_threshold_m) {
+                crossed_at = Clock::now();
+                crossed = true;
+            }
+            sequencer.update([&](FlightState& state) {
+                state.relative_altitude_m = position.relative_altitude_m;
+            });
+        });
+
+        if (action.arm() != Action::Result::Success ||
+            action.takeoff() != Action::Result::Success) {
+            telemetry.unsubscribe_position(handle);
+            std::cerr << "Trial " << trial << ": arming or takeoff failed\n";
+            return 1;
+        }
+
+        std::thread poller([&]() {
+            while (Clock::now() - started < std::chrono::seconds(30) &&
+                   telemetry.position().relative_altitude_m < climb_threshold_m) {
+                std::this_thread::sleep_for(poll);
+            }
+            polled_at = Clock::now();
+        });
+        const auto result = sequencer.run();
+        poller.join();
+        telemetry.unsubscribe_position(handle);
+
+        if (result != MissionSequencer::Result::Success) {
+            std::cerr << "Trial " << trial << ": the climb was not seen (" << result << ")\n";
+            return 1;
+        }
+        polling.add(std::max(polled_at - crossed_at, Clock::duration::zero()));
+        event_driven.add(observed_at - crossed_at);
+
+        if (action.land() != Action::Result::Success) {
+            std::cerr << "Trial " << trial << ": land failed\n";
+            return 1;
+        }
+        const auto landing = Clock::now();
+        while (telemetry.in_air()) {
+            if (Clock::now() - landing > std::chrono::seconds(30)) {
+                std::cerr << "Trial " << trial << ": the mock did not land\n";
+                return 1;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+    }
+
+    std::printf(
+        "phase-transition latency on a mock autopilot, %ld trials, position %.0f Hz, "
+        "poll period %lld ms\n",
+        trials,
+        rate_hz,
+        static_cast<long long>(poll.count()));
+    polling.print("Telemetry::position() polling");
+    event_driven.print("event-driven sequencer");
+    return 0;
+}
+#endif
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const long trials = bench::arg_long(argc, argv, "--trials", 10);
+    const auto poll = std::chrono::milliseconds(bench::arg_long(argc, argv, "--poll-ms", 1000));
+    const double rate_hz = bench::arg_double(argc, argv, "--rate-hz", 50.0);
+
+    if (bench::arg_flag(argc, argv, "--mock")) {
+#ifdef ROTATE_HAVE_MOCK_AUTOPILOT
+        return run_mock(trials, poll, rate_hz, argc, argv);
+#else
+        std::cerr << "Built without the mock autopilot\n";
+        return 1;
+#endif
+    }
+
+    std::mt19937 rng{42};
+    std::uniform_int_distribution<long> offset_ms(0, poll.count());
+
+    bench::LatencyStats polling;
+    bench::LatencyStats event_driven;
+
+    for (long trial = 0; trial < trials; ++trial) {
+        const auto offset = std::chrono::milliseconds(offset_ms(rng));
+
+        // Baseline: the original rotate.cpp loop polling a mutex-protected
+        // snapshot (what telemetry.position() amounts to) once per period.
+        {
+            std::mutex mutex;
+            float latest_altitude_m = 0.0f;
+            std::atomic<bool> done{false};
+            Clock::time_point crossed_at{};
+
+            std::thread feed([&]() {
+                run_feed(rate_hz, offset, done, crossed_at, [&](float altitude_m) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    latest_altitude_m = altitude_m;
+                });
+            });
+
+            while (true) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (latest_altitude_m >= climb_threshold_m) {
+                        break;
+                    }
+                }
+                std::this_thread::sleep_for(poll);
+            }
+            const auto observed_at = Clock::now();
+
+            done = true;
+            feed.join();
+            polling.add(observed_at - crossed_at);
+        }
+
+        // Event-driven: the feed drives MissionSequencer::update().
+        {
+            MissionSequencer sequencer;
+            std::atomic<bool> done{false};
+            Clock::time_point crossed_at{};
+            Clock::time_point observed_at{};
+
+            sequencer.add_phase("climb").done = [](const FlightState& state) {
+                return state.relative_altitude_m >= climb_threshold_m;
+            };
+            sequencer.add_phase("observed").enter = [&]() {
+                observed_at = Clock::now();
+                return true;
+            };
+
+            std::thread feed([&]() {
+                run_feed(rate_hz, offset, done, crossed_at, [&](float altitude_m) {
+                    sequencer.update(
+                        [&](FlightState& state) { state.relative_altitude_m = altitude_m; });
+                });
+            });
+
+            sequencer.run();
+
+            done = true;
+            feed.join();
+            event_driven.add(observed_at - crossed_at);
+        }
+    }
+
+    std::printf(
+        "phase-transition latency, %ld trials, telemetry %.0f Hz, poll period %lld ms\n",
+        trials,
+        rate_hz,
+        static_cast<long long>(poll.count()));
+    polling.print("sleep_for polling");
+    event_driven.print("event-driven sequencer");
+    return 0;
+}
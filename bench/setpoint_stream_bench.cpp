@@ -0,0 +1,244 @@
+// Setpoint stream timing under CPU load: sleep_for loop vs. SetpointStreamer.
+//
+// Both variants send to a sink that only counts, so what is measured is the
+// scheduling of the stream itself. `--stress N` starts N busy threads to
+// compete for the cores. The streamer runs twice: with the default scheduling,
+// then in real-time mode pinned to `--rt-cpu` with SCHED_FIFO `--rt-priority`
+// and, unless `--lock-memory 0`, locked memory. Real-time steps that are not
+// permitted are reported and skipped, so run with CAP_SYS_NICE (or as root) to
+// compare.
+//
+// With `--mock` every variant sends its setpoints with Offboard::set_velocity_ned
+// to a mock autopilot instead, and the count that arrived there is reported
+// too.
+//
+// Usage: setpoint_stream_bench [--rate-hz HZ] [--seconds S] [--stress N]
+//                              [--rt-cpu CPU] [--rt-priority P] [--lock-memory 0|1]
+//                              [--mock] [--port PORT]
+
+#include <atomic>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench_util.h"
+#include "setpoint_streamer.h"
+
+#ifdef ROTATE_HAVE_MOCK_AUTOPILOT
+#include <mavsdk/mavsdk.h>
+#include <mavsdk/plugins/offboard/offboard.h>
+
+#include "mock_autopilot.h"
+#endif
+
+using bench::Clock;
+
+namespace {
+
+// Where the setpoints go: only counted, or with --mock sent to a mock
+// autopilot, which counts what arrives.
+struct Sink {
+    SetpointStreamer::Sink send;
+    // Setpoints that arrived so far; empty without a mock.
+    std::function<uint64_t()> arrived;
+};
+
+void print_arrived(const Sink& sink, uint64_t arrived_before, uint64_t sent)
+{
+    if (!sink.arrived) {
+        return;
+    }
+    // Leave the last datagrams time to arrive.
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    std::printf(
+        "  arrived at the mock: %llu of %llu\n",
+        static_cast<unsigned long long>(sink.arrived() - arrived_before),
+        static_cast<unsigned long long>(sent));
+}
+
+// PX4 treats offboard as lost when setpoints arrive slower than 2 Hz.
+constexpr double px4_offboard_min_gap_us = 500000.0;
+
+void print_gap_verdict(double max_gap_us)
+{
+    std::printf(
+        "  max gap %.1f us (%s PX4's %.0f us offboard limit)\n",
+        max_gap_us,
+        max_gap_us < px4_offboard_min_gap_us ? "within" : "EXCEEDS",
+        px4_offboard_min_gap_us);
+}
+
+void run_streamer(
+    const char* label,
+    double rate_hz,
+    std::chrono::duration<double> duration,
+    const RealtimeOptions& realtime,
+    const Sink& sink)
+{
+    const uint64_t arrived_before = sink.arrived ? sink.arrived() : 0;
+    SetpointStreamer streamer{
+        rate_hz,
+        [](Clock::time_point) { return Setpoint::from_velocity({0.0f, 0.0f, -0.5f, 0.0f}); },
+        sink.send};
+    streamer.set_realtime(realtime);
+
+    streamer.start();
+    std::this_thread::sleep_for(duration);
+    streamer.stop();
+
+    const auto stats = streamer.stats();
+    std::printf(
+        "%s: sent %llu (%.1f Hz achieved), missed deadlines %llu\n",
+        label,
+        static_cast<unsigned long long>(stats.sent),
+        static_cast<double>(stats.sent) / duration.count(),
+        static_cast<unsigned long long>(stats.missed_deadlines));
+    if (realtime.enabled()) {
+        std::ostringstream status;
+        status << streamer.realtime_status();
+        std::printf("  %s\n", status.str().c_str());
+    }
+    std::printf(
+        "  wakeup lateness mean %.1f us, max %.1f us\n", stats.mean_jitter_us, stats.max_jitter_us);
+    print_gap_verdict(stats.max_gap_us);
+
+    std::printf("  lateness histogram:");
+    for (size_t i = 0; i < stats.jitter_histogram.size(); ++i) {
+        if (i < SetpointStreamer::jitter_bucket_us.size()) {
+            std::printf(" <=%uus:", SetpointStreamer::jitter_bucket_us[i]);
+        } else {
+            std::printf(" more:");
+        }
+        std::printf("%llu", static_cast<unsigned long long>(stats.jitter_histogram[i]));
+    }
+    std::printf("\n");
+    print_arrived(sink, arrived_before, stats.sent);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const double rate_hz = bench::arg_double(argc, argv, "--rate-hz", 100.0);
+    const auto duration =
+        std::chrono::duration<double>(bench::arg_double(argc, argv, "--seconds", 5.0));
+    const long stress_threads = bench::arg_long(argc, argv, "--stress", 0);
+
+    RealtimeOptions realtime;
+    realtime.cpu = static_cast<int>(bench::arg_long(argc, argv, "--rt-cpu", 0));
+    realtime.fifo_priority = static_cast<int>(bench::arg_long(argc, argv, "--rt-priority", 80));
+    realtime.lock_memory = bench::arg_long(argc, argv, "--lock-memory", 1) != 0;
+
+    std::atomic<uint64_t> counted{0};
+    Sink sink;
+    sink.send = [&counted](const Setpoint&) {
+        counted.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    };
+#ifdef ROTATE_HAVE_MOCK_AUTOPILOT
+    std::unique_ptr<MockAutopilot> mock;
+    std::unique_ptr<mavsdk::Mavsdk> mavsdk;
+    std::unique_ptr<mavsdk::Offboard> offboard;
+    if (bench::arg_flag(argc, argv, "--mock")) {
+        MockAutopilot::Options mock_options;
+        mock_options.remote_port =
+            static_cast<uint16_t>(bench::arg_long(argc, argv, "--port", 14566));
+        mock = std::make_unique<MockAutopilot>(mock_options);
+        if (!mock->start()) {
+            std::cerr << "Could not start mock autopilot\n";
+            return 1;
+        }
+        mavsdk = std::make_unique<mavsdk::Mavsdk>(
+            mavsdk::Mavsdk::Configuration{mavsdk::ComponentType::GroundStation});
+        if (mavsdk->add_any_connection(
+                "udpin://0.0.0.0:" + std::to_string(mock_options.remote_port)) !=
+            mavsdk::ConnectionResult::Success) {
+            std::cerr << "Connection failed\n";
+            return 1;
+        }
+        auto system = mavsdk->first_autopilot(5.0);
+        if (!system) {
+            std::cerr << "Timed out waiting for mock autopilot\n";
+            return 1;
+        }
+        offboard = std::make_unique<mavsdk::Offboard>(system.value());
+        sink.send = [&offboard](const Setpoint& setpoint) {
+            return offboard->set_velocity_ned(setpoint.velocity) ==
+                   mavsdk::Offboard::Result::Success;
+        };
+        sink.arrived = [&mock]() { return mock->stats().setpoints_received; };
+    }
+#else
+    if (bench::arg_flag(argc, argv, "--mock")) {
+        std::cerr << "Built without the mock autopilot\n";
+        return 1;
+    }
+#endif
+
+    std::atomic<bool> stressing{true};
+    std::vector<std::thread> stress;
+    for (long i = 0; i < stress_threads; ++i) {
+        stress.emplace_back([&]() {
+            volatile uint64_t spin = 0;
+            while (stressing.load(std::memory_order_relaxed)) {
+                spin = spin + 1;
+            }
+        });
+    }
+
+    const auto period = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(1.0 / rate_hz));
+
+    std::printf(
+        "setpoint stream at %.0f Hz for %.1f s with %ld stress threads%s\n",
+        rate_hz,
+        duration.count(),
+        stress_threads,
+        sink.arrived ? ", to a mock autopilot" : "");
+
+    // Baseline: sleep_for(period) after every send. Lateness accumulates, so
+    // we measure the interval error between consecutive sends.
+    {
+        bench::LatencyStats interval_error;
+        double max_gap_us = 0.0;
+        uint64_t sent = 0;
+        const uint64_t arrived_before = sink.arrived ? sink.arrived() : 0;
+        const auto setpoint = Setpoint::from_velocity({0.0f, 0.0f, -0.5f, 0.0f});
+
+        const auto end = Clock::now() + duration;
+        auto last = Clock::now();
+        while (last < end) {
+            std::this_thread::sleep_for(period);
+            const auto now = Clock::now();
+            const double gap_us = bench::to_us(now - last);
+            interval_error.add_us(gap_us - bench::to_us(period));
+            max_gap_us = std::max(max_gap_us, gap_us);
+            last = now;
+            sink.send(setpoint);
+            ++sent;
+        }
+
+        std::printf(
+            "sleep_for loop: sent %llu (%.1f Hz achieved)\n",
+            static_cast<unsigned long long>(sent),
+            static_cast<double>(sent) / duration.count());
+        interval_error.print("  interval error");
+        print_gap_verdict(max_gap_us);
+        print_arrived(sink, arrived_before, sent);
+    }
+
+    // Deadline-scheduled streamer, with the default scheduling and then in
+    // real-time mode.
+    run_streamer("SetpointStreamer", rate_hz, duration, RealtimeOptions{}, sink);
+    run_streamer("SetpointStreamer, real-time", rate_hz, duration, realtime, sink);
+
+    stressing = false;
+    for (auto& thread : stress) {
+        thread.join();
+    }
+    return 0;
+}
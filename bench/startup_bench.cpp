@@ -0,0 +1,168 @@
+// Startup time: from creating Mavsdk to an armable vehicle, against a mock
+// autopilot.
+//
+// Each run starts a fresh mock, whose sensors report healthy --health-delay
+// seconds after it starts, and connects a fresh Mavsdk to it. The serial
+// variant is rotate's original startup: first_autopilot(5.0), the plugins one
+// after another, then health_all_ok() polled once a second. The fast variant
+// is first_autopilot(5.0), make_plugins() and a HealthGate on
+// subscribe_health that wakes on the sample completing it. Reports when the
+// system was found, the plugins were ready and the vehicle was armable.
+//
+// Usage: startup_bench [--runs N] [--health-delay S] [--port PORT]
+
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <thread>
+
+#include <mavsdk/mavsdk.h>
+#include <mavsdk/plugins/action/action.h>
+#include <mavsdk/plugins/offboard/offboard.h>
+#include <mavsdk/plugins/telemetry/telemetry.h>
+
+#include "bench_util.h"
+#include "fast_start.h"
+#include "health_gate.h"
+#include "mock_autopilot.h"
+
+using namespace mavsdk;
+using bench::Clock;
+
+namespace {
+
+struct Variant {
+    bench::LatencyStats discovery;
+    bench::LatencyStats plugins;
+    bench::LatencyStats armable;
+    long failures{0};
+};
+
+struct Times {
+    Clock::duration discovery{};
+    Clock::duration plugins{};
+    Clock::duration armable{};
+};
+
+bool run_serial(Mavsdk& mavsdk, Clock::time_point started, Times& times)
+{
+    auto system = mavsdk.first_autopilot(5.0);
+    if (!system) {
+        return false;
+    }
+    times.discovery = Clock::now() - started;
+
+    Telemetry telemetry{system.value()};
+    Action action{system.value()};
+    Offboard offboard{system.value()};
+    times.plugins = Clock::now() - started;
+
+    const auto give_up = started + std::chrono::seconds(30);
+    while (!telemetry.health_all_ok()) {
+        if (Clock::now() > give_up) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+    }
+    times.armable = Clock::now() - started;
+    return true;
+}
+
+bool run_fast(Mavsdk& mavsdk, Clock::time_point started, Times& times)
+{
+    const auto system = mavsdk.first_autopilot(5.0);
+    if (!system) {
+        return false;
+    }
+    times.discovery = Clock::now() - started;
+
+    const AutopilotPlugins plugins = make_plugins(*system);
+    times.plugins = Clock::now() - started;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    const HealthGate gate;
+    bool ready = false;
+    auto handle = plugins.telemetry->subscribe_health([&](Telemetry::Health health) {
+        if (gate.ready(HealthGate::bits(health))) {
+            std::lock_guard<std::mutex> lock(mutex);
+            ready = true;
+            cv.notify_all();
+        }
+    });
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait_for(lock, std::chrono::seconds(30), [&ready]() { return ready; });
+    }
+    plugins.telemetry->unsubscribe_health(handle);
+    if (!ready) {
+        return false;
+    }
+    times.armable = Clock::now() - started;
+    return true;
+}
+
+void report(const char* name, Variant& variant)
+{
+    std::printf("%s: %ld failed runs\n", name, variant.failures);
+    variant.discovery.print("  system found");
+    variant.plugins.print("  plugins ready");
+    variant.armable.print("  armable");
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const long runs = bench::arg_long(argc, argv, "--runs", 10);
+    const double health_delay_s = bench::arg_double(argc, argv, "--health-delay", 0.3);
+    const auto base_port = static_cast<uint16_t>(bench::arg_long(argc, argv, "--port", 14570));
+
+    Variant serial;
+    Variant fast;
+    for (long run = 0; run < runs; ++run) {
+        for (auto* variant : {&serial, &fast}) {
+            // A fresh port each time, so no datagrams from the last run arrive.
+            const auto port = static_cast<uint16_t>(
+                base_port + 2 * run + (variant == &fast ? 1 : 0));
+            MockAutopilot::Options mock_options;
+            mock_options.remote_port = port;
+            mock_options.health_delay_s = health_delay_s;
+            MockAutopilot mock{mock_options};
+            if (!mock.start()) {
+                std::cerr << "Could not start mock autopilot\n";
+                return 1;
+            }
+
+            const auto started = Clock::now();
+            Mavsdk mavsdk{Mavsdk::Configuration{ComponentType::GroundStation}};
+            if (mavsdk.add_any_connection("udpin://0.0.0.0:" + std::to_string(port)) !=
+                ConnectionResult::Success) {
+                std::cerr << "Connection failed\n";
+                return 1;
+            }
+
+            Times times;
+            const bool ok = variant == &fast ? run_fast(mavsdk, started, times)
+                                             : run_serial(mavsdk, started, times);
+            if (!ok) {
+                ++variant->failures;
+                continue;
+            }
+            variant->discovery.add(times.discovery);
+            variant->plugins.add(times.plugins);
+            variant->armable.add(times.armable);
+        }
+    }
+
+    std::printf("%ld runs, sensors healthy %.2f s after the mock starts\n", runs, health_delay_s);
+    report("serial", serial);
+    report("fast", fast);
+    if (serial.armable.count() > 0 && fast.armable.count() > 0) {
+        std::printf(
+            "\ntime to armable p50: %.1f ms serial, %.1f ms fast\n",
+            serial.armable.percentile_us(0.5) / 1000.0,
+            fast.armable.percentile_us(0.5) / 1000.0);
+    }
+    return serial.failures + fast.failures == 0 ? 0 : 1;
+}
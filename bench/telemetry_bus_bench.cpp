@@ -0,0 +1,229 @@
+// Telemetry fan-out: BusTopic vs. callbacks run one after another.
+//
+// A publisher thread emits position samples at --rate-hz for --seconds to 1..64
+// subscribers. Subscriber 0 is slow: it busy-waits --slow-us per sample, like
+// a recorder flushing or a UI redrawing. Every other subscriber only records
+// how long after publication it got the sample.
+//
+// The serial variant calls every handler on the publisher thread, as MAVSDK
+// does with several subscribe_position() callbacks. The bus variant publishes
+// to a BusTopic, which gives each subscriber its own ring and thread. Reports
+// delivery latency of the fast subscribers and drops.
+//
+// Usage: telemetry_bus_bench [--subscribers 1,4,16,64] [--rate-hz HZ]
+//                            [--seconds S] [--slow-us US] [--capacity N]
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "bench_util.h"
+#include "deadline_timer.h"
+#include "telemetry_bus.h"
+
+using bench::Clock;
+using Position = mavsdk::Telemetry::Position;
+
+namespace {
+
+struct Result {
+    bench::LatencyStats latency;
+    uint64_t published{0};
+    uint64_t dropped{0};
+    uint64_t slow_dropped{0};
+};
+
+void busy_wait(std::chrono::microseconds duration)
+{
+    const auto until = Clock::now() + duration;
+    while (Clock::now() < until) {
+    }
+}
+
+// When sample `index` (0-based) is due. Latency counts from there, so time a
+// sample spends waiting behind a slow handler before it is even published is
+// included.
+struct Schedule {
+    Clock::time_point start;
+    Clock::duration period;
+
+    Clock::time_point at(uint64_t index) const
+    {
+        return start + period * static_cast<Clock::rep>(index);
+    }
+};
+
+Schedule make_schedule(double rate_hz)
+{
+    // Leaves the subscriber threads time to start.
+    return {
+        Clock::now() + std::chrono::milliseconds(50),
+        std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / rate_hz))};
+}
+
+double latency_us(const Schedule& schedule, uint64_t index)
+{
+    return bench::to_us(Clock::now() - schedule.at(index));
+}
+
+// Publishes on `schedule` until `duration` is over; returns the sample count.
+template<typename Publish>
+uint64_t publish_for(
+    const Schedule& schedule, std::chrono::duration<double> duration, Publish&& publish)
+{
+    const auto end = schedule.start + std::chrono::duration_cast<Clock::duration>(duration);
+    uint64_t count = 0;
+    Position position{};
+    for (; schedule.at(count) < end; ++count) {
+        sleep_until_deadline(schedule.at(count));
+        position.relative_altitude_m = static_cast<float>(count) * 0.01f;
+        publish(position, count);
+    }
+    return count;
+}
+
+// Per-subscriber latency samples in us, reserved up front so recording one
+// does not allocate.
+std::vector<std::vector<double>> make_latencies(size_t subscribers, size_t expected)
+{
+    std::vector<std::vector<double>> latencies(subscribers);
+    for (auto& latency : latencies) {
+        latency.reserve(expected);
+    }
+    return latencies;
+}
+
+// All fast subscribers' samples (subscriber 0 is the slow one).
+void merge(const std::vector<std::vector<double>>& latencies, bench::LatencyStats& stats)
+{
+    for (size_t i = 1; i < latencies.size(); ++i) {
+        for (const double us : latencies[i]) {
+            stats.add_us(us);
+        }
+    }
+}
+
+Result run_serial(
+    size_t subscribers,
+    double rate_hz,
+    std::chrono::duration<double> duration,
+    std::chrono::microseconds slow)
+{
+    auto latencies =
+        make_latencies(subscribers, static_cast<size_t>(rate_hz * duration.count()) + 16);
+
+    const auto schedule = make_schedule(rate_hz);
+    Result result;
+    result.published =
+        publish_for(schedule, duration, [&](const Position& position, uint64_t index) {
+            // Each handler in turn on the publishing thread.
+            Stamped<Position> sample;
+            sample.value = position;
+            sample.sequence = index + 1;
+            busy_wait(slow);
+            for (size_t i = 1; i < subscribers; ++i) {
+                latencies[i].push_back(latency_us(schedule, sample.sequence - 1));
+            }
+        });
+    merge(latencies, result.latency);
+    return result;
+}
+
+Result run_bus(
+    size_t subscribers,
+    double rate_hz,
+    std::chrono::duration<double> duration,
+    std::chrono::microseconds slow,
+    size_t capacity)
+{
+    auto latencies =
+        make_latencies(subscribers, static_cast<size_t>(rate_hz * duration.count()) + 16);
+
+    const auto schedule = make_schedule(rate_hz);
+    Result result;
+    {
+        BusTopic<Position> topic;
+        std::vector<std::shared_ptr<BusTopic<Position>::Subscription>> subscriptions;
+        subscriptions.push_back(
+            topic.subscribe([slow](const Stamped<Position>&) { busy_wait(slow); }, capacity));
+        for (size_t i = 1; i < subscribers; ++i) {
+            auto& latency = latencies[i];
+            subscriptions.push_back(topic.subscribe(
+                [&latency, &schedule](const Stamped<Position>& sample) {
+                    latency.push_back(latency_us(schedule, sample.sequence - 1));
+                },
+                capacity));
+        }
+
+        result.published = publish_for(
+            schedule, duration, [&topic](const Position& position, uint64_t) {
+                topic.publish(position);
+            });
+
+        for (auto& subscription : subscriptions) {
+            topic.unsubscribe(subscription);
+        }
+        result.slow_dropped = subscriptions[0]->dropped();
+        for (size_t i = 1; i < subscribers; ++i) {
+            result.dropped += subscriptions[i]->dropped();
+        }
+    }
+    merge(latencies, result.latency);
+    return result;
+}
+
+void print(const char* mode, size_t subscribers, Result& result)
+{
+    std::printf(
+        "%-7s %11zu %9llu %10.1f %10.1f %10.1f %10llu %12llu\n",
+        mode,
+        subscribers,
+        static_cast<unsigned long long>(result.published),
+        result.latency.percentile_us(0.5),
+        result.latency.percentile_us(0.99),
+        result.latency.percentile_us(1.0),
+        static_cast<unsigned long long>(result.dropped),
+        static_cast<unsigned long long>(result.slow_dropped));
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const auto subscriber_counts =
+        bench::parse_list(bench::arg_value(argc, argv, "--subscribers", "1,4,16,64"));
+    const double rate_hz = bench::arg_double(argc, argv, "--rate-hz", 100.0);
+    const auto duration =
+        std::chrono::duration<double>(bench::arg_double(argc, argv, "--seconds", 3.0));
+    const auto slow = std::chrono::microseconds(bench::arg_long(argc, argv, "--slow-us", 15000));
+    const auto capacity = static_cast<size_t>(bench::arg_long(argc, argv, "--capacity", 64));
+
+    std::printf(
+        "%.0f Hz for %.1f s; subscriber 0 takes %lld us per sample, bus rings hold %zu\n\n",
+        rate_hz,
+        duration.count(),
+        static_cast<long long>(slow.count()),
+        capacity);
+    std::printf(
+        "%-7s %11s %9s %10s %10s %10s %10s %12s\n",
+        "mode",
+        "subscribers",
+        "published",
+        "p50 us",
+        "p99 us",
+        "max us",
+        "drops",
+        "slow drops");
+
+    for (const long count : subscriber_counts) {
+        const auto subscribers = static_cast<size_t>(std::max(count, 1L));
+        auto serial = run_serial(subscribers, rate_hz, duration, slow);
+        print("serial", subscribers, serial);
+        auto bus = run_bus(subscribers, rate_hz, duration, slow, capacity);
+        print("bus", subscribers, bus);
+    }
+    std::printf("\nLatency and drops are over the fast subscribers (all but subscriber 0).\n");
+    return 0;
+}
@@ -0,0 +1,280 @@
+// Read contention on the latest-value position cache.
+//
+// One writer thread publishes positions as fast as it can (or at --rate-hz)
+// while N reader threads keep reading the newest value. The same workload runs
+// against a mutex-protected struct (what Telemetry::position() amounts to) and
+// against TelemetryCache.
+//
+// With `--mock` the writer is MAVSDK's position callback, fed by a mock
+// autopilot at --rate-hz (50 by default, in simulated time). The readers then
+// compare Telemetry::position() itself with a TelemetryCache attached to the
+// same Telemetry. Real samples have no all-equal fields, so tearing is only
+// checked on synthetic input.
+//
+// Usage: telemetry_cache_bench [--seconds S] [--max-readers N] [--rate-hz HZ]
+//                              [--mock] [--port PORT] [--time-scale X]
+
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench_util.h"
+#include "telemetry_cache.h"
+
+#ifdef ROTATE_HAVE_MOCK_AUTOPILOT
+#include <mavsdk/mavsdk.h>
+
+#include "mock_autopilot.h"
+#endif
+
+using bench::Clock;
+using mavsdk::Telemetry;
+
+namespace {
+
+struct Result {
+    double reads_per_s{0.0};
+    double writes_per_s{0.0};
+    uint64_t torn{0};
+};
+
+// Every position is written with all fields equal, so a torn read shows up as
+// fields that disagree.
+Telemetry::Position make_position(uint64_t i)
+{
+    const auto value = static_cast<float>(i);
+    return Telemetry::Position{value, value, value, value};
+}
+
+bool consistent(const Telemetry::Position& position)
+{
+    return position.latitude_deg == position.longitude_deg &&
+           static_cast<float>(position.latitude_deg) == position.relative_altitude_m &&
+           position.absolute_altitude_m == position.relative_altitude_m;
+}
+
+template<typename Write, typename Read>
+Result run(int readers, double seconds, double rate_hz, Write&& write, Read&& read)
+{
+    std::atomic<bool> running{true};
+    std::atomic<uint64_t> reads{0};
+    std::atomic<uint64_t> torn{0};
+    uint64_t writes = 0;
+
+    std::vector<std::thread> threads;
+    for (int r = 0; r < readers; ++r) {
+        threads.emplace_back([&]() {
+            uint64_t local_reads = 0;
+            uint64_t local_torn = 0;
+            while (running.load(std::memory_order_relaxed)) {
+                if (!consistent(read())) {
+                    ++local_torn;
+                }
+                ++local_reads;
+            }
+            reads.fetch_add(local_reads);
+            torn.fetch_add(local_torn);
+        });
+    }
+
+    const auto period = rate_hz > 0.0 ? std::chrono::duration_cast<Clock::duration>(
+                                            std::chrono::duration<double>(1.0 / rate_hz)) :
+                                        Clock::duration::zero();
+    const auto start = Clock::now();
+    const auto end = start + std::chrono::duration_cast<Clock::duration>(
+                                 std::chrono::duration<double>(seconds));
+    auto next = start;
+    while (Clock::now() < end) {
+        write(make_position(++writes));
+        if (period != Clock::duration::zero()) {
+            next += period;
+            std::this_thread::sleep_until(next);
+        }
+    }
+    running = false;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    return Result{
+        static_cast<double>(reads.load()) / elapsed, static_cast<double>(writes) / elapsed, torn};
+}
+
+#ifdef ROTATE_HAVE_MOCK_AUTOPILOT
+// Reads/s of `readers` threads calling `read` for `seconds`.
+template<typename Read> double read_rate(int readers, double seconds, Read&& read)
+{
+    std::atomic<bool> running{true};
+    std::atomic<uint64_t> reads{0};
+    std::vector<std::thread> threads;
+    for (int r = 0; r < readers; ++r) {
+        threads.emplace_back([&]() {
+            uint64_t local_reads = 0;
+            float sink = 0.0f;
+            while (running.load(std::memory_order_relaxed)) {
+                sink += read().relative_altitude_m;
+                ++local_reads;
+            }
+            reads.fetch_add(local_reads);
+            // Keeps the reads from being optimized out.
+            volatile float keep = sink;
+            (void)keep;
+        });
+    }
+    const auto start = Clock::now();
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    running = false;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    return static_cast<double>(reads.load()) / elapsed;
+}
+
+int run_mock(double seconds, long max_readers, int argc, char** argv)
+{
+    using namespace mavsdk;
+
+    MockAutopilot::Options mock_options;
+    const auto port = static_cast<uint16_t>(bench::arg_long(argc, argv, "--port", 14567));
+    mock_options.remote_port = port;
+    mock_options.time_scale = bench::arg_double(argc, argv, "--time-scale", 1.0);
+    MockAutopilot mock{mock_options};
+    if (!mock.start()) {
+        std::cerr << "Could not start mock autopilot\n";
+        return 1;
+    }
+
+    Mavsdk mavsdk{Mavsdk::Configuration{ComponentType::GroundStation}};
+    if (mavsdk.add_any_connection("udpin://0.0.0.0:" + std::to_string(port)) !=
+        ConnectionResult::Success) {
+        std::cerr << "Connection failed\n";
+        return 1;
+    }
+    auto system = mavsdk.first_autopilot(5.0);
+    if (!system) {
+        std::cerr << "Timed out waiting for mock autopilot\n";
+        return 1;
+    }
+    Telemetry telemetry{system.value()};
+    const double rate_hz = bench::arg_double(argc, argv, "--rate-hz", 50.0);
+    if (telemetry.set_rate_position(rate_hz) != Telemetry::Result::Success) {
+        std::cerr << "Setting the position rate failed\n";
+        return 1;
+    }
+
+    std::atomic<uint64_t> writes{0};
+    auto counter = telemetry.subscribe_position(
+        [&writes](Telemetry::Position) { writes.fetch_add(1, std::memory_order_relaxed); });
+    TelemetryCache cache;
+    cache.attach(telemetry);
+
+    const auto print_row = [&](long readers,
+                               const char* variant,
+                               double reads_per_s,
+                               uint64_t writes_before,
+                               Clock::time_point started) {
+        const double elapsed = std::chrono::duration<double>(Clock::now() - started).count();
+        std::printf(
+            "%-8ld %-16s %16.0f %16.0f %8s\n",
+            readers,
+            variant,
+            reads_per_s,
+            static_cast<double>(writes.load() - writes_before) / elapsed,
+            "-");
+    };
+
+    for (long readers = 1; readers <= max_readers; readers *= 2) {
+        {
+            const auto writes_before = writes.load();
+            const auto started = Clock::now();
+            const double reads_per_s = read_rate(
+                static_cast<int>(readers), seconds, [&]() { return telemetry.position(); });
+            print_row(readers, "position()", reads_per_s, writes_before, started);
+        }
+        {
+            const auto writes_before = writes.load();
+            const auto started = Clock::now();
+            const double reads_per_s = read_rate(
+                static_cast<int>(readers), seconds, [&]() { return cache.position().value; });
+            print_row(readers, "TelemetryCache", reads_per_s, writes_before, started);
+        }
+    }
+
+    cache.detach();
+    telemetry.unsubscribe_position(counter);
+    if (writes.load() == 0) {
+        std::cerr << "No position samples arrived from the mock\n";
+        return 1;
+    }
+    return 0;
+}
+#endif
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const double seconds = bench::arg_double(argc, argv, "--seconds", 1.0);
+    const long max_readers = bench::arg_long(argc, argv, "--max-readers", 16);
+    const double rate_hz = bench::arg_double(argc, argv, "--rate-hz", 0.0);
+
+    std::printf(
+        "%-8s %-16s %16s %16s %8s\n", "readers", "variant", "reads/s", "writes/s", "torn");
+
+    if (bench::arg_flag(argc, argv, "--mock")) {
+#ifdef ROTATE_HAVE_MOCK_AUTOPILOT
+        return run_mock(seconds, max_readers, argc, argv);
+#else
+        std::cerr << "Built without the mock autopilot\n";
+        return 1;
+#endif
+    }
+
+    for (long readers = 1; readers <= max_readers; readers *= 2) {
+        {
+            std::mutex mutex;
+            Telemetry::Position latest{};
+            const auto result = run(
+                static_cast<int>(readers),
+                seconds,
+                rate_hz,
+                [&](const Telemetry::Position& position) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    latest = position;
+                },
+                [&]() {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    return latest;
+                });
+            std::printf(
+                "%-8ld %-16s %16.0f %16.0f %8llu\n",
+                readers,
+                "mutex",
+                result.reads_per_s,
+                result.writes_per_s,
+                static_cast<unsigned long long>(result.torn));
+        }
+        {
+            TelemetryCache cache;
+            const auto result = run(
+                static_cast<int>(readers),
+                seconds,
+                rate_hz,
+                [&](const Telemetry::Position& position) { cache.update_position(position); },
+                [&]() { return cache.position().value; });
+            std::printf(
+                "%-8ld %-16s %16.0f %16.0f %8llu\n",
+                readers,
+                "TelemetryCache",
+                result.reads_per_s,
+                result.writes_per_s,
+                static_cast<unsigned long long>(result.torn));
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,153 @@
+// Quintic trajectory sampling throughput.
+//
+// Samples rotate's minimum-jerk climb one point at a time (as the setpoint
+// stream does), then in batches: one segment at many times, and many
+// segments (vehicles) at one time each, with the portable loops and with the
+// AVX2+FMA ones. Batch results are checked against the one-at-a-time ones.
+//
+// Usage: trajectory_bench [--samples N] [--batch N] [--vehicles 8,64,1024,4096]
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "bench_util.h"
+#include "trajectory.h"
+
+using bench::Clock;
+using trajectory::Quintic;
+
+namespace {
+
+double seconds_since(Clock::time_point started)
+{
+    return std::chrono::duration<double>(Clock::now() - started).count();
+}
+
+void print(const char* label, size_t width, double samples, double seconds)
+{
+    std::printf("%-28s %6zu %12.1f Msamples/s\n", label, width, samples / seconds / 1e6);
+}
+
+// Soaks up results so the loops are not optimized away.
+volatile float sink;
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const long samples = bench::arg_long(argc, argv, "--samples", 50'000'000);
+    const auto batch = static_cast<size_t>(bench::arg_long(argc, argv, "--batch", 1024));
+    const auto vehicle_counts =
+        bench::parse_list(bench::arg_value(argc, argv, "--vehicles", "8,64,1024,4096"));
+
+    const QuinticClimbRotateLaw law{MissionParams{}};
+    const Quintic& climb = law.altitude();
+    const float duration = climb.duration_s();
+    std::printf(
+        "Climb: %.2f m in %.2f s, peak %.3f m/s; batch path: %s\n\n",
+        climb.position(duration),
+        duration,
+        climb.velocity(duration / 2.0f),
+        trajectory::batch_path());
+    std::printf("%-28s %6s %20s\n", "mode", "width", "throughput");
+
+    // One sample per call, position and velocity.
+    {
+        const float dt = duration / static_cast<float>(samples);
+        float acc = 0.0f;
+        const auto started = Clock::now();
+        for (long i = 0; i < samples; ++i) {
+            const float t = static_cast<float>(i) * dt;
+            acc += climb.position(t) + climb.velocity(t);
+        }
+        const double seconds = seconds_since(started);
+        sink = acc;
+        print("one at a time", 1, static_cast<double>(samples), seconds);
+    }
+
+    // One segment, many times.
+    std::vector<float> times(batch);
+    std::vector<float> position(batch);
+    std::vector<float> velocity(batch);
+    for (size_t i = 0; i < batch; ++i) {
+        times[i] = duration * static_cast<float>(i) / static_cast<float>(batch);
+    }
+    const long rounds = std::max<long>(1, samples / static_cast<long>(batch));
+    for (const bool simd : {false, true}) {
+        trajectory::set_batch_simd(simd);
+        const auto started = Clock::now();
+        for (long r = 0; r < rounds; ++r) {
+            climb.sample(times.data(), batch, position.data(), velocity.data());
+            sink = position[static_cast<size_t>(r) % batch];
+        }
+        const double seconds = seconds_since(started);
+        print(
+            simd ? "times, avx2+fma" : "times, portable",
+            batch,
+            static_cast<double>(rounds) * static_cast<double>(batch),
+            seconds);
+    }
+
+    float max_error = 0.0f;
+    for (size_t i = 0; i < batch; ++i) {
+        max_error = std::max(max_error, std::fabs(position[i] - climb.position(times[i])));
+        max_error = std::max(max_error, std::fabs(velocity[i] - climb.velocity(times[i])));
+    }
+
+    // Many vehicles, each on its own climb and at its own time.
+    for (const long count : vehicle_counts) {
+        const auto n = static_cast<size_t>(count);
+        std::vector<float> coefficients(11 * n);
+        std::vector<float> durations(n);
+        std::vector<float> vehicle_times(n);
+        std::vector<float> vehicle_position(n);
+        std::vector<float> vehicle_velocity(n);
+
+        trajectory::QuinticLanes lanes;
+        for (size_t k = 0; k < 6; ++k) {
+            lanes.position[k] = coefficients.data() + k * n;
+        }
+        for (size_t k = 0; k < 5; ++k) {
+            lanes.velocity[k] = coefficients.data() + (6 + k) * n;
+        }
+        lanes.duration_s = durations.data();
+        lanes.count = n;
+
+        std::vector<Quintic> climbs;
+        for (size_t i = 0; i < n; ++i) {
+            MissionParams params;
+            params.target_altitude_m = 3.0f + static_cast<float>(i % 16) * 0.5f;
+            climbs.push_back(QuinticClimbRotateLaw{params}.altitude());
+            lanes.set(i, climbs.back());
+            vehicle_times[i] = climbs.back().duration_s() * static_cast<float>(i % 97) / 96.0f;
+        }
+
+        const long vehicle_rounds = std::max<long>(1, samples / count);
+        for (const bool simd : {false, true}) {
+            trajectory::set_batch_simd(simd);
+            const auto started = Clock::now();
+            for (long r = 0; r < vehicle_rounds; ++r) {
+                trajectory::sample(
+                    lanes, vehicle_times.data(), vehicle_position.data(), vehicle_velocity.data());
+                sink = vehicle_position[static_cast<size_t>(r) % n];
+            }
+            const double seconds = seconds_since(started);
+            print(
+                simd ? "vehicles, avx2+fma" : "vehicles, portable",
+                n,
+                static_cast<double>(vehicle_rounds) * static_cast<double>(n),
+                seconds);
+        }
+        for (size_t i = 0; i < n; ++i) {
+            const float t = vehicle_times[i];
+            max_error = std::max(max_error, std::fabs(vehicle_position[i] - climbs[i].position(t)));
+            max_error = std::max(max_error, std::fabs(vehicle_velocity[i] - climbs[i].velocity(t)));
+        }
+    }
+    trajectory::set_batch_simd(true);
+
+    std::printf("\nmax batch vs. one-at-a-time difference: %.2e\n", max_error);
+    return max_error < 1e-4f ? 0 : 1;
+}
@@ -0,0 +1,128 @@
+"""Background frame dumping for vision.py.
+
+`submit()` never blocks the caller: it puts a copy of the frame on a bounded
+queue and returns. A small pool of worker threads encodes and writes the
+queued frames. When the queue is full the frame is dropped and counted
+instead, so a slow disk costs saved frames, not ingested ones.
+
+Formats:
+    raw   the pixel bytes as they are, named <stem>_<width>x<height>x<channels>.raw
+    png   lossless, slowest to encode
+    jpeg  lossy, fast and small
+"""
+import os
+import queue
+import threading
+
+import cv2
+
+FORMATS = ('raw', 'png', 'jpeg')
+
+
+class FrameDumper:
+    def __init__(self, directory, fmt='png', workers=2, queue_size=16, jpeg_quality=90):
+        if fmt not in FORMATS:
+            raise ValueError(f'unknown frame format {fmt}; expected one of {FORMATS}')
+        os.makedirs(directory, exist_ok=True)
+        self.directory = directory
+        self.format = fmt
+        self._jpeg_params = [cv2.IMWRITE_JPEG_QUALITY, jpeg_quality]
+        self._queue = queue.Queue(maxsize=queue_size)
+
+        self._lock = threading.Lock()
+        self.submitted = 0
+        self.written = 0
+        self.dropped = 0
+        self.failed = 0
+        self.max_queue_depth = 0
+
+        self._workers = [
+            threading.Thread(target=self._run, name=f'frame_dump_{i}', daemon=True)
+            for i in range(max(1, workers))]
+        for worker in self._workers:
+            worker.start()
+
+    def submit(self, img, stem, fmt=None):
+        """Queues `img` to be written as <directory>/<stem>.<ext>.
+
+        Returns False if the frame was dropped because the queue is full. The
+        image is copied, so views into shared memory or message buffers may be
+        released as soon as this returns.
+        """
+        with self._lock:
+            self.submitted += 1
+        # Check before copying, so a dropped frame costs nothing.
+        if self._queue.full():
+            self._count_drop()
+            return False
+        try:
+            self._queue.put_nowait((img.copy(), stem, fmt or self.format))
+        except queue.Full:
+            self._count_drop()
+            return False
+        depth = self._queue.qsize()
+        with self._lock:
+            self.max_queue_depth = max(self.max_queue_depth, depth)
+        return True
+
+    def queue_depth(self):
+        return self._queue.qsize()
+
+    def stats(self):
+        with self._lock:
+            return {
+                'submitted': self.submitted,
+                'written': self.written,
+                'dropped': self.dropped,
+                'failed': self.failed,
+                'queue_depth': self._queue.qsize(),
+                'max_queue_depth': self.max_queue_depth,
+            }
+
+    def close(self):
+        """Writes what is still queued, then stops the workers."""
+        for _ in self._workers:
+            self._queue.put(None)
+        for worker in self._workers:
+            worker.join()
+
+    def _count_drop(self):
+        with self._lock:
+            self.dropped += 1
+
+    def _run(self):
+        while True:
+            item = self._queue.get()
+            if item is None:
+                return
+            img, stem, fmt = item
+            ok = self._write(img, stem, fmt)
+            with self._lock:
+                if ok:
+                    self.written += 1
+                else:
+                    self.failed += 1
+
+    def _write(self, img, stem, fmt):
+        if fmt == 'raw':
+            channels = 1 if img.ndim == 2 else img.shape[2]
+            path = os.path.join(
+                self.directory, f'{stem}_{img.shape[1]}x{img.shape[0]}x{channels}.raw')
+            try:
+                img.tofile(path)
+            except OSError:
+                return False
+            return True
+
+        # cv2.imencode releases the GIL, so the workers encode in parallel.
+        ext = '.png' if fmt == 'png' else '.jpg'
+        params = self._jpeg_params if fmt == 'jpeg' else []
+        ok, encoded = cv2.imencode(ext, img, params)
+        if not ok:
+            return False
+        try:
+            with open(os.path.join(self.directory, stem + ext), 'wb') as f:
+                f.write(encoded.tobytes())
+        except OSError:
+            return False
+        return True
@@ -0,0 +1,119 @@
+"""Python reader for the shared-memory frame ring written by camera_ingest.
+
+Frames are returned as NumPy arrays that point straight into shared memory,
+so no pixel is copied. A frame stays pinned (the writer will not reuse its
+slot) until it is released, so release it, or use it as a context manager,
+as soon as you are done with it.
+
+The reader goes through the C API in librotate_camera.so. Set
+ROTATE_CAMERA_LIB to its path if it is not in build/.
+"""
+import ctypes
+import os
+
+import numpy as np
+
+ENCODINGS = {1: 'rgb8', 2: 'bgr8', 3: 'mono8'}
+
+
+class _Frame(ctypes.Structure):
+    _fields_ = [
+        ('data', ctypes.POINTER(ctypes.c_uint8)),
+        ('sequence', ctypes.c_uint64),
+        ('size', ctypes.c_uint64),
+        ('stamp_ns', ctypes.c_int64),
+        ('publish_ns', ctypes.c_int64),
+        ('slot', ctypes.c_uint32),
+        ('width', ctypes.c_uint32),
+        ('height', ctypes.c_uint32),
+        ('step', ctypes.c_uint32),
+        ('encoding', ctypes.c_uint32),
+    ]
+
+
+def _load_library():
+    path = os.environ.get(
+        'ROTATE_CAMERA_LIB',
+        os.path.join(os.path.dirname(os.path.abspath(__file__)), 'build', 'librotate_camera.so'))
+    lib = ctypes.CDLL(path)
+    lib.frame_ring_open.argtypes = [ctypes.c_char_p]
+    lib.frame_ring_open.restype = ctypes.c_void_p
+    lib.frame_ring_close.argtypes = [ctypes.c_void_p]
+    lib.frame_ring_acquire_latest.argtypes = [
+        ctypes.c_void_p, ctypes.c_uint64, ctypes.POINTER(_Frame)]
+    lib.frame_ring_acquire_latest.restype = ctypes.c_int
+    lib.frame_ring_release.argtypes = [ctypes.c_void_p, ctypes.c_uint32]
+    lib.frame_ring_published.argtypes = [ctypes.c_void_p]
+    lib.frame_ring_published.restype = ctypes.c_uint64
+    lib.frame_ring_dropped.argtypes = [ctypes.c_void_p]
+    lib.frame_ring_dropped.restype = ctypes.c_uint64
+    return lib
+
+
+class Frame:
+    """A pinned frame. `image` is a read-only view into shared memory."""
+
+    def __init__(self, ring, raw):
+        self._ring = ring
+        self._slot = raw.slot
+        self.sequence = raw.sequence
+        self.stamp_ns = raw.stamp_ns
+        self.publish_ns = raw.publish_ns
+        self.width = raw.width
+        self.height = raw.height
+        self.encoding = ENCODINGS.get(raw.encoding, 'unknown')
+
+        channels = 1 if self.encoding == 'mono8' else 3
+        buffer = (ctypes.c_uint8 * raw.size).from_address(
+            ctypes.addressof(raw.data.contents))
+        rows = np.frombuffer(buffer, dtype=np.uint8)[:raw.height * raw.step]
+        rows = rows.reshape((raw.height, raw.step))[:, :raw.width * channels]
+        self.image = rows.reshape((raw.height, raw.width, channels)) if channels == 3 \
+            else rows
+        self.image.flags.writeable = False
+
+    def release(self):
+        if self._ring is not None:
+            self.image = None
+            self._ring._release(self._slot)
+            self._ring = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.release()
+
+    def __del__(self):
+        self.release()
+
+
+class FrameRing:
+    def __init__(self, name='/rotate_frames'):
+        self._lib = _load_library()
+        self._ring = self._lib.frame_ring_open(name.encode())
+        if not self._ring:
+            raise RuntimeError(f'frame ring {name} does not exist; is camera_ingest running?')
+        self._raw = _Frame()
+
+    def acquire_latest(self, after_sequence=0):
+        """Returns the newest Frame if it is newer than `after_sequence`, else None."""
+        if not self._lib.frame_ring_acquire_latest(
+                self._ring, after_sequence, ctypes.byref(self._raw)):
+            return None
+        return Frame(self, self._raw)
+
+    def published(self):
+        return self._lib.frame_ring_published(self._ring)
+
+    def dropped(self):
+        return self._lib.frame_ring_dropped(self._ring)
+
+    def _release(self, slot):
+        if self._ring:
+            self._lib.frame_ring_release(self._ring, slot)
+
+    def close(self):
+        if self._ring:
+            self._lib.frame_ring_close(self._ring)
+            self._ring = None
@@ -1,33 +1,218 @@
-// takeoff -> when altitude > 1m, start rotating while climbing to 5m
-// -> hover 5s -> land
+// takeoff -> when altitude > 1.7m, start rotating while climbing to 5m
+// -> hover until the safety timeout -> land
 
+#include <charconv>
 #include <chrono>
 #include <cstdint>
 #include <iostream>
-#include <thread>
+#include <memory>
+#include <optional>
+#include <string>
 
 #include <mavsdk/mavsdk.h>
 #include <mavsdk/plugins/action/action.h>
 #include <mavsdk/plugins/telemetry/telemetry.h>
 #include <mavsdk/plugins/offboard/offboard.h>
 
+#include "alloc_tracker.h"
+#include "async_log.h"
+#include "fast_start.h"
+#include "fleet.h"
+#include "flight_metrics.h"
+#include "flight_profile.h"
+#include "geofence.h"
+#ifdef ROTATE_HAVE_FLIGHT_RECORDER
+#include "flight_recorder.h"
+#endif
+#include "rotate_mission.h"
+#include "telemetry_bus.h"
+#include "trajectory.h"
+#include "vehicle_arena.h"
+
 using namespace mavsdk;
-using std::chrono::seconds;
-using std::this_thread::sleep_for;
 
 void usage(const std::string& bin_name)
 {
-    std::cerr << "Usage : " << bin_name << " <connection_url>\n"
-              << "Example (SITL): " << bin_name << " udp://:14540\n";
+    std::cerr << "Usage : " << bin_name
+              << " <connection_url> [--fleet <vehicles>] [--record <file>]"
+                 " [--metrics <file.json|file.csv>] [--profile <file>]"
+                 " [--trajectory constant|quintic] [--realtime <cpu>]"
+                 " [--geofence <file>]\n"
+              << "Example (SITL): " << bin_name << " udp://:14540\n"
+              << "Example (multi-vehicle SITL): " << bin_name << " udp://:14540 --fleet 4\n"
+              << "Example (record telemetry): " << bin_name
+              << " udp://:14540 --record flight.bin\n"
+              << "Example (phase and telemetry metrics): " << bin_name
+              << " udp://:14540 --metrics metrics.json\n"
+              << "Example (experimental parameters): " << bin_name
+              << " udp://:14540 --profile slow_climb.conf\n"
+              << "Example (smooth climb and turn): " << bin_name
+              << " udp://:14540 --trajectory quintic\n"
+              << "Example (pinned SCHED_FIFO setpoint thread): " << bin_name
+              << " udp://:14540 --realtime 3\n"
+              << "Example (land on leaving a fence): " << bin_name
+              << " udp://:14540 --geofence field.fence\n";
+}
+
+// Parses a whole argument as an integer, without throwing on bad input.
+template<typename T> bool parse_integer(const std::string& text, T& value)
+{
+    const char* end = text.data() + text.size();
+    const auto [last, error] = std::from_chars(text.data(), end, value);
+    return error == std::errc{} && last == end;
+}
+
+#ifdef ROTATE_HAVE_ALLOCATION_TRACKING
+// rotate_alloc_tracked: where the heap was used, and whether a hot region
+// did (alloc_tracker.h). Returns false if one did.
+bool report_allocations()
+{
+    const auto hot_allocations = alloc_tracking::report(std::cout);
+    if (hot_allocations > 0) {
+        std::cerr << hot_allocations << " heap allocations in hot regions\n";
+        return false;
+    }
+    return true;
+}
+#endif
+
+// Flies the mission on `vehicles` autopilots at once.
+int run_fleet(
+    Mavsdk& mavsdk, size_t vehicles, const MissionParams& params, const Geofence* geofence)
+{
+    Fleet::Options options;
+    options.vehicles = vehicles;
+    options.mission = params;
+    options.geofence = geofence;
+
+    Fleet fleet{mavsdk, options};
+    const auto discovered = fleet.discover();
+    if (discovered == 0) {
+        std::cerr << "Timed out waiting for systems\n";
+        return 1;
+    }
+    if (discovered < vehicles) {
+        std::cerr << "Only found " << discovered << " of " << vehicles << " vehicles\n";
+    }
+
+    std::cout << "Flying " << discovered << " vehicles...\n";
+    const bool all_landed = fleet.run();
+#ifdef ROTATE_HAVE_ALLOCATION_TRACKING
+    alloc_tracking::set_phase("shutdown");
+#endif
+
+    for (const auto& report : fleet.reports()) {
+        std::cout << "Vehicle " << static_cast<int>(report.system_id) << ": " << report.outcome;
+        if (report.failure != nullptr) {
+            std::cout << " (" << report.failure << ")";
+        }
+        if (report.breach != Geofence::Breach::None) {
+            std::cout << " after a geofence breach (" << report.breach << ")";
+        }
+        std::cout << " after "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(report.mission_duration)
+                         .count()
+                  << " ms, arena grew " << report.arena_allocations_since_seal << " times\n";
+    }
+#ifdef ROTATE_HAVE_ALLOCATION_TRACKING
+    if (!report_allocations()) {
+        return 1;
+    }
+#endif
+    return all_landed ? 0 : 1;
 }
 
 int main(int argc, char** argv)
 {
-    if (argc != 2) {
+    if (argc < 2 || argc % 2 != 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    size_t fleet_size = 0;
+    std::string record_path;
+    std::string metrics_path;
+    std::string profile_path;
+    std::string geofence_path;
+    bool quintic = false;
+    RealtimeOptions realtime;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        const std::string option = argv[i];
+        if (option == "--fleet") {
+            if (!parse_integer(argv[i + 1], fleet_size) || fleet_size == 0) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (option == "--record") {
+            record_path = argv[i + 1];
+        } else if (option == "--metrics") {
+            metrics_path = argv[i + 1];
+        } else if (option == "--profile") {
+            profile_path = argv[i + 1];
+        } else if (option == "--geofence") {
+            geofence_path = argv[i + 1];
+        } else if (option == "--realtime") {
+            if (!parse_integer(argv[i + 1], realtime.cpu) || realtime.cpu < 0) {
+                usage(argv[0]);
+                return 1;
+            }
+            realtime.fifo_priority = 80;
+            realtime.lock_memory = true;
+        } else if (option == "--trajectory" && std::string(argv[i + 1]) == "quintic") {
+            quintic = true;
+        } else if (option == "--trajectory" && std::string(argv[i + 1]) == "constant") {
+            quintic = false;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // Fleet mode flies its own state machine (fleet.h), without the
+    // single-vehicle extras below; refuse them rather than drop them.
+    const char* fleet_conflict = nullptr;
+    if (fleet_size > 0) {
+        if (!record_path.empty()) {
+            fleet_conflict = "--record";
+        } else if (!metrics_path.empty()) {
+            fleet_conflict = "--metrics";
+        } else if (quintic) {
+            fleet_conflict = "--trajectory quintic";
+        } else if (realtime.enabled()) {
+            fleet_conflict = "--realtime";
+        }
+    }
+    if (fleet_conflict != nullptr) {
+        std::cerr << fleet_conflict << " is not supported with --fleet\n";
         usage(argv[0]);
         return 1;
     }
 
+    // The compiled-in profile, unless --profile loads one for an experiment.
+    using CompiledProfile = flight_profiles::X500Sitl;
+    MissionParams params = CompiledProfile::params;
+    if (!profile_path.empty()) {
+        std::string error;
+        if (!load_mission_params(profile_path, params, error)) {
+            std::cerr << "Invalid profile: " << error << '\n';
+            return 1;
+        }
+    }
+
+    // Checked on every position sample once airborne, see geofence.h.
+    std::optional<Geofence> geofence;
+    if (!geofence_path.empty()) {
+        Geofence::Description fence;
+        std::string error;
+        if (!load_geofence(geofence_path, fence, error)) {
+            std::cerr << "Invalid geofence: " << error << '\n';
+            return 1;
+        }
+        geofence.emplace(fence);
+        std::cout << "Geofence: " << fence.inclusion.size() << " inclusion and "
+                  << fence.keep_out.size() << " keep-out polygons, breach response "
+                  << fence.response << '\n';
+    }
+
     // GroundStation connection
     Mavsdk mavsdk{Mavsdk::Configuration{ComponentType::GroundStation}};
     const auto connection_result = mavsdk.add_any_connection(argv[1]);
@@ -37,92 +222,174 @@ int main(int argc, char** argv)
         return 1;
     }
 
-    auto system = mavsdk.first_autopilot(5.0);
+    if (!metrics_path.empty() && !FlightMetrics::enabled) {
+        std::cerr << "Built without flight metrics (ROTATE_FLIGHT_METRICS=OFF)\n";
+        return 1;
+    }
+
+    if (fleet_size > 0) {
+        return run_fleet(mavsdk, fleet_size, params, geofence ? &*geofence : nullptr);
+    }
+
+    // Returns on the autopilot's first heartbeat.
+    const auto system = mavsdk.first_autopilot(5.0);
     if (!system) {
         std::cerr << "Timed out waiting for system\n";
         return 1;
     }
 
-    Telemetry telemetry{system.value()};
-    Action action{system.value()};
-    Offboard offboard{system.value()};
+    // The vehicle's long-lived mission memory: the log's records and the
+    // bus's rings come from it rather than the global heap (vehicle_arena.h).
+    VehicleArena arena;
 
-    // Set the position update rate
-    const auto set_rate_result = telemetry.set_rate_position(5.0); // 5 Hz
-    if (set_rate_result != Telemetry::Result::Success) {
-        std::cerr << "Setting rate failed: " << set_rate_result << '\n';
-        return 1;
+    // Declared before the plugins so it outlives their callbacks. Callbacks
+    // log through it so they never block on terminal I/O.
+    AsyncLog::Options log_options;
+    log_options.resource = arena.resource();
+    AsyncLog async_log{log_options};
+
+    // Constructed concurrently.
+    const AutopilotPlugins plugins = make_plugins(*system);
+    Telemetry& telemetry = *plugins.telemetry;
+    Action& action = *plugins.action;
+    Offboard& offboard = *plugins.offboard;
+
+    // The only Telemetry subscriber besides the recorder: it fans every sample
+    // out to the mission, the metrics and the log, each on its own thread, so
+    // a slow one cannot hold up the others. Declared before them so it
+    // outlives their subscriptions, and attached once they have subscribed.
+    TelemetryBus bus{arena.resource()};
+
+    // Rotate while climbing: velocity setpoints streamed at a fixed rate that
+    // climb at climb_rate_m_s and yaw at yaw_rate_deg_s until target_altitude_m.
+    // Declared after the plugins it commands, and the mission after it, so
+    // both go away (and unsubscribe) first.
+    // Telemetry rates follow the phase, see rate_profile.h.
+    // The compiled profile's setpoint law has its rates inlined; a loaded
+    // profile uses the runtime one. --trajectory quintic replaces the constant
+    // climb and yaw rates with minimum-jerk profiles.
+    std::unique_ptr<MavsdkMissionVehicle> vehicle;
+    if (quintic) {
+        vehicle = std::make_unique<MavsdkMissionVehicle>(
+            telemetry, action, offboard, params, QuinticClimbRotateLaw{params});
+    } else if (profile_path.empty()) {
+        vehicle = std::make_unique<MavsdkMissionVehicle>(
+            telemetry, action, offboard, ClimbRotateLaw<CompiledProfile>{});
+    } else {
+        vehicle = std::make_unique<MavsdkMissionVehicle>(telemetry, action, offboard, params);
+    }
+    // --realtime: the setpoint thread gets its own core, SCHED_FIFO and
+    // locked memory, as far as permitted (realtime.h).
+    vehicle->set_realtime(realtime);
+    RotateMission mission{*vehicle, params};
+    if (geofence) {
+        mission.set_geofence(&*geofence);
     }
 
-    telemetry.subscribe_position([](Telemetry::Position position) {
-        std::cout << "[Telem] Altitude (rel): " << position.relative_altitude_m << " m\n";
+    bus.position().subscribe([&async_log](const Stamped<Telemetry::Position>& position) {
+        async_log.log("[Telem] Altitude (rel): {} m\n", position.value.relative_altitude_m);
     });
+    mission.attach(bus);
 
-    // Wait until the vehicle is healthy
-    while (!telemetry.health_all_ok()) {
-        std::cout << "Vehicle is getting ready to arm...\n";
-        sleep_for(seconds(1));
+    // Phase spans and per-stream sample age, written to --metrics at exit.
+    FlightMetrics metrics;
+    if (!metrics_path.empty()) {
+        metrics.attach(bus);
     }
+    bus.attach(telemetry);
 
-    // Arm
-    std::cout << "Arming...\n";
-    const auto arm_result = action.arm();
-    if (arm_result != Action::Result::Success) {
-        std::cerr << "Arming failed: " << arm_result << '\n';
+#ifdef ROTATE_HAVE_FLIGHT_RECORDER
+    // Every Telemetry sample into a binary file for flight_log and rotate_replay.
+    // Subscribed to Telemetry directly: the file must be in time order across
+    // streams, and the bus delivers each stream on its own thread. Appending
+    // is a memcpy into the mapping, so it does not hold up the bus.
+    FlightRecorder recorder;
+    if (!record_path.empty()) {
+        if (!recorder.open(record_path)) {
+            std::cerr << "Could not create " << record_path << '\n';
+            return 1;
+        }
+        recorder.attach(telemetry);
+    }
+#else
+    if (!record_path.empty()) {
+        std::cerr << "Recording is not supported on this platform\n";
         return 1;
     }
+#endif
 
-    // Set takeoff altitude
-    action.set_takeoff_altitude(1.75f);
-    const auto max_wait = seconds(20);        // safety timeout
-    auto start = std::chrono::steady_clock::now();
-    // Takeoff
-    std::cout << "Taking off...\n";
-    const auto takeoff_result = action.takeoff();
-    if (takeoff_result != Action::Result::Success) {
-        std::cerr << "Takeoff failed: " << takeoff_result << '\n';
-        return 1;
+    mission.sequencer().set_phase_end_callback(
+        [&metrics](const MissionSequencer::Phase& phase,
+                   MissionSequencer::Result result,
+                   MissionSequencer::Clock::duration elapsed) {
+            metrics.on_phase_end(phase, result, elapsed);
+            std::cout << "Phase " << phase.name << ": " << result << " after "
+                      << std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count()
+                      << " ms\n";
+        });
+
+    // Everything the flight needs is allocated by now.
+    arena.seal();
+    const auto mission_result = mission.run();
+#ifdef ROTATE_HAVE_ALLOCATION_TRACKING
+    alloc_tracking::set_phase("shutdown");
+#endif
+    vehicle->stop_streaming();
+
+    const auto stream_stats = vehicle->stream_stats();
+    std::cout << "Setpoints sent: " << stream_stats.sent
+              << ", failed: " << stream_stats.send_failures
+              << ", missed deadlines: " << stream_stats.missed_deadlines
+              << ", max jitter: " << stream_stats.max_jitter_us << " us"
+              << ", max gap: " << stream_stats.max_gap_us << " us\n";
+    if (realtime.enabled() && stream_stats.sent > 0) {
+        std::cout << "Setpoint thread real-time setup: " << vehicle->realtime_status() << '\n';
+        std::cout << "Wakeup lateness histogram:";
+        for (size_t i = 0; i < stream_stats.jitter_histogram.size(); ++i) {
+            if (i < SetpointStreamer::jitter_bucket_us.size()) {
+                std::cout << " <=" << SetpointStreamer::jitter_bucket_us[i] << "us:";
+            } else {
+                std::cout << " more:";
+            }
+            std::cout << stream_stats.jitter_histogram[i];
+        }
+        std::cout << '\n';
+    }
+    std::cout << "Rate requests sent: " << vehicle->rates().requests_sent()
+              << ", failed: " << vehicle->rates().failures() << '\n';
+    std::cout << "Vehicle arena: " << arena.stats() << '\n';
+
+#ifdef ROTATE_HAVE_FLIGHT_RECORDER
+    if (recorder.is_open()) {
+        recorder.detach();
+        recorder.close();
+        std::cout << "Recorded " << recorder.recorded() << " samples to " << record_path
+                  << " (" << recorder.dropped() << " dropped)\n";
     }
-    // Wait until we reach ~1.7 m
-    while (true) {
-        const auto pos = telemetry.position();
-        std::cout << "Current altitude: "
-                << pos.relative_altitude_m << " m\n";
+#endif
 
-        if (pos.relative_altitude_m >= 1.7f) {
-            std::cout << "Altitude above 1.7 m, Hi, Monalisa and Lenna!\n";
-            break;
+    if (!metrics_path.empty()) {
+        metrics.detach();
+        if (metrics.write(metrics_path)) {
+            std::cout << "Wrote flight metrics to " << metrics_path << '\n';
+        } else {
+            std::cerr << "Could not write " << metrics_path << '\n';
         }
-        sleep_for(seconds(1));
-    }
-
-    int hover_count = 0;
-    while (true) {
-        // Optional: avoid infinite wait in case something is wrong
-        auto now = std::chrono::steady_clock::now();
-        int duration = std::chrono::duration_cast<std::chrono::seconds>(now - start).count();
-        std::cout << "Timeout waiting for hover count " << duration << "\n";
-                
-        if (now - start > max_wait) {
-            break;
-        }  
-        sleep_for(seconds(1));
-    }
-
-    // Hover for 5 seconds
-    // std::cout << "Hovering for 5 seconds...\n";
-
-    // Land
-    std::cout << "Landing...\n";
-    const auto land_result = action.land();
-    if (land_result != Action::Result::Success) {
-        std::cerr << "Land failed: " << land_result << '\n';
+    }
+
+#ifdef ROTATE_HAVE_ALLOCATION_TRACKING
+    if (!report_allocations()) {
         return 1;
     }
+#endif
 
-    while (telemetry.in_air()) {
-        std::cout << "Vehicle is landing...\n";
-        sleep_for(seconds(1));
+    if (mission_result != MissionSequencer::Result::Success) {
+        std::cerr << "Mission failed in phase " << mission.sequencer().last_phase() << ": "
+                  << mission_result << '\n';
+        if (mission.sequencer().last_phase() == "health") {
+            std::cerr << "Still waiting for: " << mission.health_missing() << '\n';
+        }
+        return 1;
     }
 
     std::cout << "Landed. Finished.\n";
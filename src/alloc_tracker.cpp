@@ -0,0 +1,239 @@
+// Global operator new/delete replacement for rotate_alloc_tracked. Only
+// linked into that executable, see alloc_tracker.h.
+//
+// The bookkeeping itself must not allocate: threads and phases get slots in
+// fixed tables, and the hot-region report goes straight to stderr.
+
+#include "alloc_tracker.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <new>
+
+#include <execinfo.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+struct Counters {
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> hot{0};
+
+    void add(size_t size, bool hot_region)
+    {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        bytes.fetch_add(size, std::memory_order_relaxed);
+        if (hot_region) {
+            hot.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+};
+
+struct ThreadSlot {
+    long tid{0};
+    char name[16]{};
+    Counters counters;
+};
+
+struct PhaseSlot {
+    std::atomic<const char*> name{nullptr};
+    Counters counters;
+};
+
+// Threads beyond the table share its last slot.
+constexpr size_t max_threads = 128;
+// Phases beyond the table share its last slot.
+constexpr size_t max_phases = 32;
+
+ThreadSlot threads[max_threads];
+std::atomic<size_t> thread_count{0};
+
+// Slot 0 is for allocations before the first phase.
+PhaseSlot phases[max_phases];
+std::atomic<size_t> phase_count{1};
+
+thread_local ThreadSlot* this_thread_slot = nullptr;
+
+const bool abort_in_hot_region = [] {
+    const char* value = std::getenv("ROTATE_ALLOC_ABORT");
+    return value != nullptr && std::strcmp(value, "0") != 0;
+}();
+
+ThreadSlot& thread_slot()
+{
+    if (this_thread_slot == nullptr) {
+        const auto index = thread_count.fetch_add(1, std::memory_order_relaxed);
+        this_thread_slot = &threads[std::min(index, max_threads - 1)];
+        if (index < max_threads) {
+            this_thread_slot->tid = syscall(SYS_gettid);
+            pthread_getname_np(
+                pthread_self(), this_thread_slot->name, sizeof(this_thread_slot->name));
+        }
+    }
+    return *this_thread_slot;
+}
+
+PhaseSlot& phase_slot(const char* name)
+{
+    if (name == nullptr) {
+        return phases[0];
+    }
+    while (true) {
+        const auto count = phase_count.load(std::memory_order_acquire);
+        for (size_t i = 1; i < count; ++i) {
+            if (phases[i].name.load(std::memory_order_acquire) == name) {
+                return phases[i];
+            }
+        }
+        if (count >= max_phases) {
+            return phases[max_phases - 1];
+        }
+        // Claim the next slot; on a race, look again.
+        const char* expected = nullptr;
+        if (phases[count].name.compare_exchange_strong(expected, name)) {
+            phase_count.fetch_add(1, std::memory_order_release);
+            return phases[count];
+        }
+        while (phase_count.load(std::memory_order_acquire) == count) {
+        }
+    }
+}
+
+void write_stderr(const char* text)
+{
+    const auto written = ::write(STDERR_FILENO, text, std::strlen(text));
+    (void)written;
+}
+
+[[noreturn]] void abort_with_backtrace(size_t size, const char* phase)
+{
+    // Allocations from here on (backtrace() may load libgcc) are not hot.
+    alloc_tracking::hot_depth = 0;
+
+    char message[256];
+    std::snprintf(
+        message,
+        sizeof(message),
+        "Allocation of %zu bytes in a hot region (phase %s, thread %ld)\n",
+        size,
+        phase != nullptr ? phase : "setup",
+        syscall(SYS_gettid));
+    write_stderr(message);
+
+    void* frames[64];
+    const int count = backtrace(frames, 64);
+    backtrace_symbols_fd(frames, count, STDERR_FILENO);
+    std::abort();
+}
+
+void record(size_t size)
+{
+    const bool hot = alloc_tracking::hot_depth > 0;
+    const char* phase = alloc_tracking::current_phase.load(std::memory_order_acquire);
+    if (hot && abort_in_hot_region) {
+        abort_with_backtrace(size, phase);
+    }
+    thread_slot().counters.add(size, hot);
+    phase_slot(phase).counters.add(size, hot);
+}
+
+void* allocate(size_t size)
+{
+    record(size);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* allocate_aligned(size_t size, std::align_val_t alignment)
+{
+    record(size);
+    const auto align = std::max(static_cast<size_t>(alignment), sizeof(void*));
+    // aligned_alloc() wants a multiple of the alignment.
+    const size_t rounded = (std::max<size_t>(size, 1) + align - 1) / align * align;
+    if (void* p = std::aligned_alloc(align, rounded)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void print_counters(std::ostream& str, const Counters& counters)
+{
+    str << std::setw(10) << counters.allocations.load(std::memory_order_relaxed)
+        << std::setw(12) << counters.bytes.load(std::memory_order_relaxed) << std::setw(6)
+        << counters.hot.load(std::memory_order_relaxed) << '\n';
+}
+
+} // namespace
+
+// The array and nothrow forms default to these.
+void* operator new(size_t size)
+{
+    return allocate(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    return allocate_aligned(size, alignment);
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+namespace alloc_tracking {
+
+uint64_t report(std::ostream& str)
+{
+    // Printing allocates too; that lands in the current phase.
+    const auto phase_total = std::min(phase_count.load(std::memory_order_acquire), max_phases);
+    const auto thread_total = std::min(thread_count.load(std::memory_order_acquire), max_threads);
+
+    uint64_t hot = 0;
+    str << "Heap allocations by phase:\n"
+        << std::left << std::setw(28) << "  phase" << std::right << std::setw(10) << "count"
+        << std::setw(12) << "bytes" << std::setw(6) << "hot" << '\n';
+    for (size_t i = 0; i < phase_total; ++i) {
+        const char* name = phases[i].name.load(std::memory_order_acquire);
+        str << "  " << std::left << std::setw(26) << (name != nullptr ? name : "setup")
+            << std::right;
+        print_counters(str, phases[i].counters);
+        hot += phases[i].counters.hot.load(std::memory_order_relaxed);
+    }
+
+    str << "Heap allocations by thread:\n"
+        << std::left << std::setw(28) << "  thread" << std::right << std::setw(10) << "count"
+        << std::setw(12) << "bytes" << std::setw(6) << "hot" << '\n';
+    for (size_t i = 0; i < thread_total; ++i) {
+        char label[32];
+        std::snprintf(label, sizeof(label), "%ld %s", threads[i].tid, threads[i].name);
+        str << "  " << std::left << std::setw(26) << label << std::right;
+        print_counters(str, threads[i].counters);
+    }
+    return hot;
+}
+
+} // namespace alloc_tracking
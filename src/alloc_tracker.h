@@ -0,0 +1,64 @@
+#pragma once
+
+// Heap allocation tracking for the instrumented rotate build.
+//
+// rotate_alloc_tracked (CMake option ROTATE_ALLOCATION_TRACKING) links
+// alloc_tracker.cpp, which replaces the global operator new and delete with
+// versions that count every allocation per thread and per mission phase.
+// Other builds only keep the markers below: a thread_local increment and an
+// atomic store that nothing reads.
+//
+// Code that must not allocate once the flight has started marks itself with
+// a HotRegion. Allocations inside one are counted separately. With
+// ROTATE_ALLOC_ABORT=1 in the environment, the first one prints a backtrace
+// and aborts instead.
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+
+namespace alloc_tracking {
+
+// Nesting depth of HotRegions on this thread.
+inline thread_local int hot_depth = 0;
+// Name of the mission phase allocations are attributed to, or nullptr
+// before the first one.
+inline std::atomic<const char*> current_phase{nullptr};
+
+class HotRegion {
+public:
+    HotRegion() { ++hot_depth; }
+    ~HotRegion() { --hot_depth; }
+
+    HotRegion(const HotRegion&) = delete;
+    HotRegion& operator=(const HotRegion&) = delete;
+};
+
+// Lifts the enclosing HotRegions for a call that may allocate, such as
+// sending a MAVSDK command from a step that must not allocate otherwise.
+class ColdRegion {
+public:
+    ColdRegion() : _depth(hot_depth) { hot_depth = 0; }
+    ~ColdRegion() { hot_depth = _depth; }
+
+    ColdRegion(const ColdRegion&) = delete;
+    ColdRegion& operator=(const ColdRegion&) = delete;
+
+private:
+    const int _depth;
+};
+
+// Attributes allocations on every thread to `name` from now on. `name` must
+// stay valid until report().
+inline void set_phase(const char* name)
+{
+    current_phase.store(name, std::memory_order_release);
+}
+
+// Only defined in the instrumented build.
+//
+// Prints allocations per phase and per thread. Returns the number made
+// inside hot regions.
+uint64_t report(std::ostream& str);
+
+} // namespace alloc_tracking
@@ -0,0 +1,55 @@
+#include "async_action.h"
+
+#include <memory>
+#include <utility>
+
+using namespace mavsdk;
+
+namespace {
+
+// A promise for the caller's future and the callback that fulfils it.
+std::pair<std::future<Action::Result>, Action::ResultCallback> make_result()
+{
+    auto promise = std::make_shared<std::promise<Action::Result>>();
+    auto future = promise->get_future();
+    return {
+        std::move(future),
+        [promise](Action::Result result) { promise->set_value(result); }};
+}
+
+} // namespace
+
+std::future<Action::Result> AsyncAction::arm()
+{
+    auto [future, callback] = make_result();
+    _action.arm_async(callback);
+    return std::move(future);
+}
+
+std::future<Action::Result> AsyncAction::set_takeoff_altitude(float altitude_m)
+{
+    auto [future, callback] = make_result();
+    _action.set_takeoff_altitude_async(altitude_m, callback);
+    return std::move(future);
+}
+
+std::future<Action::Result> AsyncAction::takeoff()
+{
+    auto [future, callback] = make_result();
+    _action.takeoff_async(callback);
+    return std::move(future);
+}
+
+std::future<Action::Result> AsyncAction::land()
+{
+    auto [future, callback] = make_result();
+    _action.land_async(callback);
+    return std::move(future);
+}
+
+std::future<Action::Result> AsyncAction::return_to_launch()
+{
+    auto [future, callback] = make_result();
+    _action.return_to_launch_async(callback);
+    return std::move(future);
+}
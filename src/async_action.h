@@ -0,0 +1,50 @@
+#pragma once
+
+// Futures over Action's *_async commands.
+//
+// Each call sends its command right away and returns a future for the result,
+// so independent commands are in flight together and the caller only waits
+// where a later step needs an earlier result. A mission stays straight-line
+// code:
+//
+//     auto altitude = action.set_takeoff_altitude(2.0f);
+//     auto armed = action.arm();
+//     if (wait_all(altitude, armed) != Action::Result::Success) ...
+//     if (action.takeoff().get() != Action::Result::Success) ...
+//
+// The result callbacks hold the promises, so a future stays valid even if the
+// AsyncAction goes away before the command completes.
+
+#include <future>
+
+#include <mavsdk/plugins/action/action.h>
+
+class AsyncAction {
+public:
+    using Result = mavsdk::Action::Result;
+
+    explicit AsyncAction(mavsdk::Action& action) : _action(action) {}
+
+    std::future<Result> arm();
+    std::future<Result> set_takeoff_altitude(float altitude_m);
+    std::future<Result> takeoff();
+    std::future<Result> land();
+    std::future<Result> return_to_launch();
+
+private:
+    mavsdk::Action& _action;
+};
+
+// Waits for every future and returns the first result, in argument order,
+// that is not Success, or Success.
+template<typename... Futures> mavsdk::Action::Result wait_all(Futures&... futures)
+{
+    auto first_failure = mavsdk::Action::Result::Success;
+    const auto take = [&first_failure](mavsdk::Action::Result result) {
+        if (first_failure == mavsdk::Action::Result::Success) {
+            first_failure = result;
+        }
+    };
+    (take(futures.get()), ...);
+    return first_failure;
+}
@@ -0,0 +1,174 @@
+#include "async_log.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+
+namespace {
+
+size_t round_up_to_power_of_two(size_t value)
+{
+    size_t result = 2;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+} // namespace
+
+AsyncLog::AsyncLog() : AsyncLog(Options{}) {}
+
+AsyncLog::AsyncLog(const Options& options) :
+    _options(options),
+    _mask(round_up_to_power_of_two(options.capacity) - 1),
+    _cells(_mask + 1, options.resource)
+{
+    for (size_t i = 0; i <= _mask; ++i) {
+        _cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    _thread = std::thread(&AsyncLog::drain_loop, this);
+}
+
+AsyncLog::~AsyncLog()
+{
+    _running = false;
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+}
+
+uint64_t AsyncLog::now_ns() const
+{
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - _created).count());
+}
+
+// Bounded MPSC queue after Dmitry Vyukov's bounded MPMC queue: each cell
+// carries a sequence number that tells producers whether it is free and the
+// consumer whether it has been published.
+bool AsyncLog::push(const Record& record)
+{
+    size_t pos = _enqueue_pos.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+        cell = &_cells[pos & _mask];
+        const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+        const auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else {
+            pos = _enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+
+    cell->record = record;
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    _pushed.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool AsyncLog::pop(Record& record)
+{
+    Cell* cell = &_cells[_dequeue_pos & _mask];
+    const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+    if (sequence != _dequeue_pos + 1) {
+        return false;
+    }
+
+    record = cell->record;
+    cell->sequence.store(_dequeue_pos + _mask + 1, std::memory_order_release);
+    ++_dequeue_pos;
+    return true;
+}
+
+void AsyncLog::drain_loop()
+{
+    while (_running.load(std::memory_order_relaxed)) {
+        if (drain() == 0) {
+            std::this_thread::sleep_for(_options.idle_interval);
+        }
+    }
+    drain();
+}
+
+size_t AsyncLog::drain()
+{
+    size_t count = 0;
+    Record record;
+    while (pop(record)) {
+        write(record);
+        ++count;
+    }
+    if (count > 0) {
+        std::fflush(_options.out);
+        _written.fetch_add(count, std::memory_order_release);
+    }
+    return count;
+}
+
+void AsyncLog::flush()
+{
+    const auto target = _pushed.load(std::memory_order_relaxed);
+    while (_written.load(std::memory_order_acquire) < target) {
+        std::this_thread::sleep_for(_options.idle_interval);
+    }
+}
+
+void AsyncLog::write(const Record& record)
+{
+    char line[512];
+    size_t length = 0;
+    const auto append = [&](const char* text, size_t count) {
+        count = std::min(count, sizeof(line) - 1 - length);
+        std::memcpy(line + length, text, count);
+        length += count;
+    };
+
+    if (_options.timestamps) {
+        char stamp[32];
+        const int n = std::snprintf(
+            stamp, sizeof(stamp), "[%12.6f] ", static_cast<double>(record.timestamp_ns) / 1e9);
+        append(stamp, static_cast<size_t>(n));
+    }
+
+    size_t next_arg = 0;
+    for (const char* p = record.format; *p != '\0'; ++p) {
+        if (p[0] != '{' || p[1] != '}' || next_arg >= record.arg_count) {
+            append(p, 1);
+            continue;
+        }
+
+        const Arg& arg = record.args[next_arg++];
+        char value[64];
+        int n = 0;
+        switch (arg.type) {
+            case Arg::Type::Int:
+                n = std::snprintf(value, sizeof(value), "%" PRId64, arg.i);
+                break;
+            case Arg::Type::UInt:
+                n = std::snprintf(value, sizeof(value), "%" PRIu64, arg.u);
+                break;
+            case Arg::Type::Double:
+                n = std::snprintf(value, sizeof(value), "%g", arg.d);
+                break;
+            case Arg::Type::Bool:
+                n = std::snprintf(value, sizeof(value), "%s", arg.b ? "true" : "false");
+                break;
+            case Arg::Type::String:
+                append(arg.s, std::strlen(arg.s));
+                break;
+        }
+        if (n > 0) {
+            append(value, std::min(static_cast<size_t>(n), sizeof(value) - 1));
+        }
+        ++p;
+    }
+
+    std::fwrite(line, 1, length, _options.out);
+}
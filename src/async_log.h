@@ -0,0 +1,151 @@
+#pragma once
+
+// Asynchronous, allocation-free logging for callback threads.
+//
+// log() copies a format string pointer and up to max_args scalar arguments
+// into a fixed-size record in a bounded lock-free MPSC ring and returns. A
+// background thread drains the ring, formats the records and writes them out,
+// so terminal or file I/O never blocks the thread that logged.
+//
+// Formats use "{}" placeholders. The format string and any `const char*`
+// arguments are stored by pointer and must outlive the log (string literals).
+// When the ring is full the record is dropped and counted. The ring's records
+// are allocated once, from Options::resource.
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory_resource>
+#include <thread>
+#include <vector>
+#include <type_traits>
+
+class AsyncLog {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr size_t max_args = 6;
+
+    struct Arg {
+        enum class Type : uint8_t {
+            Int,
+            UInt,
+            Double,
+            Bool,
+            String,
+        };
+
+        Type type{Type::Int};
+        union {
+            int64_t i;
+            uint64_t u;
+            double d;
+            bool b;
+            const char* s;
+        };
+    };
+
+    struct Record {
+        uint64_t timestamp_ns{0};
+        const char* format{nullptr};
+        uint8_t arg_count{0};
+        std::array<Arg, max_args> args{};
+    };
+
+    struct Options {
+        // Rounded up to a power of two.
+        size_t capacity{4096};
+        FILE* out{stdout};
+        // Prefix each line with seconds since the log was created.
+        bool timestamps{false};
+        // How long the drain thread sleeps when the ring is empty.
+        std::chrono::microseconds idle_interval{std::chrono::milliseconds(2)};
+        // Where the ring is allocated, e.g. a VehicleArena.
+        std::pmr::memory_resource* resource{std::pmr::get_default_resource()};
+    };
+
+    AsyncLog();
+    explicit AsyncLog(const Options& options);
+    // Drains everything still queued before returning.
+    ~AsyncLog();
+
+    AsyncLog(const AsyncLog&) = delete;
+    AsyncLog& operator=(const AsyncLog&) = delete;
+
+    // Returns false if the record was dropped because the ring is full.
+    template<typename... Args> bool log(const char* format, Args... args)
+    {
+        static_assert(sizeof...(Args) <= max_args, "too many log arguments");
+        Record record;
+        record.timestamp_ns = now_ns();
+        record.format = format;
+        record.arg_count = static_cast<uint8_t>(sizeof...(Args));
+        size_t index = 0;
+        (void)index;
+        ((record.args[index++] = make_arg(args)), ...);
+        return push(record);
+    }
+
+    // Blocks until everything logged so far has been written out.
+    void flush();
+
+    uint64_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+    uint64_t written() const { return _written.load(std::memory_order_relaxed); }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence{0};
+        Record record;
+    };
+
+    template<typename T> static Arg make_arg(T value)
+    {
+        Arg arg;
+        if constexpr (std::is_same_v<T, bool>) {
+            arg.type = Arg::Type::Bool;
+            arg.b = value;
+        } else if constexpr (std::is_floating_point_v<T>) {
+            arg.type = Arg::Type::Double;
+            arg.d = static_cast<double>(value);
+        } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+            arg.type = Arg::Type::Int;
+            arg.i = static_cast<int64_t>(value);
+        } else if constexpr (std::is_integral_v<T>) {
+            arg.type = Arg::Type::UInt;
+            arg.u = static_cast<uint64_t>(value);
+        } else if constexpr (std::is_enum_v<T>) {
+            arg.type = Arg::Type::Int;
+            arg.i = static_cast<int64_t>(value);
+        } else {
+            static_assert(
+                std::is_same_v<T, const char*> || std::is_same_v<T, char*>,
+                "log arguments must be arithmetic, enums or string literals");
+            arg.type = Arg::Type::String;
+            arg.s = value;
+        }
+        return arg;
+    }
+
+    uint64_t now_ns() const;
+    bool push(const Record& record);
+    bool pop(Record& record);
+    void drain_loop();
+    size_t drain();
+    void write(const Record& record);
+
+    Options _options;
+    size_t _mask{0};
+    std::pmr::vector<Cell> _cells;
+    const Clock::time_point _created{Clock::now()};
+
+    alignas(64) std::atomic<size_t> _enqueue_pos{0};
+    alignas(64) size_t _dequeue_pos{0};
+    alignas(64) std::atomic<uint64_t> _dropped{0};
+    std::atomic<uint64_t> _written{0};
+    std::atomic<uint64_t> _pushed{0};
+
+    std::atomic<bool> _running{true};
+    std::thread _thread;
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+// Line helpers shared by the text loaders of flight profiles
+// (load_mission_params) and geofences (load_geofence).
+
+#include <sstream>
+#include <string>
+
+namespace config_text {
+
+// `text` without leading and trailing spaces, tabs and carriage returns.
+inline std::string trim(const std::string& text)
+{
+    const auto first = text.find_first_not_of(" \t\r");
+    if (first == std::string::npos) {
+        return {};
+    }
+    const auto last = text.find_last_not_of(" \t\r");
+    return text.substr(first, last - first + 1);
+}
+
+// Parses all of `text` as a number; trailing whitespace is allowed.
+inline bool parse_number(const std::string& text, double& value)
+{
+    std::istringstream in(text);
+    in >> value;
+    return in && (in >> std::ws).eof();
+}
+
+} // namespace config_text
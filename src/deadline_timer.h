@@ -0,0 +1,30 @@
+#pragma once
+
+// Sleeping on absolute monotonic deadlines.
+
+#include <chrono>
+#include <thread>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <ctime>
+#endif
+
+// Sleeps until the absolute steady_clock time `deadline`. On Linux this is
+// clock_nanosleep(TIMER_ABSTIME) on CLOCK_MONOTONIC, which steady_clock is
+// based on, so periodic loops that add a fixed period to the deadline do not
+// accumulate scheduling error.
+inline void sleep_until_deadline(std::chrono::steady_clock::time_point deadline)
+{
+#if defined(__linux__)
+    const auto ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+    timespec ts{};
+    ts.tv_sec = static_cast<time_t>(ns / 1000000000);
+    ts.tv_nsec = static_cast<long>(ns % 1000000000);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+    }
+#else
+    std::this_thread::sleep_until(deadline);
+#endif
+}
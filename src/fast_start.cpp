@@ -0,0 +1,19 @@
+#include "fast_start.h"
+
+#include <future>
+
+using namespace mavsdk;
+
+AutopilotPlugins make_plugins(const std::shared_ptr<System>& system)
+{
+    auto telemetry = std::async(
+        std::launch::async, [&system]() { return std::make_unique<Telemetry>(system); });
+    auto action =
+        std::async(std::launch::async, [&system]() { return std::make_unique<Action>(system); });
+
+    AutopilotPlugins plugins;
+    plugins.offboard = std::make_unique<Offboard>(system);
+    plugins.telemetry = telemetry.get();
+    plugins.action = action.get();
+    return plugins;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+// Startup path for short rotate runs.
+//
+// Mavsdk::first_autopilot() already returns on the autopilot's first
+// heartbeat. make_plugins() then constructs the Telemetry, Action and Offboard
+// plugins on parallel threads, since each one registers its message handlers
+// and requests with the system on its own.
+// Telemetry rates need no extra step: the mission's RateSwitcher sends them
+// asynchronously when the health phase starts.
+
+#include <memory>
+
+#include <mavsdk/mavsdk.h>
+#include <mavsdk/plugins/action/action.h>
+#include <mavsdk/plugins/offboard/offboard.h>
+#include <mavsdk/plugins/telemetry/telemetry.h>
+
+struct AutopilotPlugins {
+    std::unique_ptr<mavsdk::Telemetry> telemetry;
+    std::unique_ptr<mavsdk::Action> action;
+    std::unique_ptr<mavsdk::Offboard> offboard;
+};
+
+// Constructs the three plugins for `system` concurrently.
+AutopilotPlugins make_plugins(const std::shared_ptr<mavsdk::System>& system);
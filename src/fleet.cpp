@@ -0,0 +1,642 @@
+#include "fleet.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include <mavsdk/plugins/action/action.h>
+#include <mavsdk/plugins/offboard/offboard.h>
+#include <mavsdk/plugins/telemetry/telemetry.h>
+
+#include "alloc_tracker.h"
+#include "deadline_timer.h"
+#include "health_gate.h"
+#include "telemetry_cache.h"
+
+using namespace mavsdk;
+using Clock = std::chrono::steady_clock;
+
+// One vehicle's plugins and mission state machine. step() is only ever run by
+// one worker at a time; request_step() coalesces requests that arrive while a
+// step is queued or running into one more step.
+class Fleet::Vehicle : public std::enable_shared_from_this<Fleet::Vehicle> {
+public:
+    enum class State {
+        WaitHealth,
+        Arming,
+        SettingTakeoffAltitude,
+        TakingOff,
+        Climbing,
+        StartingOffboard,
+        Rotating,
+        Hovering,
+        StoppingOffboard,
+        Landing,
+        ReturningToLaunch,
+        WaitLanded,
+        Disarming,
+        Done,
+    };
+
+    Vehicle(
+        std::shared_ptr<System> system,
+        const MissionParams& params,
+        const Geofence* geofence,
+        WorkerPool& pool,
+        const VehicleArena& arena,
+        std::function<void()> on_finished) :
+        _system(std::move(system)),
+        _telemetry(_system),
+        _action(_system),
+        _offboard(_system),
+        _params(params),
+        _health_gate(params),
+        _geofence(geofence),
+        _pool(pool),
+        _arena(arena),
+        _on_finished(std::move(on_finished))
+    {
+        _report.system_id = _system->get_system_id();
+        _report.command_latency_ms.fill(-1.0);
+        _cache.attach(_telemetry);
+    }
+
+    void start()
+    {
+        _started = Clock::now();
+        _state_entered = _started;
+    }
+
+    void request_step()
+    {
+        if (_step_requests.fetch_add(1, std::memory_order_acq_rel) != 0) {
+            // A step is already queued or running and will pick this up.
+            return;
+        }
+        // Keeps the vehicle alive until the step has run. There is only ever
+        // one step in flight, so one slot does, and a task capturing nothing
+        // but `this` fits in std::function without a heap allocation.
+        _keep_alive = shared_from_this();
+        _pool.post([this]() {
+            const auto self = std::move(_keep_alive);
+            run_steps();
+        });
+    }
+
+    bool finished() const { return _finished.load(std::memory_order_acquire); }
+    VehicleReport report() const
+    {
+        std::lock_guard<std::mutex> lock(_report_mutex);
+        auto report = _report;
+        report.arena_allocations_since_seal = _arena.allocations_since_seal();
+        return report;
+    }
+
+private:
+    void run_steps()
+    {
+        auto requests = _step_requests.load(std::memory_order_acquire);
+        while (true) {
+            step(Clock::now());
+            // Another request came in while stepping: step again.
+            if (_step_requests.compare_exchange_strong(requests, 0, std::memory_order_acq_rel)) {
+                return;
+            }
+        }
+    }
+
+    // Must not allocate, apart from the MAVSDK calls it makes (checked by
+    // rotate_alloc_tracked --fleet, see alloc_tracker.h).
+    void step(Clock::time_point now)
+    {
+        const alloc_tracking::HotRegion hot;
+        if (finished()) {
+            return;
+        }
+
+        const auto position = _cache.position();
+        const float altitude_m = position.value.relative_altitude_m;
+        if (position.valid()) {
+            check_fence(position.value);
+        }
+
+        switch (_state) {
+            case State::WaitHealth:
+                if (const auto health = _cache.health();
+                    health.valid() && _health_gate.ready(HealthGate::bits(health.value))) {
+                    issue(Command::Arm, State::Arming, [this](const Action::ResultCallback& cb) {
+                        _action.arm_async(cb);
+                    });
+                } else if (now - _state_entered > _params.health_timeout) {
+                    fail("health check timed out");
+                }
+                break;
+
+            case State::Arming:
+                if (completed("arming failed")) {
+                    issue(
+                        Command::SetTakeoffAltitude,
+                        State::SettingTakeoffAltitude,
+                        [this](const Action::ResultCallback& cb) {
+                            _action.set_takeoff_altitude_async(_params.takeoff_altitude_m, cb);
+                        });
+                }
+                break;
+
+            case State::SettingTakeoffAltitude:
+                if (has_result()) {
+                    if (take_result() == static_cast<int>(Action::Result::Success)) {
+                        _takeoff_time = now;
+                        issue(
+                            Command::Takeoff,
+                            State::TakingOff,
+                            [this](const Action::ResultCallback& cb) {
+                                _action.takeoff_async(cb);
+                            });
+                    } else {
+                        // Armed on the ground: disarm before giving up.
+                        note_failure("setting takeoff altitude failed");
+                        disarm();
+                    }
+                }
+                break;
+
+            case State::TakingOff:
+                if (has_result()) {
+                    if (take_result() == static_cast<int>(Action::Result::Success)) {
+                        enter(State::Climbing, now);
+                    } else {
+                        // Still on the ground but armed: disarm before giving up.
+                        note_failure("takeoff failed");
+                        disarm();
+                    }
+                }
+                break;
+
+            case State::Climbing:
+                if (altitude_m >= _params.climb_threshold_m) {
+                    _yaw_deg = _cache.attitude().value.yaw_deg;
+                    _last_setpoint = now;
+                    send_setpoint(now, true);
+                    issue_offboard(Command::StartOffboard, State::StartingOffboard, true);
+                } else if (breached() || landing_due(now)) {
+                    descend();
+                }
+                break;
+
+            case State::StartingOffboard:
+                send_setpoint(now, true);
+                if (has_result()) {
+                    if (take_result() == static_cast<int>(Offboard::Result::Success)) {
+                        enter(State::Rotating, now);
+                    } else {
+                        // Without offboard we can still land safely.
+                        note_failure("offboard start failed");
+                        descend();
+                    }
+                }
+                break;
+
+            case State::Rotating:
+                send_setpoint(now, true);
+                if (breached()) {
+                    issue_offboard(Command::StopOffboard, State::StoppingOffboard, false);
+                } else if (altitude_m >= _params.target_altitude_m || landing_due(now)) {
+                    enter(State::Hovering, now);
+                }
+                break;
+
+            case State::Hovering:
+                send_setpoint(now, false);
+                if (breached() || landing_due(now)) {
+                    issue_offboard(Command::StopOffboard, State::StoppingOffboard, false);
+                }
+                break;
+
+            case State::StoppingOffboard:
+                if (has_result()) {
+                    take_result();
+                    descend();
+                }
+                break;
+
+            case State::Landing:
+                if (has_result()) {
+                    if (take_result() == static_cast<int>(Action::Result::Success)) {
+                        enter(State::WaitLanded, now);
+                    } else if (_land_attempts < max_land_attempts) {
+                        land();
+                    } else {
+                        fail("land failed");
+                    }
+                }
+                break;
+
+            case State::ReturningToLaunch:
+                if (has_result()) {
+                    if (take_result() == static_cast<int>(Action::Result::Success)) {
+                        enter(State::WaitLanded, now);
+                    } else {
+                        // Landing where it is still ends the flight.
+                        note_failure("return to launch failed");
+                        land();
+                    }
+                }
+                break;
+
+            case State::WaitLanded:
+                if (!_cache.in_air().value) {
+                    finish(Outcome::Landed);
+                }
+                break;
+
+            case State::Disarming:
+                if (has_result()) {
+                    if (take_result() != static_cast<int>(Action::Result::Success)) {
+                        note_failure("disarm failed");
+                    }
+                    finish(Outcome::Failed);
+                }
+                break;
+
+            case State::Done:
+                break;
+        }
+    }
+
+    void enter(State state, Clock::time_point now)
+    {
+        _state = state;
+        _state_entered = now;
+    }
+
+    bool landing_due(Clock::time_point now) const
+    {
+        return now - _takeoff_time >= _params.max_wait;
+    }
+
+    void send_setpoint(Clock::time_point now, bool climbing)
+    {
+        if (climbing) {
+            const std::chrono::duration<float> dt = now - _last_setpoint;
+            _yaw_deg = std::fmod(_yaw_deg + _params.yaw_rate_deg_s * dt.count(), 360.0f);
+        }
+        _last_setpoint = now;
+        const alloc_tracking::ColdRegion mavsdk_call;
+        _offboard.set_velocity_ned(
+            {0.0f, 0.0f, climbing ? -_params.climb_rate_m_s : 0.0f, _yaw_deg});
+    }
+
+    // Keeps the first breach while in the air. Like RotateMission, the
+    // altitude floor only counts once the vehicle has been above it.
+    void check_fence(const Telemetry::Position& position)
+    {
+        if (_geofence == nullptr || breached() || !_cache.in_air().value) {
+            return;
+        }
+        const auto breach = _geofence->check(position);
+        if (breach != Geofence::Breach::BelowFloor) {
+            _above_floor = true;
+        } else if (!_above_floor) {
+            return;
+        }
+        if (breach != Geofence::Breach::None) {
+            _breach = breach;
+            std::lock_guard<std::mutex> lock(_report_mutex);
+            _report.breach = breach;
+        }
+    }
+
+    bool breached() const { return _breach != Geofence::Breach::None; }
+
+    // Ends the flight: lands, or returns to launch after a breach if the fence
+    // asks for it.
+    void descend()
+    {
+        if (breached() && _geofence->response() == Geofence::Response::ReturnToLaunch) {
+            issue(
+                Command::ReturnToLaunch,
+                State::ReturningToLaunch,
+                [this](const Action::ResultCallback& cb) { _action.return_to_launch_async(cb); });
+        } else {
+            land();
+        }
+    }
+
+    void disarm()
+    {
+        issue(Command::Disarm, State::Disarming, [this](const Action::ResultCallback& cb) {
+            _action.disarm_async(cb);
+        });
+    }
+
+    void land()
+    {
+        ++_land_attempts;
+        issue(Command::Land, State::Landing, [this](const Action::ResultCallback& cb) {
+            _action.land_async(cb);
+        });
+    }
+
+    // Issues an async Action command and moves to `state` to await its result.
+    // Only one command is outstanding at a time, so the callbacks find what
+    // was issued in members and capture just `this`, which keeps them small
+    // enough for std::function not to allocate.
+    template<typename Issue> void issue(Command command, State state, Issue&& issue_command)
+    {
+        start_command(command, state);
+        const alloc_tracking::ColdRegion mavsdk_call;
+        issue_command([this](Action::Result result) { complete(static_cast<int>(result)); });
+    }
+
+    void issue_offboard(Command command, State state, bool start)
+    {
+        start_command(command, state);
+        auto callback = [this](Offboard::Result result) { complete(static_cast<int>(result)); };
+        const alloc_tracking::ColdRegion mavsdk_call;
+        if (start) {
+            _offboard.start_async(callback);
+        } else {
+            _offboard.stop_async(callback);
+        }
+    }
+
+    void start_command(Command command, State state)
+    {
+        enter(state, Clock::now());
+        _command = static_cast<size_t>(command);
+        _command_issued = Clock::now();
+    }
+
+    // Result callback, on MAVSDK's callback thread.
+    void complete(int result)
+    {
+        const alloc_tracking::HotRegion hot;
+        {
+            std::lock_guard<std::mutex> lock(_report_mutex);
+            _report.command_latency_ms[_command] =
+                std::chrono::duration<double, std::milli>(Clock::now() - _command_issued).count();
+        }
+        _result.store(result, std::memory_order_release);
+        request_step();
+    }
+
+    bool has_result() const { return _result.load(std::memory_order_acquire) != no_result; }
+    int take_result() { return _result.exchange(no_result, std::memory_order_acq_rel); }
+
+    // Consumes an Action result: true on success, fails the mission otherwise.
+    bool completed(const char* failure)
+    {
+        if (!has_result()) {
+            return false;
+        }
+        if (take_result() != static_cast<int>(Action::Result::Success)) {
+            fail(failure);
+            return false;
+        }
+        return true;
+    }
+
+    void note_failure(const char* failure)
+    {
+        std::lock_guard<std::mutex> lock(_report_mutex);
+        if (_report.failure == nullptr) {
+            _report.failure = failure;
+        }
+    }
+
+    void fail(const char* failure)
+    {
+        note_failure(failure);
+        finish(Outcome::Failed);
+    }
+
+    void finish(Outcome outcome)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_report_mutex);
+            _report.outcome = outcome;
+            _report.mission_duration = Clock::now() - _started;
+        }
+        _state = State::Done;
+        _finished.store(true, std::memory_order_release);
+        _on_finished();
+    }
+
+    static constexpr int no_result = -1;
+    // A rejected land command is sent again this many times in total before
+    // the vehicle is given up on.
+    static constexpr int max_land_attempts = 3;
+
+    std::shared_ptr<System> _system;
+    Telemetry _telemetry;
+    Action _action;
+    Offboard _offboard;
+    TelemetryCache _cache;
+
+    const MissionParams _params;
+    const HealthGate _health_gate;
+    const Geofence* const _geofence;
+    WorkerPool& _pool;
+    const VehicleArena& _arena;
+    std::function<void()> _on_finished;
+
+    // Only touched from step().
+    State _state{State::WaitHealth};
+    Clock::time_point _started{};
+    Clock::time_point _state_entered{};
+    Clock::time_point _takeoff_time{Clock::time_point::max()};
+    Clock::time_point _last_setpoint{};
+    float _yaw_deg{0.0f};
+    int _land_attempts{0};
+    Geofence::Breach _breach{Geofence::Breach::None};
+    bool _above_floor{false};
+
+    // The outstanding command, set before it is issued.
+    size_t _command{0};
+    Clock::time_point _command_issued{};
+
+    // Set by request_step(), taken by the step it posts.
+    std::shared_ptr<Vehicle> _keep_alive;
+    std::atomic<uint32_t> _step_requests{0};
+    std::atomic<int> _result{no_result};
+    std::atomic<bool> _finished{false};
+
+    mutable std::mutex _report_mutex;
+    VehicleReport _report;
+};
+
+Fleet::Fleet(Mavsdk& mavsdk, Options options) :
+    _mavsdk(mavsdk),
+    _options(std::move(options)),
+    _pool(_options.workers)
+{}
+
+Fleet::~Fleet()
+{
+    _running = false;
+    if (_control_thread.joinable()) {
+        _control_thread.join();
+    }
+    _pool.wait_idle();
+}
+
+size_t Fleet::count_autopilots() const
+{
+    const auto systems = _mavsdk.systems();
+    return static_cast<size_t>(
+        std::count_if(systems.begin(), systems.end(), [](const std::shared_ptr<System>& system) {
+            return system->has_autopilot();
+        }));
+}
+
+size_t Fleet::discover()
+{
+    // Captures only `this`: a notification already queued on MAVSDK's
+    // callback thread may still run after unsubscribing, when this call has
+    // returned, but the Fleet is still there.
+    auto handle = _mavsdk.subscribe_on_new_system([this]() {
+        const auto count = count_autopilots();
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _known_autopilots = count;
+        }
+        _cv.notify_all();
+    });
+
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _known_autopilots = std::max(_known_autopilots, count_autopilots());
+        _cv.wait_for(lock, _options.discovery_timeout, [this]() {
+            return _known_autopilots >= _options.vehicles;
+        });
+    }
+    _mavsdk.unsubscribe_on_new_system(handle);
+
+    VehicleArena::Options arena_options;
+    arena_options.initial_bytes = _options.arena_bytes;
+    for (auto& system : _mavsdk.systems()) {
+        if (!system->has_autopilot() || _vehicles.size() >= _options.vehicles) {
+            continue;
+        }
+        auto& arena = *_arenas.emplace_back(std::make_unique<VehicleArena>(arena_options));
+        _vehicles.push_back(std::allocate_shared<Vehicle>(
+            std::pmr::polymorphic_allocator<Vehicle>(arena.resource()),
+            system,
+            _options.mission,
+            _options.geofence,
+            _pool,
+            arena,
+            [this]() { vehicle_finished(); }));
+    }
+    return _vehicles.size();
+}
+
+bool Fleet::run()
+{
+    if (_vehicles.empty()) {
+        return false;
+    }
+
+    // At most one step per vehicle is ever queued.
+    _pool.reserve(_vehicles.size());
+    for (auto& arena : _arenas) {
+        arena->seal();
+    }
+    alloc_tracking::set_phase("fleet");
+    for (auto& vehicle : _vehicles) {
+        vehicle->start();
+    }
+
+    _running = true;
+    _control_thread = std::thread(&Fleet::control_loop, this);
+
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _cv.wait(lock, [this]() { return _finished >= _vehicles.size(); });
+    }
+
+    _running = false;
+    _control_thread.join();
+    _pool.wait_idle();
+
+    const auto all_reports = reports();
+    return std::all_of(all_reports.begin(), all_reports.end(), [](const VehicleReport& report) {
+        return report.outcome == Outcome::Landed;
+    });
+}
+
+void Fleet::control_loop()
+{
+    const auto period = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(1.0 / _options.control_rate_hz));
+
+    auto deadline = Clock::now();
+    while (_running.load(std::memory_order_relaxed)) {
+        const alloc_tracking::HotRegion hot;
+        for (auto& vehicle : _vehicles) {
+            if (!vehicle->finished()) {
+                vehicle->request_step();
+            }
+        }
+        deadline += period;
+        sleep_until_deadline(deadline);
+    }
+}
+
+void Fleet::vehicle_finished()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        ++_finished;
+    }
+    _cv.notify_all();
+}
+
+std::vector<Fleet::VehicleReport> Fleet::reports() const
+{
+    std::vector<VehicleReport> result;
+    result.reserve(_vehicles.size());
+    for (const auto& vehicle : _vehicles) {
+        result.push_back(vehicle->report());
+    }
+    return result;
+}
+
+std::ostream& operator<<(std::ostream& str, Fleet::Command const& command)
+{
+    switch (command) {
+        case Fleet::Command::Arm:
+            return str << "Arm";
+        case Fleet::Command::SetTakeoffAltitude:
+            return str << "Set Takeoff Altitude";
+        case Fleet::Command::Takeoff:
+            return str << "Takeoff";
+        case Fleet::Command::StartOffboard:
+            return str << "Start Offboard";
+        case Fleet::Command::StopOffboard:
+            return str << "Stop Offboard";
+        case Fleet::Command::Land:
+            return str << "Land";
+        case Fleet::Command::Disarm:
+            return str << "Disarm";
+        case Fleet::Command::ReturnToLaunch:
+            return str << "Return To Launch";
+        default:
+            return str << "Unknown";
+    }
+}
+
+std::ostream& operator<<(std::ostream& str, Fleet::Outcome const& outcome)
+{
+    switch (outcome) {
+        case Fleet::Outcome::Pending:
+            return str << "Pending";
+        case Fleet::Outcome::Landed:
+            return str << "Landed";
+        case Fleet::Outcome::Failed:
+            return str << "Failed";
+        default:
+            return str << "Unknown";
+    }
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+// Multi-vehicle mode: runs rotate's takeoff -> rotate while climbing -> hover
+// -> land mission on every autopilot on the connection at once.
+//
+// Each vehicle's mission is a non-blocking state machine. A single control
+// thread ticks at a fixed rate and posts one step per vehicle to a small
+// WorkerPool; async command results also post a step, so they are acted on
+// immediately. The thread count therefore stays at workers + 1 no matter how
+// many vehicles there are.
+//
+// With a Geofence, each vehicle's position is checked while it is in the air,
+// and the first breach ends its flight early: it stops Offboard if running,
+// then lands or returns to launch, as RotateMission does.
+//
+// Each vehicle, with its telemetry cache, health gate and mission state, lives
+// in its own VehicleArena. The arenas are sealed when the flight starts; a
+// vehicle's report says whether its arena needed more memory after that.
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+#include <mavsdk/mavsdk.h>
+
+#include "geofence.h"
+#include "mission_params.h"
+#include "vehicle_arena.h"
+#include "worker_pool.h"
+
+class Fleet {
+public:
+    struct Options {
+        // Number of autopilots discover() waits for.
+        size_t vehicles{1};
+        std::chrono::milliseconds discovery_timeout{std::chrono::seconds(10)};
+        // 0 means one per hardware thread.
+        size_t workers{0};
+        // Rate of the mission steps, and so of the Offboard setpoints.
+        double control_rate_hz{20.0};
+        MissionParams mission{};
+        // Checked against every vehicle, if set. Must outlive the Fleet.
+        const Geofence* geofence{nullptr};
+        // First chunk of each vehicle's arena; a vehicle needs a few KiB.
+        size_t arena_bytes{64 * 1024};
+    };
+
+    enum class Command {
+        Arm,
+        SetTakeoffAltitude,
+        Takeoff,
+        StartOffboard,
+        StopOffboard,
+        Land,
+        Disarm,
+        ReturnToLaunch,
+    };
+    static constexpr size_t command_count = 8;
+
+    enum class Outcome {
+        Pending,
+        Landed,
+        Failed,
+    };
+
+    struct VehicleReport {
+        uint8_t system_id{0};
+        Outcome outcome{Outcome::Pending};
+        // Static string describing why the mission failed, or nullptr.
+        const char* failure{nullptr};
+        // The first geofence breach in the air.
+        Geofence::Breach breach{Geofence::Breach::None};
+        // Round trip of each async command, issue to result callback.
+        // Negative if the command was never completed.
+        std::array<double, command_count> command_latency_ms{};
+        std::chrono::steady_clock::duration mission_duration{};
+        // Chunks the vehicle's arena took from the heap after the flight
+        // started; 0 unless arena_bytes is too small.
+        uint64_t arena_allocations_since_seal{0};
+    };
+
+    Fleet(mavsdk::Mavsdk& mavsdk, Options options);
+    ~Fleet();
+
+    Fleet(const Fleet&) = delete;
+    Fleet& operator=(const Fleet&) = delete;
+
+    // Waits until `vehicles` autopilots are known or the discovery timeout
+    // expires, then creates the plugins for each. Returns the vehicle count.
+    size_t discover();
+
+    // Runs the mission on all discovered vehicles. Returns true if every
+    // vehicle landed.
+    bool run();
+
+    std::vector<VehicleReport> reports() const;
+
+private:
+    class Vehicle;
+
+    size_t count_autopilots() const;
+    void control_loop();
+    void vehicle_finished();
+
+    mavsdk::Mavsdk& _mavsdk;
+    const Options _options;
+    WorkerPool _pool;
+
+    // One per vehicle, declared first so they outlive the vehicles.
+    std::vector<std::unique_ptr<VehicleArena>> _arenas;
+    // Shared with the pool tasks that step them, so a vehicle stays alive
+    // until its last queued step has run. Allocated from its arena.
+    std::vector<std::shared_ptr<Vehicle>> _vehicles;
+
+    mutable std::mutex _mutex;
+    std::condition_variable _cv;
+    size_t _known_autopilots{0};
+    size_t _finished{0};
+
+    std::atomic<bool> _running{false};
+    std::thread _control_thread;
+};
+
+std::ostream& operator<<(std::ostream& str, Fleet::Command const& command);
+std::ostream& operator<<(std::ostream& str, Fleet::Outcome const& outcome);
@@ -0,0 +1,107 @@
+#include "flight_log.h"
+
+#include <algorithm>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+FlightLog::~FlightLog()
+{
+    close();
+}
+
+bool FlightLog::open(const std::string& path)
+{
+    close();
+
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st {};
+    if (fstat(fd, &st) != 0 ||
+        static_cast<size_t>(st.st_size) < sizeof(flight_record::FileHeader)) {
+        ::close(fd);
+        return false;
+    }
+    const auto bytes = static_cast<size_t>(st.st_size);
+    void* mapping = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping stays valid without the descriptor.
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+
+    const auto* header = static_cast<const flight_record::FileHeader*>(mapping);
+    if (std::memcmp(header->magic, flight_record::magic, sizeof(header->magic)) != 0 ||
+        header->version != flight_record::version ||
+        header->record_size != sizeof(flight_record::Record)) {
+        munmap(mapping, bytes);
+        return false;
+    }
+
+    _mapping = mapping;
+    _mapping_bytes = bytes;
+    _header = header;
+    _records = reinterpret_cast<const flight_record::Record*>(header + 1);
+
+    const size_t in_file =
+        (bytes - sizeof(flight_record::FileHeader)) / sizeof(flight_record::Record);
+    if (header->record_count != 0) {
+        _size = std::min<size_t>(header->record_count, in_file);
+    } else {
+        // Not closed cleanly: records are written front to back, so the
+        // written ones are a prefix and the first zero timestamp ends it.
+        const auto end = std::partition_point(
+            _records, _records + in_file, [](const flight_record::Record& record) {
+                return record.time_ns != 0;
+            });
+        _size = static_cast<size_t>(end - _records);
+    }
+    return true;
+}
+
+void FlightLog::close()
+{
+    if (_mapping != nullptr) {
+        munmap(_mapping, _mapping_bytes);
+    }
+    _mapping = nullptr;
+    _mapping_bytes = 0;
+    _header = nullptr;
+    _records = nullptr;
+    _size = 0;
+}
+
+size_t FlightLog::lower_bound(int64_t time_ns) const
+{
+    const auto it = std::partition_point(
+        _records, _records + _size, [time_ns](const flight_record::Record& record) {
+            return record.time_ns < time_ns;
+        });
+    return static_cast<size_t>(it - _records);
+}
+
+namespace flight_record {
+
+std::ostream& operator<<(std::ostream& str, Type const& type)
+{
+    switch (type) {
+        case Type::Position:
+            return str << "position";
+        case Type::Attitude:
+            return str << "attitude";
+        case Type::VelocityNed:
+            return str << "velocity";
+        case Type::InAir:
+            return str << "in_air";
+        case Type::Health:
+            return str << "health";
+        default:
+            return str << "unknown";
+    }
+}
+
+} // namespace flight_record
@@ -0,0 +1,60 @@
+#pragma once
+
+// Read-only view of a flight recorder file.
+//
+// The file is memory-mapped, so opening it reads only the header, and looking
+// up a time window is a binary search over the fixed-size records that touches
+// a handful of pages rather than the whole file.
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "flight_record.h"
+
+class FlightLog {
+public:
+    FlightLog() = default;
+    ~FlightLog();
+
+    FlightLog(const FlightLog&) = delete;
+    FlightLog& operator=(const FlightLog&) = delete;
+
+    // Returns false if the file can't be mapped or is not a recording.
+    bool open(const std::string& path);
+    void close();
+
+    const flight_record::FileHeader& header() const { return *_header; }
+    size_t size() const { return _size; }
+    const flight_record::Record& operator[](size_t index) const { return _records[index]; }
+
+    // Index of the first record at or after `time_ns`, or size() if none.
+    size_t lower_bound(int64_t time_ns) const;
+
+    // Record time relative to the start of the recording.
+    double seconds(const flight_record::Record& record) const
+    {
+        return static_cast<double>(record.time_ns - _header->start_steady_ns) * 1e-9;
+    }
+    int64_t time_ns_at(double seconds) const
+    {
+        return _header->start_steady_ns + static_cast<int64_t>(seconds * 1e9);
+    }
+
+    // Copies the payload out if the record holds a T.
+    template<typename T> static bool get(const flight_record::Record& record, T& out)
+    {
+        if (record.type != flight_record::TypeOf<T>::value || record.size != sizeof(T)) {
+            return false;
+        }
+        std::memcpy(&out, record.payload, sizeof(T));
+        return true;
+    }
+
+private:
+    void* _mapping{nullptr};
+    size_t _mapping_bytes{0};
+    const flight_record::FileHeader* _header{nullptr};
+    const flight_record::Record* _records{nullptr};
+    size_t _size{0};
+};
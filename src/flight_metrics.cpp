@@ -0,0 +1,281 @@
+#include "flight_metrics.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+using namespace mavsdk;
+
+namespace {
+
+constexpr FlightMetrics::Stream all_streams[] = {
+    FlightMetrics::Stream::Position,
+    FlightMetrics::Stream::Attitude,
+    FlightMetrics::Stream::VelocityNed,
+    FlightMetrics::Stream::InAir,
+    FlightMetrics::Stream::Health,
+};
+
+double to_ms(int64_t us)
+{
+    return static_cast<double>(us) / 1000.0;
+}
+
+double to_ms(FlightMetrics::Clock::duration duration)
+{
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+void write_histogram_json(std::ostream& out, const FlightMetrics::Histogram::Snapshot& histogram)
+{
+    out << "{\"count\": " << histogram.count << ", \"mean_ms\": " << histogram.mean_us() / 1000.0
+        << ", \"p50_ms\": " << to_ms(histogram.percentile_us(0.5))
+        << ", \"p90_ms\": " << to_ms(histogram.percentile_us(0.9))
+        << ", \"p99_ms\": " << to_ms(histogram.percentile_us(0.99))
+        << ", \"max_ms\": " << to_ms(histogram.max_us) << ", \"buckets\": [";
+    for (size_t i = 0; i < histogram.counts.size(); ++i) {
+        out << (i == 0 ? "" : ", ") << "{\"le_ms\": ";
+        if (i < FlightMetrics::Histogram::edges_us.size()) {
+            out << to_ms(FlightMetrics::Histogram::edges_us[i]);
+        } else {
+            out << "null";
+        }
+        out << ", \"count\": " << histogram.counts[i] << "}";
+    }
+    out << "]}";
+}
+
+void write_histogram_csv(std::ostream& out, const FlightMetrics::Histogram::Snapshot& histogram)
+{
+    if (histogram.count == 0) {
+        out << ",,,";
+        return;
+    }
+    out << to_ms(histogram.percentile_us(0.5)) << ',' << to_ms(histogram.percentile_us(0.9))
+        << ',' << to_ms(histogram.percentile_us(0.99)) << ',' << to_ms(histogram.max_us);
+}
+
+} // namespace
+
+int64_t FlightMetrics::Histogram::Snapshot::percentile_us(double q) const
+{
+    if (count == 0) {
+        return 0;
+    }
+    const auto rank = static_cast<uint64_t>(q * static_cast<double>(count - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < edges_us.size(); ++i) {
+        seen += counts[i];
+        if (seen >= rank) {
+            return std::min(edges_us[i], max_us);
+        }
+    }
+    return max_us;
+}
+
+double FlightMetrics::Histogram::Snapshot::mean_us() const
+{
+    return count == 0 ? 0.0 : static_cast<double>(sum_us) / static_cast<double>(count);
+}
+
+FlightMetrics::Histogram::Snapshot FlightMetrics::Histogram::snapshot() const
+{
+    Snapshot snapshot;
+    for (size_t i = 0; i < bucket_count; ++i) {
+        snapshot.counts[i] = _counts[i].load(std::memory_order_relaxed);
+        snapshot.count += snapshot.counts[i];
+    }
+    snapshot.sum_us = _sum_us.load(std::memory_order_relaxed);
+    snapshot.max_us = _max_us.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+FlightMetrics::FlightMetrics() : _start(Clock::now()) {}
+
+FlightMetrics::~FlightMetrics()
+{
+    detach();
+}
+
+void FlightMetrics::attach(TelemetryBus& bus)
+{
+    if constexpr (enabled) {
+        detach();
+        _bus = &bus;
+
+        _position_subscription =
+            bus.position().subscribe([this](const Stamped<Telemetry::Position>& position) {
+                sample(Stream::Position, position.received());
+            });
+        _attitude_subscription =
+            bus.attitude().subscribe([this](const Stamped<Telemetry::EulerAngle>& attitude) {
+                sample(Stream::Attitude, attitude.received(), attitude.value.timestamp_us);
+            });
+        _velocity_subscription =
+            bus.velocity().subscribe([this](const Stamped<Telemetry::VelocityNed>& velocity) {
+                sample(Stream::VelocityNed, velocity.received());
+            });
+        _in_air_subscription = bus.in_air().subscribe(
+            [this](const Stamped<bool>& in_air) { sample(Stream::InAir, in_air.received()); });
+        _health_subscription =
+            bus.health().subscribe([this](const Stamped<Telemetry::Health>& health) {
+                sample(Stream::Health, health.received());
+            });
+    } else {
+        (void)bus;
+    }
+}
+
+void FlightMetrics::detach()
+{
+    if (_bus == nullptr) {
+        return;
+    }
+    _bus->position().unsubscribe(_position_subscription);
+    _bus->attitude().unsubscribe(_attitude_subscription);
+    _bus->velocity().unsubscribe(_velocity_subscription);
+    _bus->in_air().unsubscribe(_in_air_subscription);
+    _bus->health().unsubscribe(_health_subscription);
+    _bus = nullptr;
+}
+
+void FlightMetrics::stamped(Stream stream, int64_t arrival_us, uint64_t stamp_us)
+{
+    if (stamp_us == 0) {
+        return;
+    }
+    auto& metrics = _streams[static_cast<size_t>(stream)];
+    const int64_t offset = arrival_us - static_cast<int64_t>(stamp_us);
+    auto min = metrics.min_offset_us.load(std::memory_order_relaxed);
+    while (offset < min &&
+           !metrics.min_offset_us.compare_exchange_weak(min, offset, std::memory_order_relaxed)) {
+    }
+    metrics.delay.add(offset - std::min(min, offset));
+}
+
+void FlightMetrics::on_phase_end(
+    const MissionSequencer::Phase& phase,
+    MissionSequencer::Result result,
+    MissionSequencer::Clock::duration elapsed)
+{
+    if constexpr (enabled) {
+        const auto end = Clock::now() - _start;
+        std::lock_guard<std::mutex> lock(_phases_mutex);
+        _phases.push_back(PhaseSpan{phase.name, result, end - elapsed, elapsed});
+    } else {
+        (void)phase;
+        (void)result;
+        (void)elapsed;
+    }
+}
+
+std::vector<FlightMetrics::PhaseSpan> FlightMetrics::phases() const
+{
+    std::lock_guard<std::mutex> lock(_phases_mutex);
+    return _phases;
+}
+
+uint64_t FlightMetrics::samples(Stream stream) const
+{
+    return _streams[static_cast<size_t>(stream)].samples.load(std::memory_order_relaxed);
+}
+
+FlightMetrics::Histogram::Snapshot FlightMetrics::age(Stream stream) const
+{
+    return _streams[static_cast<size_t>(stream)].age.snapshot();
+}
+
+FlightMetrics::Histogram::Snapshot FlightMetrics::delay(Stream stream) const
+{
+    return _streams[static_cast<size_t>(stream)].delay.snapshot();
+}
+
+bool FlightMetrics::write(const std::string& path) const
+{
+    if constexpr (!enabled) {
+        return false;
+    }
+    std::ofstream out(path);
+    if (!out) {
+        return false;
+    }
+    const bool csv = path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0;
+    if (csv) {
+        write_csv(out);
+    } else {
+        write_json(out);
+    }
+    out.flush();
+    return static_cast<bool>(out);
+}
+
+void FlightMetrics::write_json(std::ostream& out) const
+{
+    const auto flags = out.flags();
+    out << std::fixed << std::setprecision(3);
+
+    out << "{\n  \"phases\": [";
+    const auto spans = phases();
+    for (size_t i = 0; i < spans.size(); ++i) {
+        const auto& span = spans[i];
+        out << (i == 0 ? "\n" : ",\n") << "    {\"name\": \"" << span.name
+            << "\", \"result\": \"" << span.result << "\", \"start_ms\": " << to_ms(span.start)
+            << ", \"duration_ms\": " << to_ms(span.duration) << "}";
+    }
+    out << "\n  ],\n  \"streams\": [";
+    bool first = true;
+    for (const auto stream : all_streams) {
+        out << (first ? "\n" : ",\n") << "    {\"name\": \"" << stream
+            << "\", \"samples\": " << samples(stream) << ",\n     \"age\": ";
+        write_histogram_json(out, age(stream));
+        const auto delay_histogram = delay(stream);
+        if (delay_histogram.count > 0) {
+            out << ",\n     \"delay\": ";
+            write_histogram_json(out, delay_histogram);
+        }
+        out << "}";
+        first = false;
+    }
+    out << "\n  ]\n}\n";
+    out.flags(flags);
+}
+
+void FlightMetrics::write_csv(std::ostream& out) const
+{
+    const auto flags = out.flags();
+    out << std::fixed << std::setprecision(3);
+
+    out << "kind,name,result,start_ms,duration_ms,samples,"
+           "age_p50_ms,age_p90_ms,age_p99_ms,age_max_ms,"
+           "delay_p50_ms,delay_p90_ms,delay_p99_ms,delay_max_ms\n";
+    for (const auto& span : phases()) {
+        out << "phase," << span.name << ',' << span.result << ',' << to_ms(span.start) << ','
+            << to_ms(span.duration) << ",,,,,,,,,\n";
+    }
+    for (const auto stream : all_streams) {
+        out << "stream," << stream << ",,,," << samples(stream) << ',';
+        write_histogram_csv(out, age(stream));
+        out << ',';
+        write_histogram_csv(out, delay(stream));
+        out << '\n';
+    }
+    out.flags(flags);
+}
+
+std::ostream& operator<<(std::ostream& str, FlightMetrics::Stream const& stream)
+{
+    switch (stream) {
+        case FlightMetrics::Stream::Position:
+            return str << "position";
+        case FlightMetrics::Stream::Attitude:
+            return str << "attitude";
+        case FlightMetrics::Stream::VelocityNed:
+            return str << "velocity_ned";
+        case FlightMetrics::Stream::InAir:
+            return str << "in_air";
+        case FlightMetrics::Stream::Health:
+            return str << "health";
+        default:
+            return str << "unknown";
+    }
+}
@@ -0,0 +1,204 @@
+#pragma once
+
+// Flight timing and telemetry freshness instrumentation.
+//
+// Records a monotonic-clock span for every mission phase and, per Telemetry
+// stream, a histogram of how old the held sample gets before the next one
+// replaces it. Attitude samples carry the autopilot's timestamp, so for them
+// the transport delay is histogrammed too, relative to the least-delayed
+// sample seen (the two clocks have an unknown offset).
+//
+// Samples come from a TelemetryBus, and their age is measured from the time the
+// bus received them, so the hop to the subscriber's thread does not count. A
+// sample costs a few relaxed atomic increments. Built without
+// ROTATE_HAVE_FLIGHT_METRICS (-DROTATE_FLIGHT_METRICS=OFF) every call is an
+// empty inline function and attach() subscribes to nothing.
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <mavsdk/plugins/telemetry/telemetry.h>
+
+#include "mission_sequencer.h"
+#include "telemetry_bus.h"
+
+class FlightMetrics {
+public:
+#ifdef ROTATE_HAVE_FLIGHT_METRICS
+    static constexpr bool enabled = true;
+#else
+    static constexpr bool enabled = false;
+#endif
+
+    using Clock = std::chrono::steady_clock;
+
+    enum class Stream {
+        Position,
+        Attitude,
+        VelocityNed,
+        InAir,
+        Health,
+    };
+    static constexpr size_t stream_count = 5;
+
+    // Lock-free histogram of durations in microseconds.
+    class Histogram {
+    public:
+        // Upper bucket edges; a last, unbounded bucket follows.
+        static constexpr std::array<int64_t, 15> edges_us{
+            100,
+            200,
+            500,
+            1'000,
+            2'000,
+            5'000,
+            10'000,
+            20'000,
+            50'000,
+            100'000,
+            200'000,
+            500'000,
+            1'000'000,
+            2'000'000,
+            5'000'000};
+        static constexpr size_t bucket_count = edges_us.size() + 1;
+
+        struct Snapshot {
+            std::array<uint64_t, bucket_count> counts{};
+            uint64_t count{0};
+            int64_t sum_us{0};
+            int64_t max_us{0};
+
+            // Upper edge of the bucket holding quantile `q`, capped at max_us.
+            int64_t percentile_us(double q) const;
+            double mean_us() const;
+        };
+
+        void add(int64_t us)
+        {
+            size_t bucket = 0;
+            while (bucket < edges_us.size() && us > edges_us[bucket]) {
+                ++bucket;
+            }
+            _counts[bucket].fetch_add(1, std::memory_order_relaxed);
+            _sum_us.fetch_add(us, std::memory_order_relaxed);
+            auto max = _max_us.load(std::memory_order_relaxed);
+            while (us > max && !_max_us.compare_exchange_weak(max, us, std::memory_order_relaxed)) {
+            }
+        }
+
+        Snapshot snapshot() const;
+
+    private:
+        std::array<std::atomic<uint64_t>, bucket_count> _counts{};
+        std::atomic<int64_t> _sum_us{0};
+        std::atomic<int64_t> _max_us{0};
+    };
+
+    struct PhaseSpan {
+        std::string name;
+        MissionSequencer::Result result{MissionSequencer::Result::Success};
+        // Since the FlightMetrics was created.
+        Clock::duration start{};
+        Clock::duration duration{};
+    };
+
+    FlightMetrics();
+    ~FlightMetrics();
+
+    FlightMetrics(const FlightMetrics&) = delete;
+    FlightMetrics& operator=(const FlightMetrics&) = delete;
+
+    // Subscribes to the bus's position, attitude, velocity, in-air and health
+    // topics. The bus must outlive the metrics, and the metrics must be
+    // detached or outlive the subscriptions.
+    void attach(TelemetryBus& bus);
+    void detach();
+
+    // Call on every sample of `stream` with the time it was received; safe
+    // from several threads.
+    void sample(Stream stream, Clock::time_point received)
+    {
+        if constexpr (enabled) {
+            arrived(stream, since_start_us(received));
+        }
+    }
+    // For samples with an autopilot timestamp (time since boot, in us).
+    void sample(Stream stream, Clock::time_point received, uint64_t stamp_us)
+    {
+        if constexpr (enabled) {
+            const int64_t arrival_us = since_start_us(received);
+            arrived(stream, arrival_us);
+            stamped(stream, arrival_us, stamp_us);
+        }
+    }
+
+    // Has the signature of MissionSequencer::PhaseEndCallback.
+    void on_phase_end(
+        const MissionSequencer::Phase& phase,
+        MissionSequencer::Result result,
+        MissionSequencer::Clock::duration elapsed);
+
+    std::vector<PhaseSpan> phases() const;
+    uint64_t samples(Stream stream) const;
+    Histogram::Snapshot age(Stream stream) const;
+    // Only filled for streams passed to the stamped sample().
+    Histogram::Snapshot delay(Stream stream) const;
+
+    // Writes the summary as JSON, or as CSV if `path` ends in ".csv".
+    // Returns false if the file could not be written, or if built without
+    // instrumentation.
+    bool write(const std::string& path) const;
+    void write_json(std::ostream& out) const;
+    // One row per phase and per stream.
+    void write_csv(std::ostream& out) const;
+
+private:
+    struct StreamMetrics {
+        std::atomic<int64_t> last_arrival_us{-1};
+        // Smallest arrival - stamp, the baseline for delay.
+        std::atomic<int64_t> min_offset_us{INT64_MAX};
+        std::atomic<uint64_t> samples{0};
+        Histogram age;
+        Histogram delay;
+    };
+
+    void arrived(Stream stream, int64_t arrival_us)
+    {
+        auto& metrics = _streams[static_cast<size_t>(stream)];
+        metrics.samples.fetch_add(1, std::memory_order_relaxed);
+        const auto last = metrics.last_arrival_us.exchange(arrival_us, std::memory_order_relaxed);
+        if (last >= 0) {
+            metrics.age.add(arrival_us - last);
+        }
+    }
+    void stamped(Stream stream, int64_t arrival_us, uint64_t stamp_us);
+
+    int64_t since_start_us(Clock::time_point time) const
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(time - _start).count();
+    }
+
+    const Clock::time_point _start;
+    std::array<StreamMetrics, stream_count> _streams{};
+
+    mutable std::mutex _phases_mutex;
+    std::vector<PhaseSpan> _phases;
+
+    TelemetryBus* _bus{nullptr};
+    std::shared_ptr<BusTopic<mavsdk::Telemetry::Position>::Subscription> _position_subscription;
+    std::shared_ptr<BusTopic<mavsdk::Telemetry::EulerAngle>::Subscription> _attitude_subscription;
+    std::shared_ptr<BusTopic<mavsdk::Telemetry::VelocityNed>::Subscription>
+        _velocity_subscription;
+    std::shared_ptr<BusTopic<bool>::Subscription> _in_air_subscription;
+    std::shared_ptr<BusTopic<mavsdk::Telemetry::Health>::Subscription> _health_subscription;
+};
+
+std::ostream& operator<<(std::ostream& str, FlightMetrics::Stream const& stream);
@@ -0,0 +1,84 @@
+#include "flight_profile.h"
+
+#include <chrono>
+#include <cmath>
+#include <fstream>
+
+#include "config_text.h"
+
+namespace {
+
+using config_text::parse_number;
+using config_text::trim;
+
+// Longer waits are surely a typo, and far from overflowing milliseconds.
+constexpr double max_duration_ms = 24.0 * 60.0 * 60.0 * 1000.0;
+
+// Converts `value` only if it is a finite duration in [0, max_duration_ms].
+bool to_milliseconds(double value, std::chrono::milliseconds& duration)
+{
+    if (!std::isfinite(value) || value < 0.0 || value > max_duration_ms) {
+        return false;
+    }
+    duration = std::chrono::milliseconds(static_cast<long>(value));
+    return true;
+}
+
+} // namespace
+
+bool load_mission_params(const std::string& path, MissionParams& params, std::string& error)
+{
+    std::ifstream file(path);
+    if (!file) {
+        error = "cannot read " + path;
+        return false;
+    }
+
+    MissionParams loaded = params;
+    std::string line;
+    for (int number = 1; std::getline(file, line); ++number) {
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty()) {
+            continue;
+        }
+        const auto equals = line.find('=');
+        const auto key = trim(line.substr(0, equals));
+        double value = 0.0;
+        if (equals == std::string::npos || !parse_number(trim(line.substr(equals + 1)), value)) {
+            error = path + ":" + std::to_string(number) + ": expected <key> = <number>";
+            return false;
+        }
+
+        if (key == "takeoff_altitude_m") {
+            loaded.takeoff_altitude_m = static_cast<float>(value);
+        } else if (key == "climb_threshold_m") {
+            loaded.climb_threshold_m = static_cast<float>(value);
+        } else if (key == "target_altitude_m") {
+            loaded.target_altitude_m = static_cast<float>(value);
+        } else if (key == "climb_rate_m_s") {
+            loaded.climb_rate_m_s = static_cast<float>(value);
+        } else if (key == "yaw_rate_deg_s") {
+            loaded.yaw_rate_deg_s = static_cast<float>(value);
+        } else if (key == "max_wait_ms" || key == "health_timeout_ms") {
+            auto& duration = key == "max_wait_ms" ? loaded.max_wait : loaded.health_timeout;
+            if (!to_milliseconds(value, duration)) {
+                error = path + ":" + std::to_string(number) + ": " + key + " must be in [0, 24 h]";
+                return false;
+            }
+        } else if (key == "require_armable") {
+            loaded.require_armable = value != 0.0;
+        } else if (key == "setpoint_rate_hz") {
+            loaded.setpoint_rate_hz = value;
+        } else {
+            error = path + ":" + std::to_string(number) + ": unknown key '" + key + "'";
+            return false;
+        }
+    }
+
+    if (const char* invalid = mission_params_error(loaded)) {
+        error = path + ": " + invalid;
+        return false;
+    }
+    params = loaded;
+    return true;
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+// Flight profiles: MissionParams fixed at compile time or loaded at runtime.
+//
+// A compiled profile is a type with a `static constexpr MissionParams params`.
+// ClimbRotateLaw<Profile> checks it with static_asserts and computes the
+// Offboard setpoints with its rates and period as constants. RuntimeClimbRotateLaw
+// does the same arithmetic from a MissionParams value, e.g. one read by
+// load_mission_params() for an experiment.
+
+#include <chrono>
+#include <cmath>
+#include <string>
+
+#include "mission_params.h"
+#include "setpoint_streamer.h"
+
+// Returns why `params` cannot be flown, or nullptr if they can.
+constexpr const char* mission_params_error(const MissionParams& params)
+{
+    if (!(params.takeoff_altitude_m > 0.0f)) {
+        return "takeoff_altitude_m must be positive";
+    }
+    if (!(params.climb_threshold_m > 0.0f) ||
+        params.climb_threshold_m > params.takeoff_altitude_m) {
+        return "climb_threshold_m must be positive and at most takeoff_altitude_m";
+    }
+    if (!(params.target_altitude_m > params.climb_threshold_m)) {
+        return "target_altitude_m must be above climb_threshold_m";
+    }
+    if (!(params.climb_rate_m_s > 0.0f)) {
+        return "climb_rate_m_s must be positive";
+    }
+    if (!(params.yaw_rate_deg_s >= 0.0f && params.yaw_rate_deg_s <= 360.0f)) {
+        return "yaw_rate_deg_s must be in [0, 360]";
+    }
+    if (params.max_wait.count() <= 0 || params.health_timeout.count() <= 0) {
+        return "max_wait_ms and health_timeout_ms must be positive";
+    }
+    if (!(params.setpoint_rate_hz >= SetpointStreamer::min_rate_hz &&
+          params.setpoint_rate_hz <= SetpointStreamer::max_rate_hz)) {
+        return "setpoint_rate_hz must be within the setpoint streamer's 50-250 Hz";
+    }
+    return nullptr;
+}
+
+namespace flight_profiles {
+
+// rotate's mission on the PX4 x500 in SITL.
+struct X500Sitl {
+    static constexpr MissionParams params{};
+};
+
+} // namespace flight_profiles
+
+// State of the rotate-while-climbing setpoint stream, owned by the streaming
+// thread once it runs.
+struct ClimbRotateState {
+    float yaw_deg{0.0f};
+    SetpointStreamer::Clock::time_point last{};
+    // For laws that follow a trajectory: where the climb started.
+    SetpointStreamer::Clock::time_point climb_start{};
+    float climb_start_yaw_deg{0.0f};
+};
+
+// Setpoint for the tick at `deadline`: climb at climb_rate_m_s and yaw at
+// yaw_rate_deg_s while `climbing`, otherwise hold altitude and heading.
+template<typename Profile> class ClimbRotateLaw {
+public:
+    static constexpr MissionParams params = Profile::params;
+    static_assert(
+        mission_params_error(params) == nullptr,
+        "invalid flight profile; mission_params_error() says which value");
+
+    static constexpr SetpointStreamer::Clock::duration period =
+        std::chrono::duration_cast<SetpointStreamer::Clock::duration>(
+            std::chrono::duration<double>(1.0 / params.setpoint_rate_hz));
+    static constexpr float yaw_step_deg =
+        params.yaw_rate_deg_s * std::chrono::duration<float>(period).count();
+
+    Setpoint next(
+        ClimbRotateState& state, bool climbing, SetpointStreamer::Clock::time_point deadline) const
+    {
+        if (climbing && state.last != SetpointStreamer::Clock::time_point{}) {
+            // Deadlines are whole periods apart, more than one after a miss.
+            const auto ticks = static_cast<float>((deadline - state.last) / period);
+            state.yaw_deg = std::fmod(state.yaw_deg + yaw_step_deg * ticks, 360.0f);
+        }
+        state.last = deadline;
+        return Setpoint::from_velocity(
+            {0.0f, 0.0f, climbing ? -params.climb_rate_m_s : 0.0f, state.yaw_deg});
+    }
+};
+
+class RuntimeClimbRotateLaw {
+public:
+    explicit RuntimeClimbRotateLaw(const MissionParams& params) :
+        _climb_rate_m_s(params.climb_rate_m_s),
+        _yaw_rate_deg_s(params.yaw_rate_deg_s)
+    {}
+
+    Setpoint next(
+        ClimbRotateState& state, bool climbing, SetpointStreamer::Clock::time_point deadline) const
+    {
+        if (climbing && state.last != SetpointStreamer::Clock::time_point{}) {
+            const std::chrono::duration<float> dt = deadline - state.last;
+            state.yaw_deg = std::fmod(state.yaw_deg + _yaw_rate_deg_s * dt.count(), 360.0f);
+        }
+        state.last = deadline;
+        return Setpoint::from_velocity(
+            {0.0f, 0.0f, climbing ? -_climb_rate_m_s : 0.0f, state.yaw_deg});
+    }
+
+private:
+    float _climb_rate_m_s;
+    float _yaw_rate_deg_s;
+};
+
+// Reads `key = value` lines over the defaults in `params`; '#' starts a
+// comment. Keys are the MissionParams field names, with durations as
+// max_wait_ms and health_timeout_ms and require_armable as 0 or 1. Returns
+// false and sets `error` if the file cannot be read, has an unknown key or bad
+// value, or the result fails mission_params_error().
+bool load_mission_params(const std::string& path, MissionParams& params, std::string& error);
@@ -0,0 +1,111 @@
+#pragma once
+
+// On-disk format of the flight recorder.
+//
+// A file is a FileHeader followed by fixed-size Records in the order they
+// were appended. Record timestamps are steady_clock nanoseconds and never go
+// backwards, so a time window can be found by binary search. Payloads are
+// plain structs copied byte for byte and do not depend on MAVSDK's types.
+
+#include <cstdint>
+#include <ostream>
+
+namespace flight_record {
+
+constexpr char magic[8] = {'R', 'O', 'T', 'F', 'L', 'T', '0', '1'};
+constexpr uint32_t version = 1;
+
+enum class Type : uint16_t {
+    Position = 1,
+    Attitude = 2,
+    VelocityNed = 3,
+    InAir = 4,
+    Health = 5,
+};
+
+std::ostream& operator<<(std::ostream& str, Type const& type);
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t capacity;
+    // Number of records, written when the recorder is closed. 0 after a crash,
+    // in which case the reader finds the end by looking for the first record
+    // that was never written.
+    uint64_t record_count;
+    // steady_clock and system_clock at open(), to map record times to wall
+    // clock time.
+    int64_t start_steady_ns;
+    int64_t start_system_ns;
+    uint8_t reserved[16];
+};
+
+struct Record {
+    // steady_clock time the sample was received. Never 0 in a written record.
+    int64_t time_ns;
+    Type type;
+    uint16_t size;
+    uint32_t reserved;
+    uint8_t payload[48];
+};
+
+static_assert(sizeof(FileHeader) == 64, "FileHeader must stay 64 bytes");
+static_assert(sizeof(Record) == 64, "Record must stay 64 bytes");
+
+struct Position {
+    double latitude_deg;
+    double longitude_deg;
+    float absolute_altitude_m;
+    float relative_altitude_m;
+};
+
+struct Attitude {
+    float roll_deg;
+    float pitch_deg;
+    float yaw_deg;
+};
+
+struct VelocityNed {
+    float north_m_s;
+    float east_m_s;
+    float down_m_s;
+};
+
+struct InAir {
+    uint8_t in_air;
+};
+
+struct Health {
+    enum Bits : uint32_t {
+        GyrometerCalibrationOk = 1u << 0,
+        AccelerometerCalibrationOk = 1u << 1,
+        MagnetometerCalibrationOk = 1u << 2,
+        LocalPositionOk = 1u << 3,
+        GlobalPositionOk = 1u << 4,
+        HomePositionOk = 1u << 5,
+        Armable = 1u << 6,
+    };
+    static constexpr uint32_t all_ok = (1u << 7) - 1;
+
+    uint32_t bits;
+};
+
+template<typename T> struct TypeOf;
+template<> struct TypeOf<Position> {
+    static constexpr Type value = Type::Position;
+};
+template<> struct TypeOf<Attitude> {
+    static constexpr Type value = Type::Attitude;
+};
+template<> struct TypeOf<VelocityNed> {
+    static constexpr Type value = Type::VelocityNed;
+};
+template<> struct TypeOf<InAir> {
+    static constexpr Type value = Type::InAir;
+};
+template<> struct TypeOf<Health> {
+    static constexpr Type value = Type::Health;
+};
+
+} // namespace flight_record
@@ -0,0 +1,174 @@
+#include "flight_recorder.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "health_gate.h"
+
+using namespace mavsdk;
+
+FlightRecorder::FlightRecorder() : FlightRecorder(Options{}) {}
+
+FlightRecorder::FlightRecorder(const Options& options) : _options(options) {}
+
+FlightRecorder::~FlightRecorder()
+{
+    detach();
+    close();
+}
+
+bool FlightRecorder::open(const std::string& path)
+{
+    close();
+
+    const size_t capacity = std::max<size_t>(_options.capacity, 1);
+    const size_t bytes =
+        sizeof(flight_record::FileHeader) + capacity * sizeof(flight_record::Record);
+
+    const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    // Allocate the blocks now so appending never has to.
+    if (posix_fallocate(fd, 0, static_cast<off_t>(bytes)) != 0 &&
+        ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+        ::close(fd);
+        return false;
+    }
+    void* mapping = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        ::close(fd);
+        return false;
+    }
+
+    _fd = fd;
+    _mapping = mapping;
+    _mapping_bytes = bytes;
+    _header = static_cast<flight_record::FileHeader*>(mapping);
+    _records = reinterpret_cast<flight_record::Record*>(_header + 1);
+    _capacity = capacity;
+    _next.store(0, std::memory_order_relaxed);
+    _dropped.store(0, std::memory_order_relaxed);
+
+    std::memcpy(_header->magic, flight_record::magic, sizeof(_header->magic));
+    _header->version = flight_record::version;
+    _header->record_size = sizeof(flight_record::Record);
+    _header->capacity = capacity;
+    _header->record_count = 0;
+    _header->start_steady_ns = now_ns();
+    _header->start_system_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::system_clock::now().time_since_epoch())
+                                   .count();
+    return true;
+}
+
+void FlightRecorder::close()
+{
+    if (_mapping == nullptr) {
+        return;
+    }
+    const uint64_t count = recorded();
+    _header->record_count = count;
+
+    munmap(_mapping, _mapping_bytes);
+    // Give back the preallocated space that was never used. If this fails the
+    // file keeps its zeroed tail, and record_count still marks the end.
+    const auto used = static_cast<off_t>(
+        sizeof(flight_record::FileHeader) + count * sizeof(flight_record::Record));
+    const int trimmed = ftruncate(_fd, used);
+    (void)trimmed;
+    ::close(_fd);
+
+    _fd = -1;
+    _mapping = nullptr;
+    _mapping_bytes = 0;
+    _header = nullptr;
+    _records = nullptr;
+}
+
+void FlightRecorder::attach(Telemetry& telemetry)
+{
+    detach();
+    _telemetry = &telemetry;
+
+    _position_handle = telemetry.subscribe_position(
+        [this](Telemetry::Position position) { record_position(position); });
+    _attitude_handle = telemetry.subscribe_attitude_euler(
+        [this](Telemetry::EulerAngle attitude) { record_attitude(attitude); });
+    _velocity_handle = telemetry.subscribe_velocity_ned(
+        [this](Telemetry::VelocityNed velocity) { record_velocity(velocity); });
+    _in_air_handle = telemetry.subscribe_in_air([this](bool in_air) { record_in_air(in_air); });
+    _health_handle =
+        telemetry.subscribe_health([this](Telemetry::Health health) { record_health(health); });
+}
+
+void FlightRecorder::detach()
+{
+    if (_telemetry == nullptr) {
+        return;
+    }
+    _telemetry->unsubscribe_position(_position_handle);
+    _telemetry->unsubscribe_attitude_euler(_attitude_handle);
+    _telemetry->unsubscribe_velocity_ned(_velocity_handle);
+    _telemetry->unsubscribe_in_air(_in_air_handle);
+    _telemetry->unsubscribe_health(_health_handle);
+    _telemetry = nullptr;
+}
+
+void FlightRecorder::record_position(const Telemetry::Position& position)
+{
+    flight_record::Position payload{};
+    payload.latitude_deg = position.latitude_deg;
+    payload.longitude_deg = position.longitude_deg;
+    payload.absolute_altitude_m = position.absolute_altitude_m;
+    payload.relative_altitude_m = position.relative_altitude_m;
+    append(payload);
+}
+
+void FlightRecorder::record_attitude(const Telemetry::EulerAngle& attitude)
+{
+    flight_record::Attitude payload{};
+    payload.roll_deg = attitude.roll_deg;
+    payload.pitch_deg = attitude.pitch_deg;
+    payload.yaw_deg = attitude.yaw_deg;
+    append(payload);
+}
+
+void FlightRecorder::record_velocity(const Telemetry::VelocityNed& velocity)
+{
+    flight_record::VelocityNed payload{};
+    payload.north_m_s = velocity.north_m_s;
+    payload.east_m_s = velocity.east_m_s;
+    payload.down_m_s = velocity.down_m_s;
+    append(payload);
+}
+
+void FlightRecorder::record_in_air(bool in_air)
+{
+    flight_record::InAir payload{};
+    payload.in_air = in_air ? 1 : 0;
+    append(payload);
+}
+
+void FlightRecorder::record_health(const Telemetry::Health& health)
+{
+    flight_record::Health payload{};
+    payload.bits = HealthGate::bits(health);
+    append(payload);
+}
+
+uint64_t FlightRecorder::recorded() const
+{
+    return std::min<uint64_t>(_next.load(std::memory_order_relaxed), _capacity);
+}
+
+int64_t FlightRecorder::now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
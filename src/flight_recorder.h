@@ -0,0 +1,102 @@
+#pragma once
+
+// Binary flight-data recorder.
+//
+// Appends every subscribed Telemetry sample as a fixed-size record to a
+// memory-mapped file (format in flight_record.h). The file is preallocated at
+// open(), so recording a sample is an atomic slot reservation and a memcpy
+// into the mapping, with no syscalls. Samples arriving once the file is full
+// are dropped and counted. Read recordings back with FlightLog.
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include <mavsdk/plugins/telemetry/telemetry.h>
+
+#include "flight_record.h"
+
+class FlightRecorder {
+public:
+    struct Options {
+        // Records preallocated in the file, 64 bytes each. The default holds
+        // about an hour of all streams at their default rates.
+        size_t capacity{1u << 20};
+    };
+
+    FlightRecorder();
+    explicit FlightRecorder(const Options& options);
+    // Detaches and closes.
+    ~FlightRecorder();
+
+    FlightRecorder(const FlightRecorder&) = delete;
+    FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+    // Creates (or truncates) `path` and maps it. Returns false on failure.
+    bool open(const std::string& path);
+    // Writes the record count, trims the file to the records written and
+    // unmaps it. Must not race with record calls; detach() first.
+    void close();
+    bool is_open() const { return _records != nullptr; }
+
+    // Subscribes to position, attitude, velocity, in-air and health. The
+    // recorder must outlive the subscriptions, or detach() must be called first.
+    void attach(mavsdk::Telemetry& telemetry);
+    void detach();
+
+    // Safe to call from several threads. Timestamps are taken when the record
+    // is appended, so they only stay ordered if the callers are serialized,
+    // as MAVSDK's callbacks are.
+    void record_position(const mavsdk::Telemetry::Position& position);
+    void record_attitude(const mavsdk::Telemetry::EulerAngle& attitude);
+    void record_velocity(const mavsdk::Telemetry::VelocityNed& velocity);
+    void record_in_air(bool in_air);
+    void record_health(const mavsdk::Telemetry::Health& health);
+
+    // Records written; still valid after close().
+    uint64_t recorded() const;
+    uint64_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+private:
+    template<typename T> void append(const T& payload)
+    {
+        static_assert(sizeof(T) <= sizeof(flight_record::Record::payload), "payload too large");
+        const auto time_ns = now_ns();
+        if (_records == nullptr) {
+            return;
+        }
+        const auto index = _next.fetch_add(1, std::memory_order_relaxed);
+        if (index >= _capacity) {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        auto& record = _records[index];
+        record.type = flight_record::TypeOf<T>::value;
+        record.size = static_cast<uint16_t>(sizeof(T));
+        std::memcpy(record.payload, &payload, sizeof(T));
+        // Written last: a non-zero time marks the record as complete.
+        record.time_ns = time_ns;
+    }
+
+    static int64_t now_ns();
+
+    const Options _options;
+
+    int _fd{-1};
+    void* _mapping{nullptr};
+    size_t _mapping_bytes{0};
+    flight_record::FileHeader* _header{nullptr};
+    flight_record::Record* _records{nullptr};
+    size_t _capacity{0};
+
+    std::atomic<uint64_t> _next{0};
+    std::atomic<uint64_t> _dropped{0};
+
+    mavsdk::Telemetry* _telemetry{nullptr};
+    mavsdk::Telemetry::PositionHandle _position_handle{};
+    mavsdk::Telemetry::AttitudeEulerHandle _attitude_handle{};
+    mavsdk::Telemetry::VelocityNedHandle _velocity_handle{};
+    mavsdk::Telemetry::InAirHandle _in_air_handle{};
+    mavsdk::Telemetry::HealthHandle _health_handle{};
+};
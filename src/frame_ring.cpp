@@ -0,0 +1,330 @@
+#include "frame_ring.h"
+
+#include <chrono>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr char ring_magic[8] = {'R', 'O', 'T', 'F', 'R', 'M', '0', '1'};
+constexpr uint32_t ring_version = 1;
+// Refcount value of a slot the writer is filling; readers can't pin it.
+constexpr uint32_t writing = 0x80000000u;
+constexpr size_t page_bytes = 4096;
+
+size_t round_up(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// Packs the latest frame into one word so readers load it atomically.
+uint64_t pack_latest(uint64_t sequence, uint32_t slot)
+{
+    return (sequence << 8) | slot;
+}
+
+} // namespace
+
+// Atomics in the mapping must not depend on the process that uses them.
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "need address-free atomics");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "need address-free atomics");
+
+struct FrameRing::Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t slot_count;
+    uint64_t slot_bytes;
+    uint64_t data_offset;
+    // sequence << 8 | slot of the newest frame, 0 before the first one.
+    alignas(64) std::atomic<uint64_t> latest;
+    std::atomic<uint64_t> published;
+    std::atomic<uint64_t> dropped;
+};
+
+struct FrameRing::Slot {
+    alignas(64) std::atomic<uint32_t> refcount;
+    uint32_t encoding;
+    std::atomic<uint64_t> sequence;
+    uint32_t width;
+    uint32_t height;
+    uint32_t step;
+    uint32_t reserved;
+    uint64_t size;
+    int64_t stamp_ns;
+    int64_t publish_ns;
+};
+
+std::unique_ptr<FrameRing>
+FrameRing::create(const std::string& name, uint32_t slots, size_t slot_bytes)
+{
+    if (slots < 2 || slots > max_slots || slot_bytes == 0) {
+        return nullptr;
+    }
+    const size_t data_offset =
+        round_up(sizeof(Header) + slots * sizeof(Slot), page_bytes);
+    const size_t aligned_slot_bytes = round_up(slot_bytes, page_bytes);
+    const size_t bytes = data_offset + slots * aligned_slot_bytes;
+
+    shm_unlink(name.c_str());
+    const int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        return nullptr;
+    }
+    if (ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+        ::close(fd);
+        shm_unlink(name.c_str());
+        return nullptr;
+    }
+
+    std::unique_ptr<FrameRing> ring{new FrameRing()};
+    ring->_name = name;
+    ring->_owner = true;
+    if (!ring->map(fd, bytes)) {
+        shm_unlink(name.c_str());
+        return nullptr;
+    }
+
+    // The mapping is zero-filled, which is a valid state for every atomic.
+    auto& header = *ring->_header;
+    header.version = ring_version;
+    header.slot_count = slots;
+    header.slot_bytes = aligned_slot_bytes;
+    header.data_offset = data_offset;
+    // Written last: readers check the magic before anything else.
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(header.magic, ring_magic, sizeof(header.magic));
+    return ring;
+}
+
+std::unique_ptr<FrameRing> FrameRing::open(const std::string& name)
+{
+    const int fd = shm_open(name.c_str(), O_RDWR, 0);
+    if (fd < 0) {
+        return nullptr;
+    }
+    const off_t bytes = lseek(fd, 0, SEEK_END);
+    if (bytes < static_cast<off_t>(sizeof(Header))) {
+        ::close(fd);
+        return nullptr;
+    }
+
+    std::unique_ptr<FrameRing> ring{new FrameRing()};
+    ring->_name = name;
+    if (!ring->map(fd, static_cast<size_t>(bytes))) {
+        return nullptr;
+    }
+    const auto& header = *ring->_header;
+    if (std::memcmp(header.magic, ring_magic, sizeof(header.magic)) != 0 ||
+        header.version != ring_version || header.slot_count > max_slots ||
+        header.data_offset + header.slot_count * header.slot_bytes > ring->_mapping_bytes) {
+        return nullptr;
+    }
+    return ring;
+}
+
+bool FrameRing::map(int fd, size_t bytes)
+{
+    void* mapping = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    // The mapping stays valid without the descriptor.
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    _mapping = mapping;
+    _mapping_bytes = bytes;
+    _header = static_cast<Header*>(mapping);
+    return true;
+}
+
+FrameRing::~FrameRing()
+{
+    if (_mapping != nullptr) {
+        munmap(_mapping, _mapping_bytes);
+    }
+    if (_owner) {
+        shm_unlink(_name.c_str());
+    }
+}
+
+FrameRing::Slot& FrameRing::slot_at(uint32_t index) const
+{
+    return reinterpret_cast<Slot*>(_header + 1)[index];
+}
+
+uint8_t* FrameRing::data_at(uint32_t index) const
+{
+    return static_cast<uint8_t*>(_mapping) + _header->data_offset +
+           static_cast<size_t>(index) * _header->slot_bytes;
+}
+
+uint8_t* FrameRing::claim(size_t size)
+{
+    if (_claimed >= 0) {
+        // The previous claim was never published; reuse it.
+        const auto slot = static_cast<uint32_t>(_claimed);
+        return size <= _header->slot_bytes ? data_at(slot) : nullptr;
+    }
+    if (size > _header->slot_bytes) {
+        _header->dropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    const uint32_t slots = _header->slot_count;
+    const auto latest = _header->latest.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < slots; ++i) {
+        const uint32_t slot = (_next_slot + i) % slots;
+        // Keep the newest frame readable while the next one is written.
+        if (latest != 0 && (latest & 0xff) == slot) {
+            continue;
+        }
+        uint32_t free = 0;
+        if (slot_at(slot).refcount.compare_exchange_strong(
+                free, writing, std::memory_order_acquire, std::memory_order_relaxed)) {
+            _claimed = slot;
+            _next_slot = (slot + 1) % slots;
+            return data_at(slot);
+        }
+    }
+
+    // Every other slot is pinned by a reader.
+    _header->dropped.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+}
+
+void FrameRing::publish(FrameInfo info)
+{
+    if (_claimed < 0) {
+        return;
+    }
+    const auto slot = static_cast<uint32_t>(_claimed);
+    _claimed = -1;
+
+    const uint64_t sequence = _header->published.load(std::memory_order_relaxed) + 1;
+    auto& header = slot_at(slot);
+    header.encoding = static_cast<uint32_t>(info.encoding);
+    header.width = info.width;
+    header.height = info.height;
+    header.step = info.step;
+    header.size = info.size;
+    header.stamp_ns = info.stamp_ns;
+    header.publish_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now().time_since_epoch())
+                            .count();
+    header.sequence.store(sequence, std::memory_order_relaxed);
+    header.refcount.store(0, std::memory_order_release);
+
+    _header->published.store(sequence, std::memory_order_relaxed);
+    _header->latest.store(pack_latest(sequence, slot), std::memory_order_release);
+}
+
+FrameRing::Frame FrameRing::acquire_latest(uint64_t after_sequence) const
+{
+    Frame frame;
+    // A few retries cover the writer republishing the slot under us.
+    for (int attempt = 0; attempt < 8; ++attempt) {
+        const auto latest = _header->latest.load(std::memory_order_acquire);
+        const uint64_t sequence = latest >> 8;
+        if (latest == 0 || sequence <= after_sequence) {
+            break;
+        }
+        if (try_pin(static_cast<uint32_t>(latest & 0xff), sequence, frame)) {
+            break;
+        }
+    }
+    return frame;
+}
+
+bool FrameRing::try_pin(uint32_t slot, uint64_t sequence, Frame& frame) const
+{
+    if (slot >= _header->slot_count) {
+        return false;
+    }
+    auto& header = slot_at(slot);
+    uint32_t refs = header.refcount.load(std::memory_order_relaxed);
+    do {
+        if ((refs & writing) != 0) {
+            return false;
+        }
+    } while (!header.refcount.compare_exchange_weak(
+        refs, refs + 1, std::memory_order_acquire, std::memory_order_relaxed));
+
+    // Pinned; make sure it still holds the frame we were after.
+    if (header.sequence.load(std::memory_order_relaxed) != sequence) {
+        release(slot);
+        return false;
+    }
+
+    frame._ring = this;
+    frame._slot = slot;
+    frame._data = data_at(slot);
+    frame._info.width = header.width;
+    frame._info.height = header.height;
+    frame._info.step = header.step;
+    frame._info.encoding = static_cast<Encoding>(header.encoding);
+    frame._info.stamp_ns = header.stamp_ns;
+    frame._info.publish_ns = header.publish_ns;
+    frame._info.sequence = sequence;
+    frame._info.size = header.size;
+    return true;
+}
+
+void FrameRing::release(uint32_t slot) const
+{
+    if (slot < _header->slot_count) {
+        slot_at(slot).refcount.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+uint32_t FrameRing::slot_count() const
+{
+    return _header->slot_count;
+}
+
+size_t FrameRing::slot_bytes() const
+{
+    return _header->slot_bytes;
+}
+
+uint64_t FrameRing::published() const
+{
+    return _header->published.load(std::memory_order_relaxed);
+}
+
+uint64_t FrameRing::dropped() const
+{
+    return _header->dropped.load(std::memory_order_relaxed);
+}
+
+FrameRing::Frame::Frame(Frame&& other) noexcept :
+    _ring(other._ring),
+    _slot(other._slot),
+    _data(other._data),
+    _info(other._info)
+{
+    other._ring = nullptr;
+}
+
+FrameRing::Frame& FrameRing::Frame::operator=(Frame&& other) noexcept
+{
+    if (this != &other) {
+        reset();
+        _ring = other._ring;
+        _slot = other._slot;
+        _data = other._data;
+        _info = other._info;
+        other._ring = nullptr;
+    }
+    return *this;
+}
+
+void FrameRing::Frame::reset()
+{
+    if (_ring != nullptr) {
+        _ring->release(_slot);
+        _ring = nullptr;
+        _data = nullptr;
+    }
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+// Shared-memory ring of camera frames with reference-counted slots.
+//
+// One writer process (the ingestion node) copies each incoming frame once into
+// a free slot of a POSIX shared-memory ring and publishes it as the latest
+// frame. Any number of readers, in C++ or in Python through the C API in
+// frame_ring_c.h, map the same memory and pin the latest frame by taking a
+// reference on its slot. They read the pixels in place. The writer never
+// reuses a slot while it is referenced. If every slot is pinned, the frame is
+// dropped and counted. A slot goes back to the writer when its last reference
+// is released.
+//
+// Readers that always take the newest frame never queue up behind a slow
+// consumer: frames they did not get to are simply overwritten.
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+class FrameRing {
+public:
+    static constexpr uint32_t max_slots = 64;
+
+    enum class Encoding : uint32_t {
+        Unknown = 0,
+        Rgb8 = 1,
+        Bgr8 = 2,
+        Mono8 = 3,
+    };
+
+    struct FrameInfo {
+        uint32_t width{0};
+        uint32_t height{0};
+        // Bytes per row.
+        uint32_t step{0};
+        Encoding encoding{Encoding::Unknown};
+        // Capture time from the image header, in ns.
+        int64_t stamp_ns{0};
+        // Set by publish(): steady_clock (CLOCK_MONOTONIC) publish time and
+        // frame number, counting from 1.
+        int64_t publish_ns{0};
+        uint64_t sequence{0};
+        size_t size{0};
+    };
+
+    // A pinned frame. The slot is released when the Frame goes away.
+    class Frame {
+    public:
+        Frame() = default;
+        ~Frame() { reset(); }
+        Frame(Frame&& other) noexcept;
+        Frame& operator=(Frame&& other) noexcept;
+        Frame(const Frame&) = delete;
+        Frame& operator=(const Frame&) = delete;
+
+        explicit operator bool() const { return _ring != nullptr; }
+        const uint8_t* data() const { return _data; }
+        const FrameInfo& info() const { return _info; }
+        uint32_t slot() const { return _slot; }
+
+        void reset();
+        // Gives up ownership without releasing the slot, which then has to be
+        // released with FrameRing::release().
+        void detach() { _ring = nullptr; }
+
+    private:
+        friend class FrameRing;
+
+        const FrameRing* _ring{nullptr};
+        uint32_t _slot{0};
+        const uint8_t* _data{nullptr};
+        FrameInfo _info{};
+    };
+
+    // Creates (replacing any old one) the shared-memory ring `name`, e.g.
+    // "/rotate_frames", for the writer. Returns nullptr on failure.
+    static std::unique_ptr<FrameRing>
+    create(const std::string& name, uint32_t slots, size_t slot_bytes);
+    // Maps an existing ring for reading. Returns nullptr on failure.
+    static std::unique_ptr<FrameRing> open(const std::string& name);
+
+    // Unmaps the ring; the creator also removes its name.
+    ~FrameRing();
+
+    FrameRing(const FrameRing&) = delete;
+    FrameRing& operator=(const FrameRing&) = delete;
+
+    // Writer: claims a free slot of at least `size` bytes for the next frame
+    // and returns where to write it, or nullptr if the frame has to be dropped.
+    uint8_t* claim(size_t size);
+    // Writer: publishes the claimed slot as the latest frame.
+    void publish(FrameInfo info);
+
+    // Reader: pins the latest frame if it is newer than `after_sequence`.
+    // Returns an empty Frame otherwise.
+    Frame acquire_latest(uint64_t after_sequence = 0) const;
+
+    // Releases a slot pinned through the C API.
+    void release(uint32_t slot) const;
+
+    uint32_t slot_count() const;
+    size_t slot_bytes() const;
+    uint64_t published() const;
+    uint64_t dropped() const;
+
+private:
+    struct Header;
+    struct Slot;
+
+    FrameRing() = default;
+    bool map(int fd, size_t bytes);
+    Slot& slot_at(uint32_t index) const;
+    uint8_t* data_at(uint32_t index) const;
+    // Fills `frame` and returns true if `slot` could be pinned at `sequence`.
+    bool try_pin(uint32_t slot, uint64_t sequence, Frame& frame) const;
+
+    std::string _name;
+    bool _owner{false};
+    void* _mapping{nullptr};
+    size_t _mapping_bytes{0};
+    Header* _header{nullptr};
+
+    // Writer state.
+    int64_t _claimed{-1};
+    uint32_t _next_slot{0};
+};
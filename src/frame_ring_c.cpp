@@ -0,0 +1,51 @@
+#include "frame_ring_c.h"
+
+#include "frame_ring.h"
+
+void* frame_ring_open(const char* name)
+{
+    return FrameRing::open(name).release();
+}
+
+void frame_ring_close(void* ring)
+{
+    delete static_cast<FrameRing*>(ring);
+}
+
+int frame_ring_acquire_latest(void* ring, uint64_t after_sequence, frame_ring_frame* frame)
+{
+    auto pinned = static_cast<FrameRing*>(ring)->acquire_latest(after_sequence);
+    if (!pinned) {
+        return 0;
+    }
+    const auto& info = pinned.info();
+    frame->data = pinned.data();
+    frame->sequence = info.sequence;
+    frame->size = info.size;
+    frame->stamp_ns = info.stamp_ns;
+    frame->publish_ns = info.publish_ns;
+    frame->slot = pinned.slot();
+    frame->width = info.width;
+    frame->height = info.height;
+    frame->step = info.step;
+    frame->encoding = static_cast<uint32_t>(info.encoding);
+    // The caller owns the reference now and gives it back with
+    // frame_ring_release().
+    pinned.detach();
+    return 1;
+}
+
+void frame_ring_release(void* ring, uint32_t slot)
+{
+    static_cast<FrameRing*>(ring)->release(slot);
+}
+
+uint64_t frame_ring_published(void* ring)
+{
+    return static_cast<FrameRing*>(ring)->published();
+}
+
+uint64_t frame_ring_dropped(void* ring)
+{
+    return static_cast<FrameRing*>(ring)->dropped();
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+// C API of FrameRing readers, for Python (ctypes) and other non-C++ consumers.
+// See frame_ring.py.
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    // Points into shared memory; valid until frame_ring_release(slot).
+    const uint8_t* data;
+    uint64_t sequence;
+    uint64_t size;
+    int64_t stamp_ns;
+    int64_t publish_ns;
+    uint32_t slot;
+    uint32_t width;
+    uint32_t height;
+    uint32_t step;
+    // 1 = rgb8, 2 = bgr8, 3 = mono8.
+    uint32_t encoding;
+} frame_ring_frame;
+
+// Returns NULL if the ring does not exist.
+void* frame_ring_open(const char* name);
+void frame_ring_close(void* ring);
+
+// Pins the latest frame if it is newer than `after_sequence`. Returns 1 and
+// fills `frame`, or returns 0.
+int frame_ring_acquire_latest(void* ring, uint64_t after_sequence, frame_ring_frame* frame);
+void frame_ring_release(void* ring, uint32_t slot);
+
+uint64_t frame_ring_published(void* ring);
+uint64_t frame_ring_dropped(void* ring);
+
+#ifdef __cplusplus
+}
+#endif
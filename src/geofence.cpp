@@ -0,0 +1,462 @@
+#include "geofence.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <utility>
+
+#include "config_text.h"
+
+namespace {
+
+using config_text::parse_number;
+using config_text::trim;
+
+// Bounds the grid's memory for very large or very elongated fences.
+constexpr uint32_t max_grid_side = 2048;
+// Edges are assigned to every cell they come within this fraction of a cell
+// of, so float rounding cannot leave one out.
+constexpr double cell_margin = 1e-3;
+
+constexpr double earth_radius_m = 6371000.0;
+constexpr double pi = 3.14159265358979323846;
+
+struct Edge {
+    PolygonIndex::Point a;
+    PolygonIndex::Point b;
+};
+
+uint32_t clamp_side(double cells)
+{
+    return static_cast<uint32_t>(std::clamp(std::ceil(cells), 1.0, double{max_grid_side}));
+}
+
+} // namespace
+
+PolygonIndex::PolygonIndex(const std::vector<std::vector<Point>>& polygons, float edges_per_cell)
+{
+    // Every polygon counter-clockwise, so each one adds 1 to the winding
+    // number inside it.
+    std::vector<Edge> edges;
+    Point max{};
+    for (const auto& polygon : polygons) {
+        const size_t count = polygon.size();
+        if (count < 3) {
+            continue;
+        }
+        double twice_area = 0.0;
+        for (size_t i = 0; i < count; ++i) {
+            const auto& a = polygon[i];
+            const auto& b = polygon[(i + 1) % count];
+            twice_area += double{a.x} * b.y - double{b.x} * a.y;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            Edge edge{polygon[i], polygon[(i + 1) % count]};
+            if (twice_area < 0.0) {
+                std::swap(edge.a, edge.b);
+            }
+            if (edge.a.x == edge.b.x && edge.a.y == edge.b.y) {
+                continue;
+            }
+            if (edges.empty()) {
+                _min = edge.a;
+                max = edge.a;
+            }
+            for (const auto& point : {edge.a, edge.b}) {
+                _min = {std::min(_min.x, point.x), std::min(_min.y, point.y)};
+                max = {std::max(max.x, point.x), std::max(max.y, point.y)};
+            }
+            edges.push_back(edge);
+        }
+    }
+    if (edges.empty()) {
+        return;
+    }
+    _edges = edges.size();
+
+    // A little room around the polygons, so points on their outermost edges
+    // still fall into a cell.
+    const float pad = std::max({max.x - _min.x, max.y - _min.y, 1.0f}) * 1e-3f;
+    _min = {_min.x - pad, _min.y - pad};
+    const float width = max.x + pad - _min.x;
+    const float height = max.y + pad - _min.y;
+
+    const double cells = std::max(1.0, static_cast<double>(_edges) / edges_per_cell);
+    _columns = clamp_side(std::sqrt(cells * width / height));
+    _rows = clamp_side(cells / _columns);
+    _cell_width = width / static_cast<float>(_columns);
+    _cell_height = height / static_cast<float>(_rows);
+    _inverse_cell_width = 1.0f / _cell_width;
+    _inverse_cell_height = 1.0f / _cell_height;
+
+    // Calls fn(cell) for every cell the edge passes through, row by row.
+    const auto for_each_cell = [this](const Edge& edge, auto&& fn) {
+        const double x0 = _min.x;
+        const double y0 = _min.y;
+        const double low = std::min(edge.a.y, edge.b.y);
+        const double high = std::max(edge.a.y, edge.b.y);
+        const auto first_row = static_cast<uint32_t>(
+            std::clamp(std::floor((low - y0) / _cell_height - cell_margin), 0.0, _rows - 1.0));
+        const auto last_row = static_cast<uint32_t>(
+            std::clamp(std::floor((high - y0) / _cell_height + cell_margin), 0.0, _rows - 1.0));
+        for (uint32_t row = first_row; row <= last_row; ++row) {
+            // The part of the edge within this row's band.
+            double left = std::min(edge.a.x, edge.b.x);
+            double right = std::max(edge.a.x, edge.b.x);
+            if (edge.a.y != edge.b.y) {
+                const double band_low = y0 + (row - cell_margin) * _cell_height;
+                const double band_high = y0 + (row + 1 + cell_margin) * _cell_height;
+                const double dy = double{edge.b.y} - edge.a.y;
+                double t0 = std::clamp((band_low - edge.a.y) / dy, 0.0, 1.0);
+                double t1 = std::clamp((band_high - edge.a.y) / dy, 0.0, 1.0);
+                const double x_t0 = edge.a.x + t0 * (double{edge.b.x} - edge.a.x);
+                const double x_t1 = edge.a.x + t1 * (double{edge.b.x} - edge.a.x);
+                left = std::min(x_t0, x_t1);
+                right = std::max(x_t0, x_t1);
+            }
+            const auto first_column = static_cast<uint32_t>(std::clamp(
+                std::floor((left - x0) / _cell_width - cell_margin), 0.0, _columns - 1.0));
+            const auto last_column = static_cast<uint32_t>(std::clamp(
+                std::floor((right - x0) / _cell_width + cell_margin), 0.0, _columns - 1.0));
+            for (uint32_t column = first_column; column <= last_column; ++column) {
+                fn(size_t{row} * _columns + column);
+            }
+        }
+    };
+
+    // Entries per cell, padded to whole blocks of lanes.
+    const size_t cell_count = size_t{_rows} * _columns;
+    std::vector<uint32_t> counts(cell_count, 0);
+    for (const auto& edge : edges) {
+        for_each_cell(edge, [&](size_t cell) { ++counts[cell]; });
+    }
+    _cell_begin.resize(cell_count + 1);
+    _cell_begin[0] = 0;
+    for (size_t cell = 0; cell < cell_count; ++cell) {
+        const auto padded = static_cast<uint32_t>((counts[cell] + lanes - 1) / lanes * lanes);
+        _cell_begin[cell + 1] = _cell_begin[cell] + padded;
+    }
+
+    const size_t entries = _cell_begin[cell_count];
+    _ax.assign(entries, 0.0f);
+    _ay.assign(entries, 0.0f);
+    _bx.assign(entries, 0.0f);
+    _by.assign(entries, 0.0f);
+    _center_side.assign(entries, 0.0f);
+    std::fill(counts.begin(), counts.end(), 0);
+    for (const auto& edge : edges) {
+        for_each_cell(edge, [&](size_t cell) {
+            const size_t entry = _cell_begin[cell] + counts[cell]++;
+            const float cx = center_x(static_cast<uint32_t>(cell % _columns));
+            const float cy = center_y(static_cast<uint32_t>(cell / _columns));
+            _ax[entry] = edge.a.x - cx;
+            _ay[entry] = edge.a.y - cy;
+            _bx[entry] = edge.b.x - cx;
+            _by[entry] = edge.b.y - cy;
+            // Same expression as in winding(), on the stored values.
+            _center_side[entry] = (_by[entry] - _ay[entry]) * _ax[entry] -
+                                  (_bx[entry] - _ax[entry]) * _ay[entry];
+        });
+    }
+
+    // Winding number at every cell center: the edges crossing a ray from the
+    // center towards +x, upwards ones +1, downwards ones -1. Gathered per row
+    // of centers, then swept from left to right.
+    std::vector<std::vector<std::pair<double, int>>> crossings(_rows);
+    for (const auto& edge : edges) {
+        const double low = std::min(edge.a.y, edge.b.y);
+        const double high = std::max(edge.a.y, edge.b.y);
+        const auto first_row = static_cast<uint32_t>(
+            std::clamp(std::floor((low - _min.y) / _cell_height - 0.5), 0.0, _rows - 1.0));
+        const auto last_row = static_cast<uint32_t>(
+            std::clamp(std::ceil((high - _min.y) / _cell_height - 0.5), 0.0, _rows - 1.0));
+        for (uint32_t row = first_row; row <= last_row; ++row) {
+            const float cy = center_y(row);
+            if ((edge.a.y > cy) == (edge.b.y > cy)) {
+                continue;
+            }
+            const double x = edge.a.x + (double{cy} - edge.a.y) *
+                                            (double{edge.b.x} - edge.a.x) /
+                                            (double{edge.b.y} - edge.a.y);
+            crossings[row].emplace_back(x, edge.b.y > edge.a.y ? 1 : -1);
+        }
+    }
+    _center_winding.assign(cell_count, 0);
+    for (uint32_t row = 0; row < _rows; ++row) {
+        auto& row_crossings = crossings[row];
+        std::sort(row_crossings.begin(), row_crossings.end());
+        int to_the_right = 0;
+        for (const auto& crossing : row_crossings) {
+            to_the_right += crossing.second;
+        }
+        size_t next = 0;
+        for (uint32_t column = 0; column < _columns; ++column) {
+            const float cx = center_x(column);
+            while (next < row_crossings.size() && row_crossings[next].first <= cx) {
+                to_the_right -= row_crossings[next++].second;
+            }
+            _center_winding[size_t{row} * _columns + column] = to_the_right;
+        }
+    }
+}
+
+float PolygonIndex::center_x(uint32_t column) const
+{
+    return _min.x + (static_cast<float>(column) + 0.5f) * _cell_width;
+}
+
+float PolygonIndex::center_y(uint32_t row) const
+{
+    return _min.y + (static_cast<float>(row) + 0.5f) * _cell_height;
+}
+
+int PolygonIndex::winding(float x, float y) const
+{
+    const float fx = (x - _min.x) * _inverse_cell_width;
+    const float fy = (y - _min.y) * _inverse_cell_height;
+    // Also rejects NaN, and an empty index has no columns.
+    if (!(fx >= 0.0f && fy >= 0.0f && fx < static_cast<float>(_columns) &&
+          fy < static_cast<float>(_rows))) {
+        return 0;
+    }
+    const auto column = static_cast<uint32_t>(fx);
+    const auto row = static_cast<uint32_t>(fy);
+    const size_t cell = size_t{row} * _columns + column;
+
+    // Walk from the cell's center to the point. Every edge the walk crosses
+    // changes the winding number by one: up if the edge runs from the walk's
+    // left to its right, down otherwise. Sides count as left only if
+    // strictly left, so a walk through a vertex counts exactly one of its
+    // two edges.
+    const float dx = x - center_x(column);
+    const float dy = y - center_y(row);
+    int winding = _center_winding[cell];
+
+    const float* ax = _ax.data();
+    const float* ay = _ay.data();
+    const float* bx = _bx.data();
+    const float* by = _by.data();
+    const float* center_side = _center_side.data();
+    const size_t end = _cell_begin[cell + 1];
+    for (size_t block = _cell_begin[cell]; block < end; block += lanes) {
+        for (size_t i = block; i < block + lanes; ++i) {
+            const int a_left = dx * ay[i] - dy * ax[i] > 0.0f;
+            const int b_left = dx * by[i] - dy * bx[i] > 0.0f;
+            const float point_side =
+                center_side[i] + (bx[i] - ax[i]) * dy - (by[i] - ay[i]) * dx;
+            const int crosses = (a_left ^ b_left) & ((center_side[i] > 0.0f) ^ (point_side > 0.0f));
+            winding += crosses * (2 * a_left - 1);
+        }
+    }
+    return winding;
+}
+
+PolygonIndex::Stats PolygonIndex::stats() const
+{
+    Stats stats;
+    stats.columns = _columns;
+    stats.rows = _rows;
+    stats.edges = _edges;
+    if (!_cell_begin.empty()) {
+        stats.cell_entries = _cell_begin.back();
+        for (size_t cell = 0; cell + 1 < _cell_begin.size(); ++cell) {
+            stats.max_cell_entries = std::max<size_t>(
+                stats.max_cell_entries, _cell_begin[cell + 1] - _cell_begin[cell]);
+        }
+    }
+    return stats;
+}
+
+Geofence::Geofence(const Description& description) :
+    _min_altitude_m(description.min_altitude_m),
+    _max_altitude_m(description.max_altitude_m),
+    _response(description.response)
+{
+    // The local plane is centered on the bounding box of all vertices.
+    double min_lat = 90.0;
+    double max_lat = -90.0;
+    double min_lon = 180.0;
+    double max_lon = -180.0;
+    for (const auto* polygons : {&description.inclusion, &description.keep_out}) {
+        for (const auto& polygon : *polygons) {
+            for (const auto& point : polygon) {
+                min_lat = std::min(min_lat, point.latitude_deg);
+                max_lat = std::max(max_lat, point.latitude_deg);
+                min_lon = std::min(min_lon, point.longitude_deg);
+                max_lon = std::max(max_lon, point.longitude_deg);
+            }
+        }
+    }
+    if (min_lat <= max_lat) {
+        _origin = {(min_lat + max_lat) / 2.0, (min_lon + max_lon) / 2.0};
+    }
+    _m_per_deg_lat = earth_radius_m * pi / 180.0;
+    _m_per_deg_lon = _m_per_deg_lat * std::cos(_origin.latitude_deg * pi / 180.0);
+
+    _has_inclusion = !description.inclusion.empty();
+    _inclusion = PolygonIndex(project(description.inclusion));
+    _keep_out = PolygonIndex(project(description.keep_out));
+}
+
+PolygonIndex::Point Geofence::to_local(double latitude_deg, double longitude_deg) const
+{
+    return {
+        static_cast<float>((longitude_deg - _origin.longitude_deg) * _m_per_deg_lon),
+        static_cast<float>((latitude_deg - _origin.latitude_deg) * _m_per_deg_lat)};
+}
+
+std::vector<std::vector<PolygonIndex::Point>>
+Geofence::project(const std::vector<Polygon>& polygons) const
+{
+    std::vector<std::vector<PolygonIndex::Point>> local;
+    local.reserve(polygons.size());
+    for (const auto& polygon : polygons) {
+        auto& points = local.emplace_back();
+        points.reserve(polygon.size());
+        for (const auto& point : polygon) {
+            points.push_back(to_local(point.latitude_deg, point.longitude_deg));
+        }
+    }
+    return local;
+}
+
+Geofence::Breach Geofence::check(const mavsdk::Telemetry::Position& position) const
+{
+    const auto local = to_local(position.latitude_deg, position.longitude_deg);
+    return check_local(local.x, local.y, position.relative_altitude_m);
+}
+
+Geofence::Breach Geofence::check_local(float east_m, float north_m, float altitude_m) const
+{
+    const bool fix = std::isfinite(east_m) && std::isfinite(north_m);
+    if (fix && _has_inclusion && !_inclusion.covers(east_m, north_m)) {
+        return Breach::OutsideFence;
+    }
+    if (fix && _keep_out.covers(east_m, north_m)) {
+        return Breach::InKeepOut;
+    }
+    if (altitude_m > _max_altitude_m) {
+        return Breach::AboveCeiling;
+    }
+    if (altitude_m < _min_altitude_m) {
+        return Breach::BelowFloor;
+    }
+    return Breach::None;
+}
+
+bool load_geofence(const std::string& path, Geofence::Description& description, std::string& error)
+{
+    std::ifstream file(path);
+    if (!file) {
+        error = "cannot read " + path;
+        return false;
+    }
+
+    Geofence::Description loaded;
+    Geofence::Polygon* polygon = nullptr;
+    int polygon_line = 0;
+    const auto polygon_complete = [&]() {
+        if (polygon != nullptr && polygon->size() < 3) {
+            error = path + ":" + std::to_string(polygon_line) +
+                    ": a polygon needs at least 3 vertices";
+            return false;
+        }
+        return true;
+    };
+
+    std::string line;
+    for (int number = 1; std::getline(file, line); ++number) {
+        line = trim(line.substr(0, line.find('#')));
+        if (line.empty()) {
+            continue;
+        }
+        const auto where = path + ":" + std::to_string(number) + ": ";
+
+        if (line == "inclusion" || line == "keep_out") {
+            if (!polygon_complete()) {
+                return false;
+            }
+            auto& polygons = line == "inclusion" ? loaded.inclusion : loaded.keep_out;
+            polygon = &polygons.emplace_back();
+            polygon_line = number;
+            continue;
+        }
+
+        const auto equals = line.find('=');
+        if (equals != std::string::npos) {
+            const auto key = trim(line.substr(0, equals));
+            const auto value = trim(line.substr(equals + 1));
+            double number_value = 0.0;
+            if (key == "response" && (value == "land" || value == "rtl")) {
+                loaded.response = value == "land" ? Geofence::Response::Land :
+                                                    Geofence::Response::ReturnToLaunch;
+            } else if (key == "min_altitude_m" && parse_number(value, number_value)) {
+                loaded.min_altitude_m = static_cast<float>(number_value);
+            } else if (key == "max_altitude_m" && parse_number(value, number_value)) {
+                loaded.max_altitude_m = static_cast<float>(number_value);
+            } else {
+                error = where + "invalid setting '" + line + "'";
+                return false;
+            }
+            continue;
+        }
+
+        const auto comma = line.find(',');
+        Geofence::GeoPoint point;
+        if (comma == std::string::npos ||
+            !parse_number(trim(line.substr(0, comma)), point.latitude_deg) ||
+            !parse_number(trim(line.substr(comma + 1)), point.longitude_deg)) {
+            error = where + "expected <latitude>, <longitude>, a setting or a polygon";
+            return false;
+        }
+        if (polygon == nullptr) {
+            error = where + "vertex before \"inclusion\" or \"keep_out\"";
+            return false;
+        }
+        if (std::abs(point.latitude_deg) > 90.0 || std::abs(point.longitude_deg) > 180.0) {
+            error = where + "latitude or longitude out of range";
+            return false;
+        }
+        polygon->push_back(point);
+    }
+
+    if (!polygon_complete()) {
+        return false;
+    }
+    if (!(loaded.min_altitude_m < loaded.max_altitude_m)) {
+        error = path + ": min_altitude_m must be below max_altitude_m";
+        return false;
+    }
+    description = std::move(loaded);
+    return true;
+}
+
+std::ostream& operator<<(std::ostream& str, Geofence::Breach const& breach)
+{
+    switch (breach) {
+        case Geofence::Breach::None:
+            return str << "None";
+        case Geofence::Breach::OutsideFence:
+            return str << "Outside Fence";
+        case Geofence::Breach::InKeepOut:
+            return str << "In Keep-Out Zone";
+        case Geofence::Breach::AboveCeiling:
+            return str << "Above Ceiling";
+        case Geofence::Breach::BelowFloor:
+            return str << "Below Floor";
+        default:
+            return str << "Unknown";
+    }
+}
+
+std::ostream& operator<<(std::ostream& str, Geofence::Response const& response)
+{
+    switch (response) {
+        case Geofence::Response::Land:
+            return str << "Land";
+        case Geofence::Response::ReturnToLaunch:
+            return str << "Return To Launch";
+        default:
+            return str << "Unknown";
+    }
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+// Geofence and altitude envelope, checked on every position sample.
+//
+// A fence is a set of inclusion polygons the vehicle must stay inside, keep-out
+// polygons it must stay out of, and an altitude floor and ceiling. Polygons are
+// given in latitude/longitude and projected once onto a local east/north plane
+// around the fence's center, which is accurate to well under a metre over the
+// few kilometres a fence spans.
+//
+// Each polygon set is indexed by a PolygonIndex: a uniform grid whose cells
+// know the winding number at their center and hold copies of the edges that
+// pass through them. A check looks up the point's cell and counts the edges the
+// segment from the cell's center to the point crosses, so it costs a handful of
+// edges no matter how many polygons there are. The edge loop has no branches
+// and works on 8-lane blocks of structure-of-arrays floats, which the compiler
+// vectorizes.
+
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <mavsdk/plugins/telemetry/telemetry.h>
+
+// Winding-number point-in-polygon test over a set of simple polygons, through a
+// precomputed grid. A point is covered if it is inside any of the polygons.
+class PolygonIndex {
+public:
+    struct Point {
+        float x{0.0f};
+        float y{0.0f};
+    };
+
+    struct Stats {
+        uint32_t columns{0};
+        uint32_t rows{0};
+        size_t edges{0};
+        // Edge copies over all cells, padding included.
+        size_t cell_entries{0};
+        size_t max_cell_entries{0};
+    };
+
+    PolygonIndex() = default;
+    // Polygons may be in either orientation. `edges_per_cell` trades memory
+    // for the number of edges a check has to look at.
+    explicit PolygonIndex(
+        const std::vector<std::vector<Point>>& polygons, float edges_per_cell = 2.0f);
+
+    // How many of the polygons contain (x, y).
+    int winding(float x, float y) const;
+    bool covers(float x, float y) const { return winding(x, y) > 0; }
+
+    bool empty() const { return _cell_begin.empty(); }
+    Stats stats() const;
+
+private:
+    static constexpr size_t lanes = 8;
+
+    // Cell centers, computed the same way when building and checking.
+    float center_x(uint32_t column) const;
+    float center_y(uint32_t row) const;
+
+    Point _min{};
+    float _cell_width{1.0f};
+    float _cell_height{1.0f};
+    float _inverse_cell_width{1.0f};
+    float _inverse_cell_height{1.0f};
+    uint32_t _columns{0};
+    uint32_t _rows{0};
+    size_t _edges{0};
+
+    // Per cell: its entries are [_cell_begin[i], _cell_begin[i + 1]), a
+    // multiple of `lanes`, and _center_winding[i] is the winding number at
+    // its center.
+    std::vector<uint32_t> _cell_begin;
+    std::vector<int32_t> _center_winding;
+
+    // Per entry, relative to the cell's center: the edge from a to b, and
+    // which side of it the center is on (the cross product (b - a) x (c - a)).
+    // Padding entries are zero-length edges at the center, which never count.
+    std::vector<float> _ax;
+    std::vector<float> _ay;
+    std::vector<float> _bx;
+    std::vector<float> _by;
+    std::vector<float> _center_side;
+};
+
+class Geofence {
+public:
+    struct GeoPoint {
+        double latitude_deg{0.0};
+        double longitude_deg{0.0};
+    };
+    using Polygon = std::vector<GeoPoint>;
+
+    // What the mission does on a breach.
+    enum class Response {
+        Land,
+        ReturnToLaunch,
+    };
+
+    enum class Breach : uint8_t {
+        None,
+        OutsideFence,
+        InKeepOut,
+        AboveCeiling,
+        BelowFloor,
+    };
+
+    struct Description {
+        // With none, only the keep-out zones and altitudes limit the flight.
+        std::vector<Polygon> inclusion;
+        std::vector<Polygon> keep_out;
+        // Relative to home, like Telemetry::Position::relative_altitude_m.
+        float min_altitude_m{std::numeric_limits<float>::lowest()};
+        float max_altitude_m{std::numeric_limits<float>::max()};
+        Response response{Response::Land};
+    };
+
+    explicit Geofence(const Description& description);
+
+    // Thread-safe, does not allocate. A sample without a position fix (NaN
+    // latitude or longitude) is only checked against the altitudes.
+    Breach check(const mavsdk::Telemetry::Position& position) const;
+    // The same on the local plane, in metres from the fence's center.
+    Breach check_local(float east_m, float north_m, float altitude_m) const;
+
+    PolygonIndex::Point to_local(double latitude_deg, double longitude_deg) const;
+
+    Response response() const { return _response; }
+    const PolygonIndex& inclusion() const { return _inclusion; }
+    const PolygonIndex& keep_out() const { return _keep_out; }
+
+private:
+    std::vector<std::vector<PolygonIndex::Point>>
+    project(const std::vector<Polygon>& polygons) const;
+
+    GeoPoint _origin{};
+    double _m_per_deg_lat{0.0};
+    double _m_per_deg_lon{0.0};
+
+    bool _has_inclusion{false};
+    PolygonIndex _inclusion;
+    PolygonIndex _keep_out;
+    float _min_altitude_m;
+    float _max_altitude_m;
+    Response _response;
+};
+
+// Reads a fence file: "inclusion" or "keep_out" on a line of its own starts a
+// polygon, followed by one "<latitude>, <longitude>" vertex per line, and
+// "<key> = <value>" lines set min_altitude_m, max_altitude_m and response
+// (land or rtl). '#' starts a comment. On failure, returns false and sets
+// `error`, leaving `description` alone.
+bool load_geofence(
+    const std::string& path, Geofence::Description& description, std::string& error);
+
+std::ostream& operator<<(std::ostream& str, Geofence::Breach const& breach);
+std::ostream& operator<<(std::ostream& str, Geofence::Response const& response);
@@ -0,0 +1,114 @@
+#include "health_gate.h"
+
+#include <chrono>
+
+using mavsdk::Telemetry;
+
+namespace {
+
+constexpr const char* check_names[] = {
+    "gyrometer",
+    "accelerometer",
+    "magnetometer",
+    "local position",
+    "global position",
+    "home position",
+    "armable",
+};
+
+} // namespace
+
+uint32_t HealthGate::bits(const Telemetry::Health& health)
+{
+    uint32_t bits = 0;
+    bits |= health.is_gyrometer_calibration_ok ? Check::GyrometerCalibrationOk : 0u;
+    bits |= health.is_accelerometer_calibration_ok ? Check::AccelerometerCalibrationOk : 0u;
+    bits |= health.is_magnetometer_calibration_ok ? Check::MagnetometerCalibrationOk : 0u;
+    bits |= health.is_local_position_ok ? Check::LocalPositionOk : 0u;
+    bits |= health.is_global_position_ok ? Check::GlobalPositionOk : 0u;
+    bits |= health.is_home_position_ok ? Check::HomePositionOk : 0u;
+    bits |= health.is_armable ? Check::Armable : 0u;
+    return bits;
+}
+
+std::string HealthGate::names(uint32_t checks)
+{
+    std::string result;
+    for (size_t i = 0; i < check_count; ++i) {
+        if ((checks & (1u << i)) != 0) {
+            if (!result.empty()) {
+                result += ", ";
+            }
+            result += check_names[i];
+        }
+    }
+    return result;
+}
+
+void HealthGate::start(Clock::time_point now)
+{
+    _started = true;
+    _start = now;
+    _seen = 0;
+    update(_bits, now);
+}
+
+void HealthGate::update(uint32_t bits, Clock::time_point now)
+{
+    _bits = bits;
+    if (!_started) {
+        return;
+    }
+    for (size_t i = 0; i < check_count; ++i) {
+        const uint32_t check = 1u << i;
+        if ((bits & check) != 0 && (_seen & check) == 0) {
+            _ready_at[i] = now;
+            _seen |= check;
+        }
+    }
+}
+
+uint32_t HealthGate::last_ready() const
+{
+    uint32_t last = 0;
+    Clock::time_point latest = Clock::time_point::min();
+    for (size_t i = 0; i < check_count; ++i) {
+        const uint32_t check = 1u << i;
+        if ((_required & _seen & check) != 0 && _ready_at[i] >= latest) {
+            latest = _ready_at[i];
+            last = check;
+        }
+    }
+    return last;
+}
+
+HealthGate::Clock::duration HealthGate::ready_after(uint32_t check) const
+{
+    for (size_t i = 0; i < check_count; ++i) {
+        if (check == (1u << i) && (_seen & check) != 0) {
+            return _ready_at[i] - _start;
+        }
+    }
+    return Clock::duration::max();
+}
+
+void HealthGate::print_timeline(std::ostream& str) const
+{
+    bool first = true;
+    for (size_t i = 0; i < check_count; ++i) {
+        const uint32_t check = 1u << i;
+        if ((_required & check) == 0) {
+            continue;
+        }
+        str << (first ? "" : ", ") << check_names[i];
+        first = false;
+        if ((_bits & check) == 0) {
+            str << " missing";
+        } else {
+            str << ' '
+                << std::chrono::duration_cast<std::chrono::milliseconds>(ready_after(check))
+                       .count()
+                << " ms";
+        }
+    }
+}
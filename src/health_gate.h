@@ -0,0 +1,79 @@
+#pragma once
+
+// Readiness gate for arming.
+//
+// Looks at the individual Telemetry::Health checks instead of health_all_ok,
+// so a mission can wait for exactly the checks it needs, continue on the
+// health update that completes them and, when it gives up, say which ones it
+// was still waiting for. Checks are the bits of flight_record::Health.
+//
+// Not thread-safe; RotateMission only touches it inside MissionSequencer
+// updates.
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include <mavsdk/plugins/telemetry/telemetry.h>
+
+#include "flight_record.h"
+#include "mission_params.h"
+#include "mission_sequencer.h"
+
+class HealthGate {
+public:
+    using Clock = MissionSequencer::Clock;
+    using Check = flight_record::Health::Bits;
+
+    // Calibrated sensors and position estimates.
+    static constexpr uint32_t sensors = Check::GyrometerCalibrationOk |
+                                        Check::AccelerometerCalibrationOk |
+                                        Check::MagnetometerCalibrationOk |
+                                        Check::LocalPositionOk | Check::GlobalPositionOk |
+                                        Check::HomePositionOk;
+    // sensors plus the autopilot's own pre-arm verdict: health_all_ok.
+    static constexpr uint32_t all = flight_record::Health::all_ok;
+
+    explicit HealthGate(uint32_t required = all) : _required(required) {}
+    // The checks `params` ask for: all, or sensors without require_armable.
+    explicit HealthGate(const MissionParams& params) :
+        HealthGate(params.require_armable ? all : sensors)
+    {}
+
+    static uint32_t bits(const mavsdk::Telemetry::Health& health);
+    // Comma-separated names of `checks`, e.g. "magnetometer, home position".
+    static std::string names(uint32_t checks);
+
+    uint32_t required() const { return _required; }
+    bool ready(uint32_t bits) const { return (bits & _required) == _required; }
+    uint32_t missing(uint32_t bits) const { return _required & ~bits; }
+
+    // Times readiness from `now` on. Checks that are already ok count as ready
+    // at `now`.
+    void start(Clock::time_point now);
+    // Records a health sample.
+    void update(uint32_t bits, Clock::time_point now);
+
+    // The required check that became ok last since start(): the one that held
+    // up arming. 0 if none is ok yet.
+    uint32_t last_ready() const;
+    // Time from start() until `check` was first ok, or Clock::duration::max()
+    // if it has not been.
+    Clock::duration ready_after(uint32_t check) const;
+
+    // "<check> <ms> ms" for each required check, timed from start(), or
+    // "<check> missing" if it is not ok now.
+    void print_timeline(std::ostream& str) const;
+
+private:
+    static constexpr size_t check_count = 7;
+
+    uint32_t _required;
+    uint32_t _bits{0};
+    bool _started{false};
+    Clock::time_point _start{};
+    std::array<Clock::time_point, check_count> _ready_at{};
+    // Checks with a _ready_at since start().
+    uint32_t _seen{0};
+};
@@ -0,0 +1,411 @@
+#include "image_kernels.h"
+
+#include <atomic>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define IMAGE_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+namespace image_kernels {
+
+namespace {
+
+// Scalar kernels, also used for the tails the SIMD loops leave over.
+
+void rgb_to_bgr_scalar(const uint8_t* src, uint8_t* dst, size_t from_byte, size_t row_bytes)
+{
+    for (size_t x = from_byte; x < row_bytes; x += 3) {
+        dst[x] = src[x + 2];
+        dst[x + 1] = src[x + 1];
+        dst[x + 2] = src[x];
+    }
+}
+
+void downscale_rgb_scalar(
+    const uint8_t* a, const uint8_t* b, uint8_t* dst, uint32_t from_x, uint32_t out_width,
+    bool swap_rb)
+{
+    for (uint32_t x = from_x; x < out_width; ++x) {
+        const uint8_t* pa = a + x * 6;
+        const uint8_t* pb = b + x * 6;
+        for (int c = 0; c < 3; ++c) {
+            const unsigned sum = pa[c] + pa[c + 3] + pb[c] + pb[c + 3];
+            dst[x * 3 + (swap_rb ? 2 - c : c)] = static_cast<uint8_t>((sum + 2) >> 2);
+        }
+    }
+}
+
+void downscale_mono_scalar(
+    const uint8_t* a, const uint8_t* b, uint8_t* dst, uint32_t from_x, uint32_t out_width)
+{
+    for (uint32_t x = from_x; x < out_width; ++x) {
+        const unsigned sum = a[2 * x] + a[2 * x + 1] + b[2 * x] + b[2 * x + 1];
+        dst[x] = static_cast<uint8_t>((sum + 2) >> 2);
+    }
+}
+
+#ifdef IMAGE_KERNELS_X86
+
+// Swaps R and B in five pixels; byte 15 is passed through and rewritten by the
+// next step.
+#define BGR_SWIZZLE 2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, 15
+// Puts the two pixels of each output pixel's channels side by side, for
+// maddubs to add: 4 RGB pixels -> 6 pair sums, optionally in BGR order.
+#define PAIR_RGB 0, 3, 1, 4, 2, 5, 6, 9, 7, 10, 8, 11, -1, -1, -1, -1
+#define PAIR_BGR 2, 5, 1, 4, 0, 3, 8, 11, 7, 10, 6, 9, -1, -1, -1, -1
+// Keeps the 6 valid bytes of each half after packing two groups.
+#define COMPACT 0, 1, 2, 3, 4, 5, 8, 9, 10, 11, 12, 13, -1, -1, -1, -1
+
+void store12(uint8_t* dst, __m128i v)
+{
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), v);
+    const int high = _mm_cvtsi128_si32(_mm_srli_si128(v, 8));
+    std::memcpy(dst + 8, &high, 4);
+}
+
+// The same store compiled as VEX code; calling the SSE one from the AVX2 loop
+// would pay an AVX-SSE transition on every call.
+__attribute__((target("avx2"))) void store12_avx2(uint8_t* dst, __m128i v)
+{
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(dst), v);
+    const int high = _mm_cvtsi128_si32(_mm_srli_si128(v, 8));
+    std::memcpy(dst + 8, &high, 4);
+}
+
+__attribute__((target("sse4.1"))) size_t
+rgb_to_bgr_row_sse41(const uint8_t* src, uint8_t* dst, size_t from_byte, size_t row_bytes)
+{
+    const __m128i mask = _mm_setr_epi8(BGR_SWIZZLE);
+    size_t x = from_byte;
+    for (; x + 16 <= row_bytes; x += 15) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm_shuffle_epi8(v, mask));
+    }
+    return x;
+}
+
+__attribute__((target("avx2"))) size_t
+rgb_to_bgr_row_avx2(const uint8_t* src, uint8_t* dst, size_t row_bytes)
+{
+    const __m256i mask = _mm256_setr_epi8(BGR_SWIZZLE, BGR_SWIZZLE);
+    size_t x = 0;
+    // Ten pixels per step: lanes start at bytes 0 and 15.
+    for (; x + 31 <= row_bytes; x += 30) {
+        const __m256i v = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x))),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x + 15)),
+            1);
+        const __m256i out = _mm256_shuffle_epi8(v, mask);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm256_castsi256_si128(out));
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(dst + x + 15), _mm256_extracti128_si256(out, 1));
+    }
+    return x;
+}
+
+__attribute__((target("sse4.1"))) __m128i
+pair_sums_sse41(const uint8_t* a, const uint8_t* b, __m128i pair, __m128i ones)
+{
+    const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a));
+    const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b));
+    const __m128i sum = _mm_add_epi16(
+        _mm_maddubs_epi16(_mm_shuffle_epi8(va, pair), ones),
+        _mm_maddubs_epi16(_mm_shuffle_epi8(vb, pair), ones));
+    return _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(2)), 2);
+}
+
+__attribute__((target("sse4.1"))) uint32_t downscale_rgb_row_sse41(
+    const uint8_t* a, const uint8_t* b, uint8_t* dst, uint32_t width, bool swap_rb)
+{
+    const __m128i pair = swap_rb ? _mm_setr_epi8(PAIR_BGR) : _mm_setr_epi8(PAIR_RGB);
+    const __m128i compact = _mm_setr_epi8(COMPACT);
+    const __m128i ones = _mm_set1_epi8(1);
+    uint32_t x = 0;
+    // Eight source pixels -> four output pixels; the second load reads 4
+    // bytes past the eighth pixel.
+    for (; size_t{x} * 3 + 28 <= size_t{width} * 3; x += 8) {
+        const size_t offset = size_t{x} * 3;
+        const __m128i lo = pair_sums_sse41(a + offset, b + offset, pair, ones);
+        const __m128i hi = pair_sums_sse41(a + offset + 12, b + offset + 12, pair, ones);
+        store12(dst + offset / 2, _mm_shuffle_epi8(_mm_packus_epi16(lo, hi), compact));
+    }
+    return x / 2;
+}
+
+__attribute__((target("avx2"))) __m256i load_groups_avx2(const uint8_t* row, size_t lo, size_t hi)
+{
+    return _mm256_inserti128_si256(
+        _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + lo))),
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + hi)),
+        1);
+}
+
+__attribute__((target("avx2"))) __m256i pair_sums_avx2(
+    const uint8_t* a, const uint8_t* b, size_t lo, size_t hi, __m256i pair, __m256i ones)
+{
+    const __m256i sum = _mm256_add_epi16(
+        _mm256_maddubs_epi16(_mm256_shuffle_epi8(load_groups_avx2(a, lo, hi), pair), ones),
+        _mm256_maddubs_epi16(_mm256_shuffle_epi8(load_groups_avx2(b, lo, hi), pair), ones));
+    return _mm256_srli_epi16(_mm256_add_epi16(sum, _mm256_set1_epi16(2)), 2);
+}
+
+__attribute__((target("avx2"))) uint32_t downscale_rgb_row_avx2(
+    const uint8_t* a, const uint8_t* b, uint8_t* dst, uint32_t width, bool swap_rb)
+{
+    const __m256i pair = swap_rb ? _mm256_setr_epi8(PAIR_BGR, PAIR_BGR) :
+                                   _mm256_setr_epi8(PAIR_RGB, PAIR_RGB);
+    const __m256i compact = _mm256_setr_epi8(COMPACT, COMPACT);
+    const __m256i ones = _mm256_set1_epi8(1);
+    uint32_t x = 0;
+    // Sixteen source pixels in four groups of four. Lane 0 gets groups 0 and
+    // 1, lane 1 groups 2 and 3, so packing keeps them in order.
+    for (; size_t{x} * 3 + 52 <= size_t{width} * 3; x += 16) {
+        const size_t offset = size_t{x} * 3;
+        const __m256i first = pair_sums_avx2(a, b, offset, offset + 24, pair, ones);
+        const __m256i second = pair_sums_avx2(a, b, offset + 12, offset + 36, pair, ones);
+        const __m256i out = _mm256_shuffle_epi8(_mm256_packus_epi16(first, second), compact);
+        store12_avx2(dst + offset / 2, _mm256_castsi256_si128(out));
+        store12_avx2(dst + offset / 2 + 12, _mm256_extracti128_si256(out, 1));
+    }
+    return x / 2;
+}
+
+__attribute__((target("sse4.1"))) uint32_t
+downscale_mono_row_sse41(const uint8_t* a, const uint8_t* b, uint8_t* dst, uint32_t width)
+{
+    const __m128i ones = _mm_set1_epi8(1);
+    const __m128i two = _mm_set1_epi16(2);
+    uint32_t x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + x));
+        const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + x));
+        __m128i sum = _mm_add_epi16(_mm_maddubs_epi16(va, ones), _mm_maddubs_epi16(vb, ones));
+        sum = _mm_srli_epi16(_mm_add_epi16(sum, two), 2);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + x / 2), _mm_packus_epi16(sum, sum));
+    }
+    return x / 2;
+}
+
+__attribute__((target("avx2"))) uint32_t
+downscale_mono_row_avx2(const uint8_t* a, const uint8_t* b, uint8_t* dst, uint32_t width)
+{
+    const __m256i ones = _mm256_set1_epi8(1);
+    const __m256i two = _mm256_set1_epi16(2);
+    uint32_t x = 0;
+    for (; x + 32 <= width; x += 32) {
+        const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + x));
+        const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + x));
+        __m256i sum =
+            _mm256_add_epi16(_mm256_maddubs_epi16(va, ones), _mm256_maddubs_epi16(vb, ones));
+        sum = _mm256_srli_epi16(_mm256_add_epi16(sum, two), 2);
+        // packus works per lane; gather the low halves of both lanes.
+        const __m256i packed =
+            _mm256_permute4x64_epi64(_mm256_packus_epi16(sum, sum), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(dst + x / 2), _mm256_castsi256_si128(packed));
+    }
+    return x / 2;
+}
+
+#undef BGR_SWIZZLE
+#undef PAIR_RGB
+#undef PAIR_BGR
+#undef COMPACT
+
+#endif // IMAGE_KERNELS_X86
+
+Isa detect_isa()
+{
+#ifdef IMAGE_KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return Isa::Avx2;
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        return Isa::Sse41;
+    }
+#endif
+    return Isa::Scalar;
+}
+
+std::atomic<Isa>& active_isa()
+{
+    static std::atomic<Isa> active{best_isa()};
+    return active;
+}
+
+} // namespace
+
+Isa best_isa()
+{
+    static const Isa best = detect_isa();
+    return best;
+}
+
+Isa isa()
+{
+    return active_isa().load(std::memory_order_relaxed);
+}
+
+void set_isa(Isa isa)
+{
+    active_isa().store(
+        static_cast<int>(isa) <= static_cast<int>(best_isa()) ? isa : best_isa(),
+        std::memory_order_relaxed);
+}
+
+void rgb_to_bgr(
+    const uint8_t* src,
+    size_t src_step,
+    uint8_t* dst,
+    size_t dst_step,
+    uint32_t width,
+    uint32_t height)
+{
+    const size_t row_bytes = size_t{width} * 3;
+    const Isa active = isa();
+    for (uint32_t y = 0; y < height; ++y) {
+        const uint8_t* s = src + y * src_step;
+        uint8_t* d = dst + y * dst_step;
+        size_t x = 0;
+#ifdef IMAGE_KERNELS_X86
+        if (active == Isa::Avx2) {
+            x = rgb_to_bgr_row_avx2(s, d, row_bytes);
+        }
+        if (active != Isa::Scalar) {
+            x = rgb_to_bgr_row_sse41(s, d, x, row_bytes);
+        }
+#else
+        (void)active;
+#endif
+        rgb_to_bgr_scalar(s, d, x, row_bytes);
+    }
+}
+
+void copy_mono(
+    const uint8_t* src,
+    size_t src_step,
+    uint8_t* dst,
+    size_t dst_step,
+    uint32_t width,
+    uint32_t height)
+{
+    if (src_step == width && dst_step == width) {
+        std::memcpy(dst, src, size_t{width} * height);
+        return;
+    }
+    for (uint32_t y = 0; y < height; ++y) {
+        std::memcpy(dst + y * dst_step, src + y * src_step, width);
+    }
+}
+
+void downscale2x_rgb(
+    const uint8_t* src,
+    size_t src_step,
+    uint8_t* dst,
+    size_t dst_step,
+    uint32_t width,
+    uint32_t height,
+    bool swap_rb)
+{
+    const uint32_t out_width = width / 2;
+    const Isa active = isa();
+    for (uint32_t y = 0; y < height / 2; ++y) {
+        const uint8_t* a = src + (2 * y) * src_step;
+        const uint8_t* b = a + src_step;
+        uint8_t* d = dst + y * dst_step;
+        uint32_t x = 0;
+#ifdef IMAGE_KERNELS_X86
+        if (active == Isa::Avx2) {
+            x = downscale_rgb_row_avx2(a, b, d, width, swap_rb);
+        } else if (active == Isa::Sse41) {
+            x = downscale_rgb_row_sse41(a, b, d, width, swap_rb);
+        }
+#else
+        (void)active;
+#endif
+        downscale_rgb_scalar(a, b, d, x, out_width, swap_rb);
+    }
+}
+
+void downscale2x_mono(
+    const uint8_t* src,
+    size_t src_step,
+    uint8_t* dst,
+    size_t dst_step,
+    uint32_t width,
+    uint32_t height)
+{
+    const uint32_t out_width = width / 2;
+    const Isa active = isa();
+    for (uint32_t y = 0; y < height / 2; ++y) {
+        const uint8_t* a = src + (2 * y) * src_step;
+        const uint8_t* b = a + src_step;
+        uint8_t* d = dst + y * dst_step;
+        uint32_t x = 0;
+#ifdef IMAGE_KERNELS_X86
+        if (active == Isa::Avx2) {
+            x = downscale_mono_row_avx2(a, b, d, width);
+        } else if (active == Isa::Sse41) {
+            x = downscale_mono_row_sse41(a, b, d, width);
+        }
+#else
+        (void)active;
+#endif
+        downscale_mono_scalar(a, b, d, x, out_width);
+    }
+}
+
+void to_display(
+    Format format,
+    const uint8_t* src,
+    size_t src_step,
+    uint8_t* dst,
+    size_t dst_step,
+    uint32_t width,
+    uint32_t height,
+    bool downscale)
+{
+    switch (format) {
+        case Format::Rgb8:
+            if (downscale) {
+                downscale2x_rgb(src, src_step, dst, dst_step, width, height, true);
+            } else {
+                rgb_to_bgr(src, src_step, dst, dst_step, width, height);
+            }
+            break;
+        case Format::Bgr8:
+            if (downscale) {
+                downscale2x_rgb(src, src_step, dst, dst_step, width, height, false);
+            } else {
+                // Already BGR: a plain copy of width * 3 bytes per row.
+                copy_mono(src, src_step, dst, dst_step, width * 3, height);
+            }
+            break;
+        case Format::Mono8:
+            if (downscale) {
+                downscale2x_mono(src, src_step, dst, dst_step, width, height);
+            } else {
+                copy_mono(src, src_step, dst, dst_step, width, height);
+            }
+            break;
+    }
+}
+
+std::ostream& operator<<(std::ostream& str, Isa const& isa)
+{
+    switch (isa) {
+        case Isa::Scalar:
+            return str << "scalar";
+        case Isa::Sse41:
+            return str << "sse4.1";
+        case Isa::Avx2:
+            return str << "avx2";
+        default:
+            return str << "unknown";
+    }
+}
+
+} // namespace image_kernels
@@ -0,0 +1,101 @@
+#pragma once
+
+// Camera frame kernels: RGB8 -> BGR8 swizzle, mono8 passthrough and 2x area
+// downscale (the mean of each 2x2 block, like cv::resize with INTER_AREA at
+// fx = fy = 0.5), with the swizzle fused into the downscale so a frame is read
+// once.
+//
+// Each kernel has scalar, SSE4.1 and AVX2 versions. The best one the CPU
+// supports is picked at runtime, so the library needs no special compiler
+// flags. Rows may be padded: every kernel takes a source and destination step
+// in bytes. Downscaling drops an odd last row or column.
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+namespace image_kernels {
+
+enum class Isa {
+    Scalar,
+    Sse41,
+    Avx2,
+};
+
+std::ostream& operator<<(std::ostream& str, Isa const& isa);
+
+// Best instruction set this CPU supports.
+Isa best_isa();
+// Instruction set the kernels use; best_isa() unless set_isa() lowered it.
+Isa isa();
+// For benchmarks: use `isa`, or best_isa() if the CPU lacks it.
+void set_isa(Isa isa);
+
+enum class Format {
+    Rgb8,
+    Bgr8,
+    Mono8,
+};
+
+void rgb_to_bgr(
+    const uint8_t* src,
+    size_t src_step,
+    uint8_t* dst,
+    size_t dst_step,
+    uint32_t width,
+    uint32_t height);
+
+void copy_mono(
+    const uint8_t* src,
+    size_t src_step,
+    uint8_t* dst,
+    size_t dst_step,
+    uint32_t width,
+    uint32_t height);
+
+// `width` and `height` are the source size; dst is width / 2 x height / 2.
+// With `swap_rb` the output has red and blue exchanged.
+void downscale2x_rgb(
+    const uint8_t* src,
+    size_t src_step,
+    uint8_t* dst,
+    size_t dst_step,
+    uint32_t width,
+    uint32_t height,
+    bool swap_rb);
+
+void downscale2x_mono(
+    const uint8_t* src,
+    size_t src_step,
+    uint8_t* dst,
+    size_t dst_step,
+    uint32_t width,
+    uint32_t height);
+
+// Converts a frame to what OpenCV displays (BGR8 or mono8) in one pass,
+// halving it first if `downscale` is set.
+void to_display(
+    Format format,
+    const uint8_t* src,
+    size_t src_step,
+    uint8_t* dst,
+    size_t dst_step,
+    uint32_t width,
+    uint32_t height,
+    bool downscale);
+
+// Output size of to_display() and its bytes per pixel.
+inline uint32_t output_width(uint32_t width, bool downscale)
+{
+    return downscale ? width / 2 : width;
+}
+inline uint32_t output_height(uint32_t height, bool downscale)
+{
+    return downscale ? height / 2 : height;
+}
+inline uint32_t channels(Format format)
+{
+    return format == Format::Mono8 ? 1 : 3;
+}
+
+} // namespace image_kernels
@@ -0,0 +1,185 @@
+#include "mavlink_lite.h"
+
+namespace mavlink_lite {
+
+namespace {
+
+constexpr uint8_t stx_v1 = 0xFE;
+constexpr uint8_t stx_v2 = 0xFD;
+constexpr size_t header_len_v1 = 6;
+constexpr size_t header_len_v2 = 10;
+constexpr uint8_t incompat_flag_signed = 0x01;
+constexpr size_t signature_len = 13;
+
+} // namespace
+
+bool crc_extra(uint32_t msgid, uint8_t& extra)
+{
+    switch (msgid) {
+        case msg::heartbeat:
+            extra = 50;
+            return true;
+        case msg::sys_status:
+            extra = 124;
+            return true;
+        case msg::param_request_read:
+            extra = 214;
+            return true;
+        case msg::param_request_list:
+            extra = 159;
+            return true;
+        case msg::param_value:
+            extra = 220;
+            return true;
+        case msg::param_set:
+            extra = 168;
+            return true;
+        case msg::gps_raw_int:
+            extra = 24;
+            return true;
+        case msg::attitude:
+            extra = 39;
+            return true;
+        case msg::local_position_ned:
+            extra = 185;
+            return true;
+        case msg::global_position_int:
+            extra = 104;
+            return true;
+        case msg::command_int:
+            extra = 158;
+            return true;
+        case msg::command_long:
+            extra = 152;
+            return true;
+        case msg::command_ack:
+            extra = 143;
+            return true;
+        case msg::set_position_target_local_ned:
+            extra = 143;
+            return true;
+        case msg::autopilot_version:
+            extra = 178;
+            return true;
+        case msg::home_position:
+            extra = 104;
+            return true;
+        case msg::extended_sys_state:
+            extra = 130;
+            return true;
+        default:
+            return false;
+    }
+}
+
+uint16_t crc_accumulate(const uint8_t* data, size_t length, uint16_t crc)
+{
+    for (size_t i = 0; i < length; ++i) {
+        uint8_t tmp = data[i] ^ static_cast<uint8_t>(crc & 0xFF);
+        tmp ^= static_cast<uint8_t>(tmp << 4);
+        crc = static_cast<uint16_t>(
+            (crc >> 8) ^ (static_cast<uint16_t>(tmp) << 8) ^ (static_cast<uint16_t>(tmp) << 3) ^
+            (tmp >> 4));
+    }
+    return crc;
+}
+
+size_t encode(const Message& message, uint8_t* frame)
+{
+    uint8_t extra;
+    if (!crc_extra(message.msgid, extra)) {
+        return 0;
+    }
+
+    // MAVLink 2 drops trailing zeros but always keeps at least one byte.
+    size_t len = message.len;
+    while (len > 1 && message.payload[len - 1] == 0) {
+        --len;
+    }
+
+    frame[0] = stx_v2;
+    frame[1] = static_cast<uint8_t>(len);
+    frame[2] = 0; // incompat flags
+    frame[3] = 0; // compat flags
+    frame[4] = message.seq;
+    frame[5] = message.sysid;
+    frame[6] = message.compid;
+    frame[7] = static_cast<uint8_t>(message.msgid & 0xFF);
+    frame[8] = static_cast<uint8_t>((message.msgid >> 8) & 0xFF);
+    frame[9] = static_cast<uint8_t>((message.msgid >> 16) & 0xFF);
+    std::memcpy(frame + header_len_v2, message.payload.data(), len);
+
+    uint16_t crc = crc_accumulate(frame + 1, header_len_v2 - 1 + len);
+    crc = crc_accumulate(&extra, 1, crc);
+    frame[header_len_v2 + len] = static_cast<uint8_t>(crc & 0xFF);
+    frame[header_len_v2 + len + 1] = static_cast<uint8_t>(crc >> 8);
+    return header_len_v2 + len + 2;
+}
+
+size_t decode(const uint8_t* data, size_t length, Message& message, bool& decoded)
+{
+    decoded = false;
+
+    size_t start = 0;
+    while (start < length && data[start] != stx_v1 && data[start] != stx_v2) {
+        ++start;
+    }
+    if (start == length) {
+        return 0;
+    }
+
+    const uint8_t* frame = data + start;
+    const size_t available = length - start;
+    const bool v2 = frame[0] == stx_v2;
+    const size_t header_len = v2 ? header_len_v2 : header_len_v1;
+    if (available < header_len) {
+        return 0;
+    }
+
+    const uint8_t payload_len = frame[1];
+    size_t frame_len = header_len + payload_len + 2;
+    if (v2 && (frame[2] & incompat_flag_signed) != 0) {
+        frame_len += signature_len;
+    }
+    if (available < frame_len) {
+        return 0;
+    }
+
+    // Consume at least the start byte so a bad frame is skipped.
+    const size_t consumed = start + frame_len;
+
+    Message result;
+    result.len = payload_len;
+    if (v2) {
+        result.seq = frame[4];
+        result.sysid = frame[5];
+        result.compid = frame[6];
+        result.msgid = static_cast<uint32_t>(frame[7]) | (static_cast<uint32_t>(frame[8]) << 8) |
+                       (static_cast<uint32_t>(frame[9]) << 16);
+    } else {
+        result.seq = frame[2];
+        result.sysid = frame[3];
+        result.compid = frame[4];
+        result.msgid = frame[5];
+    }
+
+    uint8_t extra;
+    if (!crc_extra(result.msgid, extra)) {
+        return consumed;
+    }
+
+    uint16_t crc = crc_accumulate(frame + 1, header_len - 1 + payload_len);
+    crc = crc_accumulate(&extra, 1, crc);
+    const uint16_t received = static_cast<uint16_t>(
+        frame[header_len + payload_len] | (frame[header_len + payload_len + 1] << 8));
+    if (crc != received) {
+        return start + 1;
+    }
+
+    std::memcpy(result.payload.data(), frame + header_len, payload_len);
+    message = result;
+    decoded = true;
+    return consumed;
+}
+
+} // namespace mavlink_lite
@@ -0,0 +1,116 @@
+#pragma once
+
+// Minimal MAVLink framing for the mock autopilot.
+//
+// Covers MAVLink 1 and 2 framing (no signing) and only the messages the mock
+// sends or understands. Payloads are read and written field by field in wire
+// order (largest type first, then declaration order, extensions last).
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace mavlink_lite {
+
+namespace msg {
+constexpr uint32_t heartbeat = 0;
+constexpr uint32_t sys_status = 1;
+constexpr uint32_t param_request_read = 20;
+constexpr uint32_t param_request_list = 21;
+constexpr uint32_t param_value = 22;
+constexpr uint32_t param_set = 23;
+constexpr uint32_t gps_raw_int = 24;
+constexpr uint32_t attitude = 30;
+constexpr uint32_t local_position_ned = 32;
+constexpr uint32_t global_position_int = 33;
+constexpr uint32_t command_int = 75;
+constexpr uint32_t command_long = 76;
+constexpr uint32_t command_ack = 77;
+constexpr uint32_t set_position_target_local_ned = 84;
+constexpr uint32_t autopilot_version = 148;
+constexpr uint32_t home_position = 242;
+constexpr uint32_t extended_sys_state = 245;
+} // namespace msg
+
+constexpr size_t max_payload_len = 255;
+// v2 header (10) + payload + checksum (2).
+constexpr size_t max_frame_len = 10 + max_payload_len + 2;
+
+struct Message {
+    uint32_t msgid{0};
+    uint8_t sysid{0};
+    uint8_t compid{0};
+    uint8_t seq{0};
+    uint8_t len{0};
+    // Zero-padded past `len`, so truncated MAVLink 2 payloads read as zeros.
+    std::array<uint8_t, max_payload_len> payload{};
+};
+
+// CRC_EXTRA seed of a supported message. Returns false for unknown messages.
+bool crc_extra(uint32_t msgid, uint8_t& extra);
+
+// X.25 / MCRF4XX checksum as used by MAVLink.
+uint16_t crc_accumulate(const uint8_t* data, size_t length, uint16_t crc = 0xFFFF);
+
+// Encodes `message` as a MAVLink 2 frame into `frame` (at least max_frame_len
+// bytes), trimming trailing zero bytes of the payload. Returns the frame
+// length, or 0 for unknown messages.
+size_t encode(const Message& message, uint8_t* frame);
+
+// Decodes the next frame in `data`. Skips garbage and frames with unknown ids
+// or bad checksums. Returns the number of bytes consumed, 0 once the buffer has
+// no complete frame left; `decoded` tells whether `message` was filled in.
+size_t decode(const uint8_t* data, size_t length, Message& message, bool& decoded);
+
+// Sequential little-endian payload writer.
+class PayloadWriter {
+public:
+    explicit PayloadWriter(Message& message) : _message(message) {}
+
+    template<typename T> PayloadWriter& put(T value)
+    {
+        std::memcpy(_message.payload.data() + _message.len, &value, sizeof(T));
+        _message.len = static_cast<uint8_t>(_message.len + sizeof(T));
+        return *this;
+    }
+
+    PayloadWriter& put_chars(const char* text, size_t size)
+    {
+        std::memset(_message.payload.data() + _message.len, 0, size);
+        std::strncpy(reinterpret_cast<char*>(_message.payload.data() + _message.len), text, size);
+        _message.len = static_cast<uint8_t>(_message.len + size);
+        return *this;
+    }
+
+private:
+    Message& _message;
+};
+
+// Sequential little-endian payload reader.
+class PayloadReader {
+public:
+    explicit PayloadReader(const Message& message) : _message(message) {}
+
+    template<typename T> T get()
+    {
+        T value;
+        std::memcpy(&value, _message.payload.data() + _offset, sizeof(T));
+        _offset += sizeof(T);
+        return value;
+    }
+
+    // Copies a fixed-size char field and terminates it.
+    void get_chars(char* out, size_t size)
+    {
+        std::memcpy(out, _message.payload.data() + _offset, size);
+        out[size] = '\0';
+        _offset += size;
+    }
+
+private:
+    const Message& _message;
+    size_t _offset{0};
+};
+
+} // namespace mavlink_lite
@@ -0,0 +1,27 @@
+#pragma once
+
+// Parameters of the takeoff -> rotate while climbing -> hover -> land mission,
+// shared by rotate's single-vehicle mission and fleet mode. A literal type, so
+// flight profiles can be constexpr and checked at compile time
+// (flight_profile.h).
+
+#include <chrono>
+
+struct MissionParams {
+    float takeoff_altitude_m{1.75f};
+    // Offboard rotate-while-climbing starts above this altitude...
+    float climb_threshold_m{1.7f};
+    // ...and climbs to this one.
+    float target_altitude_m{5.0f};
+    float climb_rate_m_s{0.5f};
+    float yaw_rate_deg_s{45.0f};
+    // Time from takeoff until landing is commanded.
+    std::chrono::milliseconds max_wait{std::chrono::seconds(20)};
+    // How long to wait for a vehicle to become healthy before giving up.
+    std::chrono::milliseconds health_timeout{std::chrono::seconds(60)};
+    // Whether the health gate also waits for the autopilot's is_armable, or
+    // only for calibrated sensors and position estimates (health_gate.h).
+    bool require_armable{true};
+    // Offboard setpoint stream rate.
+    double setpoint_rate_hz{50.0};
+};
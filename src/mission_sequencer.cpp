@@ -0,0 +1,170 @@
+#include "mission_sequencer.h"
+
+#include <utility>
+
+#include "alloc_tracker.h"
+
+MissionSequencer::Phase& MissionSequencer::add_phase(std::string name)
+{
+    _phases.emplace_back();
+    _phases.back().name = std::move(name);
+    return _phases.back();
+}
+
+void MissionSequencer::set_phase_end_callback(PhaseEndCallback callback)
+{
+    _phase_end_callback = std::move(callback);
+}
+
+void MissionSequencer::set_clock(std::function<Clock::time_point()> clock)
+{
+    _clock = std::move(clock);
+}
+
+MissionSequencer::Clock::time_point MissionSequencer::now() const
+{
+    return _clock ? _clock() : Clock::now();
+}
+
+void MissionSequencer::advance()
+{
+    update([](FlightState&) {});
+}
+
+bool MissionSequencer::wait_idle()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _idle_cv.wait(lock, [this]() { return _waiting || _finished; });
+    return !_finished;
+}
+
+MissionSequencer::Clock::time_point MissionSequencer::next_deadline() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _waiting ? _deadline : Clock::time_point::max();
+}
+
+FlightState MissionSequencer::state() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _state;
+}
+
+MissionSequencer::Result MissionSequencer::run()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _finished = false;
+    }
+
+    auto result = Result::Success;
+    for (const auto& phase : _phases) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _last_phase = phase.name;
+        }
+        alloc_tracking::set_phase(phase.name.c_str());
+
+        const auto started = now();
+        result = run_phase(phase);
+
+        if (_phase_end_callback) {
+            _phase_end_callback(phase, result, now() - started);
+        }
+        if (result != Result::Success) {
+            break;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _finished = true;
+    }
+    _idle_cv.notify_all();
+    return result;
+}
+
+MissionSequencer::Result MissionSequencer::run_phase(const Phase& phase)
+{
+    if (phase.enter && !phase.enter()) {
+        return Result::EnterFailed;
+    }
+
+    const bool has_deadline = static_cast<bool>(phase.deadline);
+    if (!phase.done && !has_deadline) {
+        // Action-only phase, e.g. arming.
+        return Result::Success;
+    }
+
+    const auto deadline = has_deadline ? phase.deadline() : Clock::time_point::max();
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    bool reached_deadline = false;
+    const auto finished = [&]() {
+        bool result = _stop_requested || (phase.done && phase.done(_state));
+        if (!result && has_deadline && now() >= deadline) {
+            reached_deadline = true;
+            result = true;
+        }
+        _waiting = !result;
+        if (_waiting) {
+            _idle_cv.notify_all();
+        }
+        return result;
+    };
+
+    _deadline = deadline;
+    if (has_deadline && !_clock) {
+        _cv.wait_until(lock, deadline, finished);
+    } else {
+        // A set_clock() clock only moves with update()/advance(), which wake us.
+        _cv.wait(lock, finished);
+    }
+    _waiting = false;
+    _deadline = Clock::time_point::max();
+
+    if (_stop_requested) {
+        return Result::Stopped;
+    }
+    if (reached_deadline && !phase.ends_at_deadline) {
+        return Result::TimedOut;
+    }
+    return Result::Success;
+}
+
+void MissionSequencer::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop_requested = true;
+    }
+    _cv.notify_all();
+}
+
+std::string MissionSequencer::last_phase() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _last_phase;
+}
+
+std::function<MissionSequencer::Clock::time_point()>
+MissionSequencer::after(Clock::duration duration)
+{
+    return [duration]() { return Clock::now() + duration; };
+}
+
+std::ostream& operator<<(std::ostream& str, MissionSequencer::Result const& result)
+{
+    switch (result) {
+        case MissionSequencer::Result::Success:
+            return str << "Success";
+        case MissionSequencer::Result::EnterFailed:
+            return str << "Enter Failed";
+        case MissionSequencer::Result::TimedOut:
+            return str << "Timed Out";
+        case MissionSequencer::Result::Stopped:
+            return str << "Stopped";
+        default:
+            return str << "Unknown";
+    }
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+// Event-driven mission sequencer.
+//
+// Telemetry callbacks push their samples into a shared FlightState through
+// update(); every update wakes the sequencer, which re-evaluates the completion
+// condition of the current phase. A phase therefore advances within one
+// telemetry sample of its condition becoming true instead of on the next tick
+// of a polling loop.
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <deque>
+
+// Latest vehicle state as reported by the telemetry subscriptions.
+struct FlightState {
+    // HealthGate::bits() of the latest health sample.
+    uint32_t health_bits{0};
+    bool in_air{false};
+    float relative_altitude_m{0.0f};
+    // Geofence::Breach of the first fence breach, 0 (None) until there is one.
+    uint8_t fence_breach{0};
+    // Offboard could not be started; the mission lands without rotating.
+    bool offboard_failed{false};
+    uint64_t updates{0};
+};
+
+class MissionSequencer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    enum class Result {
+        Success,
+        EnterFailed,
+        TimedOut,
+        Stopped,
+    };
+
+    struct Phase {
+        std::string name;
+        // Runs once when the phase starts. Returning false aborts the mission.
+        std::function<bool()> enter;
+        // Completion condition, evaluated on every state update. A phase
+        // without one ends at its deadline, or right after enter() if it has
+        // no deadline either.
+        std::function<bool(const FlightState&)> done;
+        // Absolute deadline, evaluated when the phase starts. Without one the
+        // phase waits for its condition forever.
+        std::function<Clock::time_point()> deadline;
+        // Reaching the deadline ends the phase normally instead of aborting.
+        bool ends_at_deadline{false};
+    };
+
+    // Called after each phase has ended (successfully or not).
+    using PhaseEndCallback =
+        std::function<void(const Phase& phase, Result result, Clock::duration elapsed)>;
+
+    // Replaces steady_clock for deadlines and phase durations. Set before
+    // run(). The clock must only change before an update() or advance().
+    void set_clock(std::function<Clock::time_point()> clock);
+    Clock::time_point now() const;
+
+    // Appends a phase and returns it for the caller to fill in. References stay
+    // valid while further phases are added.
+    Phase& add_phase(std::string name);
+    void set_phase_end_callback(PhaseEndCallback callback);
+
+    // Applies `fn` to the shared state and wakes the sequencer. Safe to call
+    // from any callback thread.
+    template<typename Fn> void update(Fn&& fn)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            fn(_state);
+            ++_state.updates;
+            _waiting = false;
+        }
+        _cv.notify_one();
+    }
+
+    // Wakes the sequencer without changing the state, e.g. after moving the
+    // clock set with set_clock() past a deadline.
+    void advance();
+
+    // Blocks until run() has evaluated every update so far and is waiting for
+    // the next one, or has returned. Returns false in the latter case.
+    bool wait_idle();
+
+    // Deadline of the phase run() is waiting in, or time_point::max().
+    Clock::time_point next_deadline() const;
+
+    FlightState state() const;
+
+    // Runs all phases in order on the calling thread.
+    Result run();
+
+    // Makes run() return Result::Stopped as soon as possible.
+    void stop();
+
+    // Name of the phase that was running when run() returned.
+    std::string last_phase() const;
+
+    // Deadline helper: `duration` from the moment the phase starts, on
+    // steady_clock. Use now() for phases that must follow set_clock().
+    static std::function<Clock::time_point()> after(Clock::duration duration);
+
+private:
+    Result run_phase(const Phase& phase);
+
+    mutable std::mutex _mutex;
+    std::condition_variable _cv;
+    std::condition_variable _idle_cv;
+    FlightState _state{};
+    bool _stop_requested{false};
+    // Set while run() waits with nothing left to evaluate; cleared by update().
+    bool _waiting{false};
+    bool _finished{false};
+    Clock::time_point _deadline{Clock::time_point::max()};
+    std::function<Clock::time_point()> _clock;
+    std::deque<Phase> _phases;
+    std::string _last_phase;
+    PhaseEndCallback _phase_end_callback;
+};
+
+std::ostream& operator<<(std::ostream& str, MissionSequencer::Result const& result);
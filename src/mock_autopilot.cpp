@@ -0,0 +1,913 @@
+#include "mock_autopilot.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace mavlink_lite;
+
+namespace {
+
+constexpr uint8_t component_autopilot = 1;
+
+constexpr uint8_t mav_type_quadrotor = 2;
+constexpr uint8_t mav_autopilot_px4 = 12;
+constexpr uint8_t mav_mode_flag_custom_mode_enabled = 1;
+constexpr uint8_t mav_mode_flag_safety_armed = 128;
+constexpr uint8_t mav_state_standby = 3;
+constexpr uint8_t mav_state_active = 4;
+
+constexpr uint8_t mav_result_accepted = 0;
+constexpr uint8_t mav_result_denied = 2;
+constexpr uint8_t mav_result_unsupported = 3;
+
+constexpr uint16_t cmd_nav_return_to_launch = 20;
+constexpr uint16_t cmd_nav_land = 21;
+constexpr uint16_t cmd_nav_takeoff = 22;
+constexpr uint16_t cmd_do_set_mode = 176;
+constexpr uint16_t cmd_component_arm_disarm = 400;
+constexpr uint16_t cmd_set_message_interval = 511;
+constexpr uint16_t cmd_request_message = 512;
+constexpr uint16_t cmd_request_autopilot_capabilities = 520;
+
+constexpr uint8_t landed_state_on_ground = 1;
+constexpr uint8_t landed_state_in_air = 2;
+constexpr uint8_t landed_state_takeoff = 3;
+constexpr uint8_t landed_state_landing = 4;
+
+// MAV_SYS_STATUS_SENSOR bits MAVSDK derives its health flags from.
+constexpr uint32_t sensor_gyro = 1u << 0;
+constexpr uint32_t sensor_accel = 1u << 1;
+constexpr uint32_t sensor_mag = 1u << 2;
+constexpr uint32_t sensor_abs_pressure = 1u << 3;
+constexpr uint32_t sensor_gps = 1u << 5;
+constexpr uint32_t sensor_prearm_check = 1u << 28;
+constexpr uint32_t sensors_all = sensor_gyro | sensor_accel | sensor_mag | sensor_abs_pressure |
+                                 sensor_gps | sensor_prearm_check;
+
+// PX4 custom modes: main mode in bits 16-23, sub mode in bits 24-31.
+constexpr uint8_t px4_main_auto = 4;
+constexpr uint8_t px4_main_offboard = 6;
+constexpr uint8_t px4_sub_takeoff = 2;
+constexpr uint8_t px4_sub_loiter = 3;
+constexpr uint8_t px4_sub_rtl = 5;
+constexpr uint8_t px4_sub_land = 6;
+
+// SET_POSITION_TARGET_LOCAL_NED type_mask "ignore" bits.
+constexpr uint16_t ignore_x = 1 << 0;
+constexpr uint16_t ignore_vx = 1 << 3;
+constexpr uint16_t ignore_yaw = 1 << 10;
+constexpr uint16_t ignore_yaw_rate = 1 << 11;
+
+constexpr double home_latitude_deg = 47.3977419;
+constexpr double home_longitude_deg = 8.5455938;
+constexpr float home_amsl_m = 488.0f;
+constexpr double earth_radius_m = 6378137.0;
+constexpr double pi = 3.14159265358979323846;
+
+// PX4 treats offboard as lost after COM_OF_LOSS_T without setpoints.
+constexpr double offboard_loss_timeout_s = 1.0;
+constexpr double max_sim_step_s = 0.01;
+
+float wrap_degrees(float degrees)
+{
+    degrees = std::fmod(degrees + 180.0f, 360.0f);
+    if (degrees < 0.0f) {
+        degrees += 360.0f;
+    }
+    return degrees - 180.0f;
+}
+
+float approach(float current, float target, float max_step)
+{
+    return current + std::clamp(target - current, -max_step, max_step);
+}
+
+} // namespace
+
+MockAutopilot::MockAutopilot() : MockAutopilot(Options{}) {}
+
+MockAutopilot::MockAutopilot(const Options& options) : _options(options)
+{
+    const auto interval = [](double rate_hz) { return rate_hz > 0.0 ? 1.0 / rate_hz : 0.0; };
+    _stream_interval_s[static_cast<size_t>(Stream::Heartbeat)] = 1.0;
+    _stream_interval_s[static_cast<size_t>(Stream::SysStatus)] = 0.5;
+    _stream_interval_s[static_cast<size_t>(Stream::GpsRawInt)] = 0.2;
+    _stream_interval_s[static_cast<size_t>(Stream::GlobalPositionInt)] =
+        interval(options.position_rate_hz);
+    _stream_interval_s[static_cast<size_t>(Stream::Attitude)] = interval(options.attitude_rate_hz);
+    _stream_interval_s[static_cast<size_t>(Stream::LocalPositionNed)] =
+        interval(options.local_position_rate_hz);
+    _stream_interval_s[static_cast<size_t>(Stream::ExtendedSysState)] =
+        interval(options.extended_sys_state_rate_hz);
+    _stream_interval_s[static_cast<size_t>(Stream::HomePosition)] = 2.0;
+
+    const auto add_param = [this](const char* id, float value) {
+        std::strncpy(_params[_param_count].id, id, 16);
+        _params[_param_count].value = value;
+        ++_param_count;
+    };
+    add_param("MIS_TAKEOFF_ALT", 2.5f);
+    add_param("COM_OF_LOSS_T", static_cast<float>(offboard_loss_timeout_s));
+}
+
+MockAutopilot::~MockAutopilot()
+{
+    stop();
+}
+
+bool MockAutopilot::start()
+{
+    if (_running) {
+        return true;
+    }
+
+    _socket = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (_socket < 0) {
+        return false;
+    }
+
+    sockaddr_in local{};
+    local.sin_family = AF_INET;
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+    local.sin_port = 0;
+    if (::bind(_socket, reinterpret_cast<sockaddr*>(&local), sizeof(local)) != 0) {
+        ::close(_socket);
+        _socket = -1;
+        return false;
+    }
+
+    _running = true;
+    _thread = std::thread(&MockAutopilot::run, this);
+    return true;
+}
+
+void MockAutopilot::stop()
+{
+    _running = false;
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+    if (_socket >= 0) {
+        ::close(_socket);
+        _socket = -1;
+    }
+}
+
+MockAutopilot::VehicleState MockAutopilot::state() const
+{
+    std::lock_guard<std::mutex> lock(_state_mutex);
+    return _state;
+}
+
+MockAutopilot::Stats MockAutopilot::stats() const
+{
+    Stats stats;
+    stats.messages_sent = _messages_sent.load(std::memory_order_relaxed);
+    stats.bytes_sent = _bytes_sent.load(std::memory_order_relaxed);
+    stats.messages_received = _messages_received.load(std::memory_order_relaxed);
+    stats.commands_received = _commands_received.load(std::memory_order_relaxed);
+    stats.setpoints_received = _setpoints_received.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void MockAutopilot::run()
+{
+    using Clock = std::chrono::steady_clock;
+    auto last = Clock::now();
+
+    while (_running.load(std::memory_order_relaxed)) {
+        const auto now = Clock::now();
+        double sim_dt = std::chrono::duration<double>(now - last).count() * _options.time_scale;
+        last = now;
+
+        while (sim_dt > 0.0) {
+            const double dt = std::min(sim_dt, max_sim_step_s);
+            step(dt);
+            sim_dt -= dt;
+        }
+
+        send_due_streams();
+        receive();
+    }
+}
+
+void MockAutopilot::step(double dt_s)
+{
+    const auto dt = static_cast<float>(dt_s);
+
+    std::lock_guard<std::mutex> lock(_state_mutex);
+    auto& s = _state;
+    s.sim_time_s += dt_s;
+
+    float target_north = 0.0f;
+    float target_east = 0.0f;
+    float target_up = 0.0f;
+    float target_yaw = s.yaw_deg;
+    float yaw_rate = 0.0f;
+    bool yaw_from_rate = false;
+
+    if (_mode == Mode::Offboard && s.sim_time_s - _setpoint_time_s > offboard_loss_timeout_s) {
+        // Offboard loss failsafe.
+        _mode = Mode::Hold;
+        s.offboard = false;
+    }
+
+    switch (_mode) {
+        case Mode::Hold:
+            break;
+
+        case Mode::Takeoff:
+            target_up = std::min(_options.takeoff_speed_m_s, _takeoff_target_m - s.altitude_m);
+            if (s.altitude_m >= _takeoff_target_m - 0.05f) {
+                _mode = Mode::Hold;
+            }
+            break;
+
+        case Mode::Land:
+            target_up = -_options.land_speed_m_s;
+            break;
+
+        case Mode::ReturnToLaunch: {
+            const float distance = std::hypot(s.north_m, s.east_m);
+            if (distance < 0.5f) {
+                _mode = Mode::Land;
+            } else {
+                const float speed = std::min(_options.max_speed_m_s, distance);
+                target_north = -s.north_m / distance * speed;
+                target_east = -s.east_m / distance * speed;
+            }
+            break;
+        }
+
+        case Mode::Offboard: {
+            const float position[3]{s.north_m, s.east_m, -s.altitude_m};
+            float velocity[3]{};
+            for (int axis = 0; axis < 3; ++axis) {
+                if ((_setpoint_mask & (ignore_vx << axis)) == 0) {
+                    velocity[axis] = _setpoint_velocity[axis];
+                } else if ((_setpoint_mask & (ignore_x << axis)) == 0) {
+                    velocity[axis] = _setpoint_position[axis] - position[axis];
+                }
+            }
+            target_north = velocity[0];
+            target_east = velocity[1];
+            target_up = -velocity[2];
+            if ((_setpoint_mask & ignore_yaw) == 0) {
+                target_yaw = _setpoint_yaw_deg;
+            } else if ((_setpoint_mask & ignore_yaw_rate) == 0) {
+                yaw_rate = _setpoint_yaw_deg;
+                yaw_from_rate = true;
+            }
+            break;
+        }
+    }
+
+    if (!s.armed) {
+        target_north = target_east = target_up = 0.0f;
+        yaw_from_rate = false;
+        target_yaw = s.yaw_deg;
+    }
+
+    const auto limit = [this](float value) {
+        return std::clamp(value, -_options.max_speed_m_s, _options.max_speed_m_s);
+    };
+    const float alpha = std::min(1.0f, dt / _options.velocity_time_constant_s);
+    _velocity_north += (limit(target_north) - _velocity_north) * alpha;
+    _velocity_east += (limit(target_east) - _velocity_east) * alpha;
+    _velocity_up += (limit(target_up) - _velocity_up) * alpha;
+
+    s.north_m += _velocity_north * dt;
+    s.east_m += _velocity_east * dt;
+    s.altitude_m += _velocity_up * dt;
+
+    if (s.altitude_m <= 0.0f) {
+        s.altitude_m = 0.0f;
+        _velocity_up = std::max(_velocity_up, 0.0f);
+        if (s.armed && _mode == Mode::Land) {
+            // Touchdown: PX4 disarms shortly after landing.
+            s.armed = false;
+            _mode = Mode::Hold;
+        }
+    }
+    s.in_air = s.armed && (s.altitude_m > 0.05f || _mode == Mode::Takeoff);
+
+    const float max_yaw_step = _options.max_yaw_rate_deg_s * dt;
+    if (yaw_from_rate) {
+        s.yaw_deg = wrap_degrees(approach(s.yaw_deg, s.yaw_deg + yaw_rate * dt, max_yaw_step));
+    } else {
+        const float error = wrap_degrees(target_yaw - s.yaw_deg);
+        s.yaw_deg = wrap_degrees(approach(s.yaw_deg, s.yaw_deg + error, max_yaw_step));
+    }
+}
+
+void MockAutopilot::send_due_streams()
+{
+    double sim_time_s;
+    {
+        std::lock_guard<std::mutex> lock(_state_mutex);
+        sim_time_s = _state.sim_time_s;
+    }
+
+    for (size_t i = 0; i < static_cast<size_t>(Stream::Count); ++i) {
+        const double interval = _stream_interval_s[i];
+        if (interval <= 0.0 || sim_time_s < _stream_next_s[i]) {
+            continue;
+        }
+        send_stream(static_cast<Stream>(i));
+        _stream_next_s[i] += interval;
+        if (_stream_next_s[i] < sim_time_s) {
+            // Fell behind (or just started): don't send a burst.
+            _stream_next_s[i] = sim_time_s + interval;
+        }
+    }
+}
+
+void MockAutopilot::receive()
+{
+    // Wake up at least every millisecond to keep the simulation and the
+    // streams on time.
+    pollfd fd{_socket, POLLIN, 0};
+    if (::poll(&fd, 1, 1) <= 0) {
+        return;
+    }
+
+    uint8_t buffer[2048];
+    while (true) {
+        const auto received = ::recv(_socket, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (received <= 0) {
+            return;
+        }
+
+        size_t offset = 0;
+        while (offset < static_cast<size_t>(received)) {
+            Message message;
+            bool decoded = false;
+            const size_t consumed =
+                decode(buffer + offset, static_cast<size_t>(received) - offset, message, decoded);
+            if (consumed == 0) {
+                break;
+            }
+            offset += consumed;
+            if (decoded) {
+                _messages_received.fetch_add(1, std::memory_order_relaxed);
+                handle(message);
+            }
+        }
+    }
+}
+
+void MockAutopilot::handle(const Message& message)
+{
+    switch (message.msgid) {
+        case msg::command_long: {
+            PayloadReader reader{message};
+            float params[7];
+            for (auto& param : params) {
+                param = reader.get<float>();
+            }
+            const auto command = reader.get<uint16_t>();
+            const auto target_system = reader.get<uint8_t>();
+            reader.get<uint8_t>(); // target_component
+            const auto confirmation = reader.get<uint8_t>();
+            if (target_system == _options.system_id || target_system == 0) {
+                handle_command(message, command, params, confirmation);
+            }
+            break;
+        }
+
+        case msg::command_int: {
+            PayloadReader reader{message};
+            float params[7];
+            for (int i = 0; i < 4; ++i) {
+                params[i] = reader.get<float>();
+            }
+            params[4] = static_cast<float>(reader.get<int32_t>());
+            params[5] = static_cast<float>(reader.get<int32_t>());
+            params[6] = reader.get<float>();
+            const auto command = reader.get<uint16_t>();
+            const auto target_system = reader.get<uint8_t>();
+            if (target_system == _options.system_id || target_system == 0) {
+                handle_command(message, command, params, 0);
+            }
+            break;
+        }
+
+        case msg::set_position_target_local_ned:
+            handle_setpoint(message);
+            break;
+
+        case msg::param_set:
+            handle_param_set(message);
+            break;
+
+        case msg::param_request_read:
+            handle_param_request_read(message);
+            break;
+
+        case msg::param_request_list: {
+            PayloadReader reader{message};
+            if (reader.get<uint8_t>() == _options.system_id) {
+                for (size_t i = 0; i < _param_count; ++i) {
+                    send_param_value(i);
+                }
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+void MockAutopilot::handle_command(
+    const Message& message, uint16_t command, const float (&params)[7], uint8_t confirmation)
+{
+    (void)confirmation;
+    _commands_received.fetch_add(1, std::memory_order_relaxed);
+    const uint8_t result = execute_command(command, params);
+    send_command_ack(message, command, result);
+}
+
+uint8_t MockAutopilot::execute_command(uint16_t command, const float (&params)[7])
+{
+    switch (command) {
+        case cmd_component_arm_disarm: {
+            std::lock_guard<std::mutex> lock(_state_mutex);
+            if (params[0] > 0.5f) {
+                if (!healthy()) {
+                    return mav_result_denied;
+                }
+                _state.armed = true;
+                return mav_result_accepted;
+            }
+            if (_state.in_air && static_cast<int>(params[1]) != 21196) {
+                return mav_result_denied;
+            }
+            _state.armed = false;
+            _mode = Mode::Hold;
+            _state.offboard = false;
+            return mav_result_accepted;
+        }
+
+        case cmd_nav_takeoff: {
+            std::lock_guard<std::mutex> lock(_state_mutex);
+            if (!_state.armed) {
+                return mav_result_denied;
+            }
+            // param7 is an AMSL altitude; PX4 falls back to MIS_TAKEOFF_ALT.
+            const Param* takeoff_alt = find_param("MIS_TAKEOFF_ALT");
+            _takeoff_target_m = std::isfinite(params[6]) && params[6] > home_amsl_m ?
+                                    params[6] - home_amsl_m :
+                                    (takeoff_alt != nullptr ? takeoff_alt->value : 2.5f);
+            _mode = Mode::Takeoff;
+            _state.offboard = false;
+            return mav_result_accepted;
+        }
+
+        case cmd_nav_land: {
+            std::lock_guard<std::mutex> lock(_state_mutex);
+            _mode = Mode::Land;
+            _state.offboard = false;
+            return mav_result_accepted;
+        }
+
+        case cmd_nav_return_to_launch: {
+            std::lock_guard<std::mutex> lock(_state_mutex);
+            if (!_state.armed) {
+                return mav_result_denied;
+            }
+            _mode = Mode::ReturnToLaunch;
+            _state.offboard = false;
+            return mav_result_accepted;
+        }
+
+        case cmd_do_set_mode: {
+            const auto main_mode = static_cast<uint8_t>(params[1]);
+            const auto sub_mode = static_cast<uint8_t>(params[2]);
+            std::lock_guard<std::mutex> lock(_state_mutex);
+            if (main_mode == px4_main_offboard) {
+                // PX4 refuses offboard without a recent setpoint.
+                if (!_setpoint_valid ||
+                    _state.sim_time_s - _setpoint_time_s > offboard_loss_timeout_s) {
+                    return mav_result_denied;
+                }
+                _mode = Mode::Offboard;
+                _state.offboard = true;
+                return mav_result_accepted;
+            }
+            _state.offboard = false;
+            if (main_mode == px4_main_auto && sub_mode == px4_sub_land) {
+                _mode = Mode::Land;
+            } else if (main_mode == px4_main_auto && sub_mode == px4_sub_rtl) {
+                _mode = _state.armed ? Mode::ReturnToLaunch : Mode::Hold;
+            } else if (main_mode == px4_main_auto && sub_mode == px4_sub_takeoff) {
+                _mode = _state.armed ? Mode::Takeoff : Mode::Hold;
+            } else {
+                _mode = Mode::Hold;
+            }
+            return mav_result_accepted;
+        }
+
+        case cmd_set_message_interval:
+            set_stream_interval(static_cast<uint32_t>(params[0]), params[1]);
+            return mav_result_accepted;
+
+        case cmd_request_message: {
+            const auto msgid = static_cast<uint32_t>(params[0]);
+            if (msgid == msg::autopilot_version) {
+                send_autopilot_version();
+            } else if (msgid == msg::home_position) {
+                send_stream(Stream::HomePosition);
+            }
+            return mav_result_accepted;
+        }
+
+        case cmd_request_autopilot_capabilities:
+            send_autopilot_version();
+            return mav_result_accepted;
+
+        default:
+            return mav_result_unsupported;
+    }
+}
+
+void MockAutopilot::handle_setpoint(const Message& message)
+{
+    PayloadReader reader{message};
+    reader.get<uint32_t>(); // time_boot_ms
+    // x, y, z, vx, vy, vz, afx, afy, afz, yaw, yaw_rate
+    float values[11];
+    for (auto& value : values) {
+        value = reader.get<float>();
+    }
+    const auto type_mask = reader.get<uint16_t>();
+    const auto target_system = reader.get<uint8_t>();
+    if (target_system != _options.system_id) {
+        return;
+    }
+    _setpoints_received.fetch_add(1, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(_state_mutex);
+    _setpoint_valid = true;
+    _setpoint_time_s = _state.sim_time_s;
+    _setpoint_mask = type_mask;
+    for (int axis = 0; axis < 3; ++axis) {
+        _setpoint_position[axis] = values[axis];
+        _setpoint_velocity[axis] = values[3 + axis];
+    }
+    // Holds the yaw rate instead when only that is set, see step().
+    constexpr float rad_to_deg = static_cast<float>(180.0 / pi);
+    _setpoint_yaw_deg = ((type_mask & ignore_yaw) == 0 ? values[9] : values[10]) * rad_to_deg;
+}
+
+void MockAutopilot::handle_param_set(const Message& message)
+{
+    PayloadReader reader{message};
+    const float value = reader.get<float>();
+    const auto target_system = reader.get<uint8_t>();
+    reader.get<uint8_t>(); // target_component
+    char id[17];
+    reader.get_chars(id, 16);
+    if (target_system != _options.system_id) {
+        return;
+    }
+
+    Param* param = find_param(id);
+    if (param == nullptr && _param_count < max_params) {
+        param = &_params[_param_count++];
+        std::strncpy(param->id, id, 16);
+    }
+    if (param == nullptr) {
+        return;
+    }
+    param->value = value;
+    send_param_value(static_cast<size_t>(param - _params));
+}
+
+void MockAutopilot::handle_param_request_read(const Message& message)
+{
+    PayloadReader reader{message};
+    const auto index = reader.get<int16_t>();
+    const auto target_system = reader.get<uint8_t>();
+    reader.get<uint8_t>(); // target_component
+    char id[17];
+    reader.get_chars(id, 16);
+    if (target_system != _options.system_id) {
+        return;
+    }
+
+    if (index >= 0 && static_cast<size_t>(index) < _param_count) {
+        send_param_value(static_cast<size_t>(index));
+    } else if (const Param* param = find_param(id)) {
+        send_param_value(static_cast<size_t>(param - _params));
+    }
+}
+
+void MockAutopilot::send_stream(Stream stream)
+{
+    VehicleState s;
+    Mode mode;
+    float velocity[3];
+    {
+        std::lock_guard<std::mutex> lock(_state_mutex);
+        s = _state;
+        mode = _mode;
+        velocity[0] = _velocity_north;
+        velocity[1] = _velocity_east;
+        velocity[2] = -_velocity_up;
+    }
+
+    const double latitude_deg = home_latitude_deg + s.north_m / earth_radius_m * 180.0 / pi;
+    const double longitude_deg =
+        home_longitude_deg +
+        s.east_m / (earth_radius_m * std::cos(home_latitude_deg * pi / 180.0)) * 180.0 / pi;
+    const auto lat_e7 = static_cast<int32_t>(std::lround(latitude_deg * 1e7));
+    const auto lon_e7 = static_cast<int32_t>(std::lround(longitude_deg * 1e7));
+    const auto yaw_rad = static_cast<float>(s.yaw_deg * pi / 180.0);
+
+    Message message;
+    PayloadWriter writer{message};
+
+    switch (stream) {
+        case Stream::Heartbeat: {
+            uint8_t main_mode = px4_main_auto;
+            uint8_t sub_mode = px4_sub_loiter;
+            if (mode == Mode::Offboard) {
+                main_mode = px4_main_offboard;
+                sub_mode = 0;
+            } else if (mode == Mode::Takeoff) {
+                sub_mode = px4_sub_takeoff;
+            } else if (mode == Mode::Land) {
+                sub_mode = px4_sub_land;
+            } else if (mode == Mode::ReturnToLaunch) {
+                sub_mode = px4_sub_rtl;
+            }
+            message.msgid = msg::heartbeat;
+            writer.put<uint32_t>((static_cast<uint32_t>(main_mode) << 16) |
+                                 (static_cast<uint32_t>(sub_mode) << 24))
+                .put<uint8_t>(mav_type_quadrotor)
+                .put<uint8_t>(mav_autopilot_px4)
+                .put<uint8_t>(static_cast<uint8_t>(
+                    mav_mode_flag_custom_mode_enabled | (s.armed ? mav_mode_flag_safety_armed : 0)))
+                .put<uint8_t>(s.armed ? mav_state_active : mav_state_standby)
+                .put<uint8_t>(3);
+            break;
+        }
+
+        case Stream::SysStatus: {
+            const uint32_t health = healthy() ? sensors_all : 0;
+            message.msgid = msg::sys_status;
+            writer.put<uint32_t>(sensors_all)
+                .put<uint32_t>(sensors_all)
+                .put<uint32_t>(health)
+                .put<uint16_t>(250)    // load, 25 %
+                .put<uint16_t>(16200)  // battery voltage, mV
+                .put<int16_t>(-1)      // current unknown
+                .put<uint16_t>(0)      // drop_rate_comm
+                .put<uint16_t>(0)      // errors_comm
+                .put<uint16_t>(0)
+                .put<uint16_t>(0)
+                .put<uint16_t>(0)
+                .put<uint16_t>(0)
+                .put<int8_t>(90);      // battery remaining, %
+            break;
+        }
+
+        case Stream::GpsRawInt:
+            message.msgid = msg::gps_raw_int;
+            writer.put<uint64_t>(static_cast<uint64_t>(s.sim_time_s * 1e6))
+                .put<int32_t>(lat_e7)
+                .put<int32_t>(lon_e7)
+                .put<int32_t>(static_cast<int32_t>((home_amsl_m + s.altitude_m) * 1000.0f))
+                .put<uint16_t>(80)  // eph, cm
+                .put<uint16_t>(120) // epv, cm
+                .put<uint16_t>(static_cast<uint16_t>(std::hypot(velocity[0], velocity[1]) * 100.0f))
+                .put<uint16_t>(UINT16_MAX)
+                .put<uint8_t>(healthy() ? 3 : 0) // 3D fix
+                .put<uint8_t>(12);
+            break;
+
+        case Stream::GlobalPositionInt:
+            message.msgid = msg::global_position_int;
+            writer.put<uint32_t>(time_boot_ms())
+                .put<int32_t>(lat_e7)
+                .put<int32_t>(lon_e7)
+                .put<int32_t>(static_cast<int32_t>((home_amsl_m + s.altitude_m) * 1000.0f))
+                .put<int32_t>(static_cast<int32_t>(s.altitude_m * 1000.0f))
+                .put<int16_t>(static_cast<int16_t>(velocity[0] * 100.0f))
+                .put<int16_t>(static_cast<int16_t>(velocity[1] * 100.0f))
+                .put<int16_t>(static_cast<int16_t>(velocity[2] * 100.0f))
+                .put<uint16_t>(static_cast<uint16_t>(
+                    std::fmod(s.yaw_deg + 360.0f, 360.0f) * 100.0f));
+            break;
+
+        case Stream::Attitude:
+            message.msgid = msg::attitude;
+            writer.put<uint32_t>(time_boot_ms())
+                .put<float>(0.0f)
+                .put<float>(0.0f)
+                .put<float>(yaw_rad)
+                .put<float>(0.0f)
+                .put<float>(0.0f)
+                .put<float>(0.0f);
+            break;
+
+        case Stream::LocalPositionNed:
+            message.msgid = msg::local_position_ned;
+            writer.put<uint32_t>(time_boot_ms())
+                .put<float>(s.north_m)
+                .put<float>(s.east_m)
+                .put<float>(-s.altitude_m)
+                .put<float>(velocity[0])
+                .put<float>(velocity[1])
+                .put<float>(velocity[2]);
+            break;
+
+        case Stream::ExtendedSysState: {
+            uint8_t landed_state = s.in_air ? landed_state_in_air : landed_state_on_ground;
+            if (s.armed && mode == Mode::Takeoff) {
+                landed_state = landed_state_takeoff;
+            } else if (s.in_air && mode == Mode::Land) {
+                landed_state = landed_state_landing;
+            }
+            message.msgid = msg::extended_sys_state;
+            writer.put<uint8_t>(0).put<uint8_t>(landed_state);
+            break;
+        }
+
+        case Stream::HomePosition:
+            if (!healthy()) {
+                return;
+            }
+            message.msgid = msg::home_position;
+            writer.put<int32_t>(static_cast<int32_t>(std::lround(home_latitude_deg * 1e7)))
+                .put<int32_t>(static_cast<int32_t>(std::lround(home_longitude_deg * 1e7)))
+                .put<int32_t>(static_cast<int32_t>(home_amsl_m * 1000.0f))
+                .put<float>(0.0f)
+                .put<float>(0.0f)
+                .put<float>(0.0f)
+                .put<float>(1.0f)
+                .put<float>(0.0f)
+                .put<float>(0.0f)
+                .put<float>(0.0f)
+                .put<float>(0.0f)
+                .put<float>(0.0f)
+                .put<float>(0.0f);
+            break;
+
+        case Stream::Count:
+            return;
+    }
+
+    send(message);
+}
+
+void MockAutopilot::send_command_ack(const Message& request, uint16_t command, uint8_t result)
+{
+    Message message;
+    message.msgid = msg::command_ack;
+    PayloadWriter{message}
+        .put<uint16_t>(command)
+        .put<uint8_t>(result)
+        .put<uint8_t>(0)  // progress
+        .put<int32_t>(0)  // result_param2
+        .put<uint8_t>(request.sysid)
+        .put<uint8_t>(request.compid);
+    send(message);
+}
+
+void MockAutopilot::send_param_value(size_t index)
+{
+    constexpr uint8_t mav_param_type_real32 = 9;
+    Message message;
+    message.msgid = msg::param_value;
+    PayloadWriter{message}
+        .put<float>(_params[index].value)
+        .put<uint16_t>(static_cast<uint16_t>(_param_count))
+        .put<uint16_t>(static_cast<uint16_t>(index))
+        .put_chars(_params[index].id, 16)
+        .put<uint8_t>(mav_param_type_real32);
+    send(message);
+}
+
+void MockAutopilot::send_autopilot_version()
+{
+    // MAVLINK2 | COMMAND_INT | PARAM_FLOAT | SET_POSITION_TARGET_LOCAL_NED
+    constexpr uint64_t capabilities = 8192 | 8 | 2 | 128;
+    Message message;
+    message.msgid = msg::autopilot_version;
+    PayloadWriter writer{message};
+    writer.put<uint64_t>(capabilities)
+        .put<uint64_t>(_options.system_id) // uid
+        .put<uint32_t>(0x010F0000)         // flight_sw_version 1.15.0
+        .put<uint32_t>(0)
+        .put<uint32_t>(0)
+        .put<uint32_t>(0)
+        .put<uint16_t>(0)
+        .put<uint16_t>(0);
+    for (int i = 0; i < 24; ++i) {
+        writer.put<uint8_t>(0);
+    }
+    send(message);
+}
+
+void MockAutopilot::send(Message& message)
+{
+    message.sysid = _options.system_id;
+    message.compid = component_autopilot;
+    message.seq = _seq++;
+
+    uint8_t frame[max_frame_len];
+    const size_t length = encode(message, frame);
+    if (length == 0) {
+        return;
+    }
+
+    sockaddr_in remote{};
+    remote.sin_family = AF_INET;
+    remote.sin_port = htons(_options.remote_port);
+    inet_pton(AF_INET, _options.remote_host.c_str(), &remote.sin_addr);
+
+    const auto sent = ::sendto(
+        _socket, frame, length, 0, reinterpret_cast<const sockaddr*>(&remote), sizeof(remote));
+    if (sent > 0) {
+        _messages_sent.fetch_add(1, std::memory_order_relaxed);
+        _bytes_sent.fetch_add(static_cast<uint64_t>(sent), std::memory_order_relaxed);
+    }
+}
+
+bool MockAutopilot::healthy() const
+{
+    // Callers either hold the state mutex or run on the simulation thread,
+    // which is the only writer of sim_time_s.
+    return _state.sim_time_s >= _options.health_delay_s;
+}
+
+uint32_t MockAutopilot::time_boot_ms() const
+{
+    return static_cast<uint32_t>(_state.sim_time_s * 1000.0);
+}
+
+MockAutopilot::Param* MockAutopilot::find_param(const char* id)
+{
+    for (size_t i = 0; i < _param_count; ++i) {
+        if (std::strncmp(_params[i].id, id, 16) == 0) {
+            return &_params[i];
+        }
+    }
+    return nullptr;
+}
+
+void MockAutopilot::set_stream_interval(uint32_t msgid, float interval_us)
+{
+    Stream stream;
+    double default_interval;
+    switch (msgid) {
+        case msg::global_position_int:
+            stream = Stream::GlobalPositionInt;
+            default_interval = 1.0 / _options.position_rate_hz;
+            break;
+        case msg::attitude:
+            stream = Stream::Attitude;
+            default_interval = 1.0 / _options.attitude_rate_hz;
+            break;
+        case msg::local_position_ned:
+            stream = Stream::LocalPositionNed;
+            default_interval = 1.0 / _options.local_position_rate_hz;
+            break;
+        case msg::extended_sys_state:
+            stream = Stream::ExtendedSysState;
+            default_interval = 1.0 / _options.extended_sys_state_rate_hz;
+            break;
+        case msg::sys_status:
+            stream = Stream::SysStatus;
+            default_interval = 0.5;
+            break;
+        case msg::gps_raw_int:
+            stream = Stream::GpsRawInt;
+            default_interval = 0.2;
+            break;
+        case msg::home_position:
+            stream = Stream::HomePosition;
+            default_interval = 2.0;
+            break;
+        default:
+            return;
+    }
+
+    double interval = default_interval;
+    if (interval_us < 0.0f) {
+        interval = 0.0; // disabled
+    } else if (interval_us > 0.0f) {
+        interval = static_cast<double>(interval_us) / 1e6;
+    }
+    _stream_interval_s[static_cast<size_t>(stream)] = interval;
+}
@@ -0,0 +1,173 @@
+#pragma once
+
+// Loopback-UDP stand-in for PX4.
+//
+// Speaks just enough MAVLink for rotate: heartbeat, SYS_STATUS, GPS,
+// position/attitude/extended-state telemetry, COMMAND_LONG/COMMAND_INT with
+// COMMAND_ACK, parameters, and SET_POSITION_TARGET_LOCAL_NED in offboard mode.
+// Behind that is a simple vehicle model: first-order velocity tracking in
+// three axes and rate-limited yaw.
+//
+// Simulated time runs `time_scale` times faster than wall time. Dynamics and
+// telemetry rates are both defined in simulated time, so a scaled mock flies
+// the same trajectory and sends the same samples per flight, only sooner.
+//
+// The mock sends to `remote_host:remote_port` from an ephemeral port, like
+// PX4 SITL does towards a ground station, so connect MAVSDK to it with
+// "udpin://0.0.0.0:<remote_port>".
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "mavlink_lite.h"
+
+class MockAutopilot {
+public:
+    struct Options {
+        uint8_t system_id{1};
+        std::string remote_host{"127.0.0.1"};
+        uint16_t remote_port{14540};
+        double time_scale{1.0};
+        // Simulated seconds until the sensors report healthy.
+        double health_delay_s{0.0};
+        float takeoff_speed_m_s{1.5f};
+        float land_speed_m_s{0.7f};
+        float max_speed_m_s{5.0f};
+        float max_yaw_rate_deg_s{90.0f};
+        // Time constant of the velocity response.
+        float velocity_time_constant_s{0.3f};
+        // Default stream rates in simulated Hz; SET_MESSAGE_INTERVAL changes them.
+        double position_rate_hz{10.0};
+        double attitude_rate_hz{20.0};
+        double local_position_rate_hz{20.0};
+        double extended_sys_state_rate_hz{5.0};
+    };
+
+    struct VehicleState {
+        bool armed{false};
+        bool in_air{false};
+        bool offboard{false};
+        float north_m{0.0f};
+        float east_m{0.0f};
+        float altitude_m{0.0f};
+        float yaw_deg{0.0f};
+        double sim_time_s{0.0};
+    };
+
+    struct Stats {
+        uint64_t messages_sent{0};
+        uint64_t bytes_sent{0};
+        uint64_t messages_received{0};
+        uint64_t commands_received{0};
+        uint64_t setpoints_received{0};
+    };
+
+    MockAutopilot();
+    explicit MockAutopilot(const Options& options);
+    ~MockAutopilot();
+
+    MockAutopilot(const MockAutopilot&) = delete;
+    MockAutopilot& operator=(const MockAutopilot&) = delete;
+
+    // Opens the socket and starts the simulation thread. Returns false if the
+    // socket could not be set up.
+    bool start();
+    void stop();
+
+    VehicleState state() const;
+    Stats stats() const;
+
+private:
+    enum class Mode {
+        Hold,
+        Takeoff,
+        Land,
+        ReturnToLaunch,
+        Offboard,
+    };
+
+    enum class Stream {
+        Heartbeat,
+        SysStatus,
+        GpsRawInt,
+        GlobalPositionInt,
+        Attitude,
+        LocalPositionNed,
+        ExtendedSysState,
+        HomePosition,
+        Count,
+    };
+
+    struct Param {
+        char id[17];
+        float value;
+    };
+
+    void run();
+    void step(double dt_s);
+    void send_due_streams();
+    void receive();
+
+    void handle(const mavlink_lite::Message& message);
+    void handle_command(
+        const mavlink_lite::Message& message,
+        uint16_t command,
+        const float (&params)[7],
+        uint8_t confirmation);
+    uint8_t execute_command(uint16_t command, const float (&params)[7]);
+    void handle_setpoint(const mavlink_lite::Message& message);
+    void handle_param_set(const mavlink_lite::Message& message);
+    void handle_param_request_read(const mavlink_lite::Message& message);
+
+    void send_stream(Stream stream);
+    void send_command_ack(const mavlink_lite::Message& request, uint16_t command, uint8_t result);
+    void send_param_value(size_t index);
+    void send_autopilot_version();
+    void send(mavlink_lite::Message& message);
+
+    bool healthy() const;
+    uint32_t time_boot_ms() const;
+    Param* find_param(const char* id);
+    void set_stream_interval(uint32_t msgid, float interval_us);
+
+    const Options _options;
+
+    int _socket{-1};
+    std::thread _thread;
+    std::atomic<bool> _running{false};
+    uint8_t _seq{0};
+
+    // Simulation state, owned by the simulation thread and copied out under
+    // the mutex for state().
+    mutable std::mutex _state_mutex;
+    VehicleState _state{};
+    Mode _mode{Mode::Hold};
+    float _velocity_north{0.0f};
+    float _velocity_east{0.0f};
+    float _velocity_up{0.0f};
+
+    // Latest offboard setpoint.
+    bool _setpoint_valid{false};
+    double _setpoint_time_s{-1.0};
+    uint16_t _setpoint_mask{0};
+    float _setpoint_position[3]{};
+    float _setpoint_velocity[3]{};
+    float _setpoint_yaw_deg{0.0f};
+    float _takeoff_target_m{0.0f};
+
+    double _stream_interval_s[static_cast<size_t>(Stream::Count)]{};
+    double _stream_next_s[static_cast<size_t>(Stream::Count)]{};
+
+    static constexpr size_t max_params = 16;
+    Param _params[max_params]{};
+    size_t _param_count{0};
+
+    std::atomic<uint64_t> _messages_sent{0};
+    std::atomic<uint64_t> _bytes_sent{0};
+    std::atomic<uint64_t> _messages_received{0};
+    std::atomic<uint64_t> _commands_received{0};
+    std::atomic<uint64_t> _setpoints_received{0};
+};
@@ -0,0 +1,71 @@
+#include "rate_profile.h"
+
+using namespace mavsdk;
+
+RateSwitcher::RateSwitcher(Telemetry& telemetry) : _telemetry(telemetry) {}
+
+size_t RateSwitcher::apply(const RateProfile& profile)
+{
+    const auto changed = [&](double RateProfile::*rate) {
+        return !_has_current || _current.*rate != profile.*rate;
+    };
+
+    size_t requests = 0;
+    if (changed(&RateProfile::position_hz)) {
+        _telemetry.set_rate_position_async(profile.position_hz, result_callback());
+        ++requests;
+    }
+    if (changed(&RateProfile::attitude_hz)) {
+        _telemetry.set_rate_attitude_euler_async(profile.attitude_hz, result_callback());
+        ++requests;
+    }
+    if (changed(&RateProfile::velocity_ned_hz)) {
+        _telemetry.set_rate_velocity_ned_async(profile.velocity_ned_hz, result_callback());
+        ++requests;
+    }
+    if (changed(&RateProfile::in_air_hz)) {
+        _telemetry.set_rate_in_air_async(profile.in_air_hz, result_callback());
+        ++requests;
+    }
+
+    _current = profile;
+    _has_current = true;
+    return requests;
+}
+
+Telemetry::ResultCallback RateSwitcher::result_callback()
+{
+    {
+        std::lock_guard<std::mutex> lock(_results->mutex);
+        ++_results->pending;
+        ++_results->sent;
+    }
+    return [results = _results](Telemetry::Result result) {
+        {
+            std::lock_guard<std::mutex> lock(results->mutex);
+            --results->pending;
+            if (result != Telemetry::Result::Success) {
+                ++results->failures;
+            }
+        }
+        results->cv.notify_all();
+    };
+}
+
+bool RateSwitcher::wait(std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> lock(_results->mutex);
+    return _results->cv.wait_for(lock, timeout, [this]() { return _results->pending == 0; });
+}
+
+uint64_t RateSwitcher::requests_sent() const
+{
+    std::lock_guard<std::mutex> lock(_results->mutex);
+    return _results->sent;
+}
+
+uint64_t RateSwitcher::failures() const
+{
+    std::lock_guard<std::mutex> lock(_results->mutex);
+    return _results->failures;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+// Named Telemetry rate profiles and a switcher that applies them.
+//
+// Each profile sets the stream rates one mission stage needs: slow while
+// waiting on the ground, fast altitude while climbing, fast attitude for yaw
+// control in Offboard, fast in-air state for touchdown. Health (SYS_STATUS)
+// has no set_rate_* in MAVSDK and keeps the autopilot's default rate.
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include <mavsdk/plugins/telemetry/telemetry.h>
+
+struct RateProfile {
+    const char* name;
+    double position_hz;
+    double attitude_hz;
+    double velocity_ned_hz;
+    double in_air_hz;
+};
+
+namespace rate_profiles {
+
+// On the ground, waiting for health and arming.
+constexpr RateProfile idle{"idle", 1.0, 1.0, 1.0, 1.0};
+// Takeoff and climb: the sequencer waits on altitude.
+constexpr RateProfile climb{"climb", 10.0, 2.0, 5.0, 2.0};
+// Offboard rotate while climbing and hover: closed-loop yaw.
+constexpr RateProfile offboard_control{"offboard-control", 10.0, 50.0, 20.0, 1.0};
+// The land phase waits for touchdown.
+constexpr RateProfile landing{"landing", 5.0, 2.0, 5.0, 10.0};
+
+} // namespace rate_profiles
+
+// Switches a Telemetry plugin between rate profiles. A switch sends only the
+// rates that differ from the current profile, all at once through the
+// set_rate_*_async calls, and returns without waiting for the results.
+class RateSwitcher {
+public:
+    explicit RateSwitcher(mavsdk::Telemetry& telemetry);
+
+    RateSwitcher(const RateSwitcher&) = delete;
+    RateSwitcher& operator=(const RateSwitcher&) = delete;
+
+    // Returns the number of rate requests sent.
+    size_t apply(const RateProfile& profile);
+
+    // Waits until every request sent so far has been answered. Returns false
+    // on timeout.
+    bool wait(std::chrono::milliseconds timeout);
+
+    // Name of the last profile applied, or nullptr.
+    const char* current() const { return _has_current ? _current.name : nullptr; }
+
+    uint64_t requests_sent() const;
+    uint64_t failures() const;
+
+private:
+    // Shared with the result callbacks, which may outlive the switcher.
+    struct Results {
+        std::mutex mutex;
+        std::condition_variable cv;
+        size_t pending{0};
+        uint64_t sent{0};
+        uint64_t failures{0};
+    };
+
+    mavsdk::Telemetry::ResultCallback result_callback();
+
+    mavsdk::Telemetry& _telemetry;
+    RateProfile _current{};
+    bool _has_current{false};
+    std::shared_ptr<Results> _results{std::make_shared<Results>()};
+};
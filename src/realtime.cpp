@@ -0,0 +1,121 @@
+#include "realtime.h"
+
+#include <cerrno>
+#include <cstring>
+
+#if defined(__linux__)
+#include <alloca.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+#endif
+
+namespace {
+
+void add_error(RealtimeStatus& status, const std::string& error)
+{
+    if (!status.errors.empty()) {
+        status.errors += "; ";
+    }
+    status.errors += error;
+}
+
+#if defined(__linux__)
+
+std::string errno_text(const char* what, int error)
+{
+    return std::string(what) + ": " + std::strerror(error);
+}
+
+// Touches `bytes` of stack below the caller's frame so those pages are mapped
+// (and, after mlockall, locked) before the loop needs them.
+__attribute__((noinline)) void prefault_stack(size_t bytes)
+{
+    auto* stack = static_cast<volatile unsigned char*>(alloca(bytes));
+    for (size_t i = 0; i < bytes; i += 4096) {
+        stack[i] = 0;
+    }
+}
+
+bool lock_memory(RealtimeStatus& status)
+{
+    // With MCL_FUTURE every later mapping counts against RLIMIT_MEMLOCK, so a
+    // small limit would make allocations fail. Lock only when that cannot
+    // happen: root (CAP_IPC_LOCK) or an unlimited limit.
+    rlimit limit{};
+    if (geteuid() != 0 &&
+        (getrlimit(RLIMIT_MEMLOCK, &limit) != 0 || limit.rlim_cur != RLIM_INFINITY)) {
+        add_error(status, "mlockall: RLIMIT_MEMLOCK is limited");
+        return false;
+    }
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        add_error(status, errno_text("mlockall", errno));
+        return false;
+    }
+#if defined(__GLIBC__)
+    // Keep freed memory (and its locked pages) in the heap, and serve large
+    // allocations from it rather than from fresh mmap()s.
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+#endif
+    return true;
+}
+
+#endif // __linux__
+
+} // namespace
+
+RealtimeStatus make_thread_realtime(const RealtimeOptions& options)
+{
+    RealtimeStatus status;
+#if defined(__linux__)
+    if (options.cpu >= 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(options.cpu, &cpus);
+        const int error = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+        if (error == 0) {
+            status.pinned = true;
+        } else {
+            add_error(status, errno_text("pthread_setaffinity_np", error));
+        }
+    }
+
+    if (options.fifo_priority > 0) {
+        sched_param param{};
+        param.sched_priority = options.fifo_priority;
+        const int error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (error == 0) {
+            status.fifo = true;
+        } else {
+            add_error(status, errno_text("SCHED_FIFO", error));
+        }
+    }
+
+    if (options.lock_memory) {
+        status.memory_locked = lock_memory(status);
+        prefault_stack(options.prefault_stack_bytes);
+    }
+#else
+    if (options.enabled()) {
+        add_error(status, "real-time mode is only supported on Linux");
+    }
+#endif
+    return status;
+}
+
+std::ostream& operator<<(std::ostream& str, RealtimeStatus const& status)
+{
+    str << "pinned: " << (status.pinned ? "yes" : "no")
+        << ", SCHED_FIFO: " << (status.fifo ? "yes" : "no")
+        << ", memory locked: " << (status.memory_locked ? "yes" : "no");
+    if (!status.errors.empty()) {
+        str << " (" << status.errors << ')';
+    }
+    return str;
+}
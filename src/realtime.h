@@ -0,0 +1,40 @@
+#pragma once
+
+// Opt-in real-time setup for a latency-critical thread (Linux only).
+//
+// Pins the calling thread to one core and switches it to SCHED_FIFO, which
+// needs CAP_SYS_NICE or an RLIMIT_RTPRIO allowance. Optionally locks the
+// process's memory with mlockall(), stops glibc from returning freed heap to
+// the kernel and pre-faults the thread's stack, so the thread does not take
+// page faults once it runs. Every step is best effort: what was not permitted
+// is reported in RealtimeStatus and the thread carries on with the default
+// scheduling.
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+
+struct RealtimeOptions {
+    // Core to pin the thread to, or -1 to leave the affinity alone.
+    int cpu{-1};
+    // SCHED_FIFO priority (1-99), or 0 to keep the default policy.
+    int fifo_priority{0};
+    bool lock_memory{false};
+    // Stack the thread touches up front when lock_memory is set.
+    size_t prefault_stack_bytes{256 * 1024};
+
+    bool enabled() const { return cpu >= 0 || fifo_priority > 0 || lock_memory; }
+};
+
+struct RealtimeStatus {
+    bool pinned{false};
+    bool fifo{false};
+    bool memory_locked{false};
+    // Why a requested step was not applied, "; "-separated.
+    std::string errors;
+};
+
+// Applies `options` to the calling thread (and, for lock_memory, the process).
+RealtimeStatus make_thread_realtime(const RealtimeOptions& options);
+
+std::ostream& operator<<(std::ostream& str, RealtimeStatus const& status);
@@ -0,0 +1,165 @@
+#include "replay_source.h"
+
+#include "deadline_timer.h"
+
+using namespace mavsdk;
+
+ReplaySource::ReplaySource(const FlightLog& log, const Options& options) :
+    _log(log),
+    _options(options)
+{
+    // Phases that start before the first sample still get a sensible clock.
+    if (_log.size() > 0) {
+        _now_ns.store(_log[0].time_ns, std::memory_order_release);
+    }
+}
+
+void ReplaySource::subscribe_position(const Telemetry::PositionCallback& callback)
+{
+    _position_callbacks.push_back(callback);
+}
+
+void ReplaySource::subscribe_attitude_euler(const Telemetry::AttitudeEulerCallback& callback)
+{
+    _attitude_callbacks.push_back(callback);
+}
+
+void ReplaySource::subscribe_velocity_ned(const Telemetry::VelocityNedCallback& callback)
+{
+    _velocity_callbacks.push_back(callback);
+}
+
+void ReplaySource::subscribe_in_air(const Telemetry::InAirCallback& callback)
+{
+    _in_air_callbacks.push_back(callback);
+}
+
+void ReplaySource::subscribe_health(const Telemetry::HealthCallback& callback)
+{
+    _health_callbacks.push_back(callback);
+}
+
+void ReplaySource::subscribe_health_all_ok(const Telemetry::HealthAllOkCallback& callback)
+{
+    _health_all_ok_callbacks.push_back(callback);
+}
+
+size_t ReplaySource::play(MissionSequencer& sequencer)
+{
+    if (_log.size() == 0) {
+        sequencer.stop();
+        return 0;
+    }
+
+    const int64_t first_ns = _log[0].time_ns;
+    const auto started = Clock::now();
+
+    // Moves the clock to recorded time `time_ns`, first waiting until the
+    // matching wall clock time unless playing as fast as possible.
+    const auto move_to = [&](int64_t time_ns) {
+        if (_options.speed > 0.0) {
+            const auto offset = std::chrono::nanoseconds{static_cast<int64_t>(
+                static_cast<double>(time_ns - first_ns) / _options.speed)};
+            sleep_until_deadline(started + offset);
+        }
+        _now_ns.store(time_ns, std::memory_order_release);
+    };
+
+    if (!sequencer.wait_idle()) {
+        return 0;
+    }
+
+    size_t played = 0;
+    for (size_t i = 0; i < _log.size(); ++i) {
+        const auto& record = _log[i];
+
+        // Deadlines before this sample fire at their own time, as they would
+        // have live.
+        for (auto deadline = sequencer.next_deadline();
+             deadline.time_since_epoch().count() <= record.time_ns;
+             deadline = sequencer.next_deadline()) {
+            if (_stop_requested.load(std::memory_order_relaxed)) {
+                return played;
+            }
+            move_to(deadline.time_since_epoch().count());
+            sequencer.advance();
+            if (!sequencer.wait_idle()) {
+                return played;
+            }
+        }
+
+        if (_stop_requested.load(std::memory_order_relaxed)) {
+            return played;
+        }
+        move_to(record.time_ns);
+        deliver(record);
+        ++played;
+        if (!sequencer.wait_idle()) {
+            return played;
+        }
+    }
+
+    // The recording has nothing more to say; the mission can't finish.
+    sequencer.stop();
+    return played;
+}
+
+void ReplaySource::deliver(const flight_record::Record& record)
+{
+    flight_record::Position position;
+    flight_record::Attitude attitude;
+    flight_record::VelocityNed velocity;
+    flight_record::InAir in_air;
+    flight_record::Health health;
+
+    if (FlightLog::get(record, position)) {
+        Telemetry::Position value{};
+        value.latitude_deg = position.latitude_deg;
+        value.longitude_deg = position.longitude_deg;
+        value.absolute_altitude_m = position.absolute_altitude_m;
+        value.relative_altitude_m = position.relative_altitude_m;
+        for (const auto& callback : _position_callbacks) {
+            callback(value);
+        }
+    } else if (FlightLog::get(record, attitude)) {
+        Telemetry::EulerAngle value{};
+        value.roll_deg = attitude.roll_deg;
+        value.pitch_deg = attitude.pitch_deg;
+        value.yaw_deg = attitude.yaw_deg;
+        for (const auto& callback : _attitude_callbacks) {
+            callback(value);
+        }
+    } else if (FlightLog::get(record, velocity)) {
+        Telemetry::VelocityNed value{};
+        value.north_m_s = velocity.north_m_s;
+        value.east_m_s = velocity.east_m_s;
+        value.down_m_s = velocity.down_m_s;
+        for (const auto& callback : _velocity_callbacks) {
+            callback(value);
+        }
+    } else if (FlightLog::get(record, in_air)) {
+        for (const auto& callback : _in_air_callbacks) {
+            callback(in_air.in_air != 0);
+        }
+    } else if (FlightLog::get(record, health)) {
+        using Bits = flight_record::Health::Bits;
+        Telemetry::Health value{};
+        value.is_gyrometer_calibration_ok = (health.bits & Bits::GyrometerCalibrationOk) != 0;
+        value.is_accelerometer_calibration_ok =
+            (health.bits & Bits::AccelerometerCalibrationOk) != 0;
+        value.is_magnetometer_calibration_ok =
+            (health.bits & Bits::MagnetometerCalibrationOk) != 0;
+        value.is_local_position_ok = (health.bits & Bits::LocalPositionOk) != 0;
+        value.is_global_position_ok = (health.bits & Bits::GlobalPositionOk) != 0;
+        value.is_home_position_ok = (health.bits & Bits::HomePositionOk) != 0;
+        value.is_armable = (health.bits & Bits::Armable) != 0;
+        for (const auto& callback : _health_callbacks) {
+            callback(value);
+        }
+        // MAVSDK derives health_all_ok from the same message.
+        const bool all_ok = health.bits == flight_record::Health::all_ok;
+        for (const auto& callback : _health_all_ok_callbacks) {
+            callback(all_ok);
+        }
+    }
+}
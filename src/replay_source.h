@@ -0,0 +1,72 @@
+#pragma once
+
+// Plays a flight recording back through Telemetry-style callbacks.
+//
+// Samples are delivered with the callback types of Telemetry::subscribe_*(),
+// so code written against a live system can be fed a past flight unchanged.
+// play() runs in lockstep with a MissionSequencer whose clock is now(). It
+// moves the clock to each sample's recorded time, delivers the sample, and
+// waits until the sequencer has acted on it. Phase deadlines between two
+// samples fire at their own time. So every decision happens at the same
+// recorded instant, whether playback runs at 1x, Nx or as fast as possible.
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#include <mavsdk/plugins/telemetry/telemetry.h>
+
+#include "flight_log.h"
+#include "mission_sequencer.h"
+
+class ReplaySource {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Options {
+        // Playback speed relative to the recording. 0 plays as fast as possible.
+        double speed{1.0};
+    };
+
+    ReplaySource(const FlightLog& log, const Options& options);
+
+    ReplaySource(const ReplaySource&) = delete;
+    ReplaySource& operator=(const ReplaySource&) = delete;
+
+    // Callbacks run on the thread calling play(). Subscribe before play().
+    void subscribe_position(const mavsdk::Telemetry::PositionCallback& callback);
+    void subscribe_attitude_euler(const mavsdk::Telemetry::AttitudeEulerCallback& callback);
+    void subscribe_velocity_ned(const mavsdk::Telemetry::VelocityNedCallback& callback);
+    void subscribe_in_air(const mavsdk::Telemetry::InAirCallback& callback);
+    void subscribe_health(const mavsdk::Telemetry::HealthCallback& callback);
+    void subscribe_health_all_ok(const mavsdk::Telemetry::HealthAllOkCallback& callback);
+
+    // Recorded time of the newest sample played: the clock to give the
+    // sequencer with MissionSequencer::set_clock().
+    Clock::time_point now() const
+    {
+        return Clock::time_point{std::chrono::nanoseconds{_now_ns.load(std::memory_order_acquire)}};
+    }
+
+    // Plays the recording in lockstep with `sequencer`, whose run() must be
+    // running or about to run on another thread. Returns once the recording
+    // is exhausted, in which case it stops the sequencer, or once run() has
+    // returned, or after stop(). Returns the number of samples played.
+    size_t play(MissionSequencer& sequencer);
+    void stop() { _stop_requested.store(true, std::memory_order_relaxed); }
+
+private:
+    void deliver(const flight_record::Record& record);
+
+    const FlightLog& _log;
+    const Options _options;
+    std::atomic<int64_t> _now_ns{0};
+    std::atomic<bool> _stop_requested{false};
+
+    std::vector<mavsdk::Telemetry::PositionCallback> _position_callbacks;
+    std::vector<mavsdk::Telemetry::AttitudeEulerCallback> _attitude_callbacks;
+    std::vector<mavsdk::Telemetry::VelocityNedCallback> _velocity_callbacks;
+    std::vector<mavsdk::Telemetry::InAirCallback> _in_air_callbacks;
+    std::vector<mavsdk::Telemetry::HealthCallback> _health_callbacks;
+    std::vector<mavsdk::Telemetry::HealthAllOkCallback> _health_all_ok_callbacks;
+};
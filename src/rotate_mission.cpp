@@ -0,0 +1,328 @@
+#include "rotate_mission.h"
+
+#include <iostream>
+
+#include "alloc_tracker.h"
+
+using namespace mavsdk;
+
+RotateMission::RotateMission(Vehicle& vehicle, const MissionParams& params) :
+    _vehicle(vehicle),
+    _params(params),
+    _health_gate(params),
+    _ready_gate(params)
+{
+    add_phases();
+}
+
+RotateMission::~RotateMission()
+{
+    detach();
+}
+
+// The telemetry handlers run for every sample of the flight and must not
+// allocate (checked by rotate_alloc_tracked, see alloc_tracker.h).
+void RotateMission::on_position(const Telemetry::Position& position)
+{
+    const alloc_tracking::HotRegion hot;
+    _telemetry_cache.update_position(position);
+    const bool checked = _geofence != nullptr && _telemetry_cache.in_air().value;
+    auto breach = checked ? _geofence->check(position) : Geofence::Breach::None;
+    _sequencer.update([&](FlightState& state) {
+        state.relative_altitude_m = position.relative_altitude_m;
+        if (breach != Geofence::Breach::BelowFloor) {
+            _above_floor = _above_floor || checked;
+        } else if (!_above_floor) {
+            breach = Geofence::Breach::None;
+        }
+        if (state.fence_breach == 0) {
+            state.fence_breach = static_cast<uint8_t>(breach);
+        }
+    });
+}
+
+void RotateMission::on_attitude(const Telemetry::EulerAngle& attitude)
+{
+    const alloc_tracking::HotRegion hot;
+    // Only read when Offboard starts; no phase waits on it.
+    _telemetry_cache.update_attitude(attitude);
+}
+
+void RotateMission::on_in_air(bool in_air)
+{
+    const alloc_tracking::HotRegion hot;
+    _telemetry_cache.update_in_air(in_air);
+    _sequencer.update([&](FlightState& state) { state.in_air = in_air; });
+}
+
+void RotateMission::on_health(const Telemetry::Health& health)
+{
+    const alloc_tracking::HotRegion hot;
+    const uint32_t bits = HealthGate::bits(health);
+    const auto now = _sequencer.now();
+    _sequencer.update([&](FlightState& state) {
+        state.health_bits = bits;
+        _health_gate.update(bits, now);
+    });
+}
+
+Geofence::Breach RotateMission::breach() const
+{
+    return static_cast<Geofence::Breach>(_sequencer.state().fence_breach);
+}
+
+std::string RotateMission::health_missing() const
+{
+    return HealthGate::names(_health_gate.missing(_sequencer.state().health_bits));
+}
+
+void RotateMission::attach(TelemetryBus& bus)
+{
+    detach();
+    _bus = &bus;
+
+    _position_subscription = bus.position().subscribe(
+        [this](const Stamped<Telemetry::Position>& position) { on_position(position.value); });
+    _attitude_subscription = bus.attitude().subscribe(
+        [this](const Stamped<Telemetry::EulerAngle>& attitude) { on_attitude(attitude.value); });
+    _in_air_subscription =
+        bus.in_air().subscribe([this](const Stamped<bool>& in_air) { on_in_air(in_air.value); });
+    _health_subscription = bus.health().subscribe(
+        [this](const Stamped<Telemetry::Health>& health) { on_health(health.value); });
+}
+
+void RotateMission::detach()
+{
+    if (_bus == nullptr) {
+        return;
+    }
+    _bus->position().unsubscribe(_position_subscription);
+    _bus->attitude().unsubscribe(_attitude_subscription);
+    _bus->in_air().unsubscribe(_in_air_subscription);
+    _bus->health().unsubscribe(_health_subscription);
+    _bus = nullptr;
+}
+
+void RotateMission::add_phases()
+{
+    // Wait until every required health check is ok, for at most health_timeout
+    auto& health = _sequencer.add_phase("health");
+    health.enter = [this]() {
+        _vehicle.set_rate_profile(rate_profiles::idle);
+        std::cout << "Vehicle is getting ready to arm...\n";
+        const auto now = _sequencer.now();
+        _sequencer.update([&](FlightState&) { _health_gate.start(now); });
+        return true;
+    };
+    // Runs under the sequencer's lock: keep a copy of the gate for arm to print.
+    health.done = [this](const FlightState& state) {
+        if (!_health_gate.ready(state.health_bits)) {
+            return false;
+        }
+        _ready_gate = _health_gate;
+        return true;
+    };
+    health.deadline = [this]() { return _sequencer.now() + _params.health_timeout; };
+
+    // Arm
+    auto& arm = _sequencer.add_phase("arm");
+    arm.enter = [this]() {
+        std::cout << "Ready to arm, last was " << HealthGate::names(_ready_gate.last_ready())
+                  << " (";
+        _ready_gate.print_timeline(std::cout);
+        std::cout << ")\n";
+        std::cout << "Arming...\n";
+        return _vehicle.arm();
+    };
+
+    // Set takeoff altitude and take off
+    auto& takeoff = _sequencer.add_phase("takeoff");
+    takeoff.enter = [this]() {
+        _start = _sequencer.now();
+        _vehicle.set_rate_profile(rate_profiles::climb);
+        std::cout << "Taking off...\n";
+        return _vehicle.takeoff(_params.takeoff_altitude_m);
+    };
+
+    // Wait until we reach ~1.7 m. A geofence breach or a failed Offboard
+    // start skips ahead to landing through every phase up to it.
+    auto& climb = _sequencer.add_phase("climb");
+    climb.done = [this](const FlightState& state) {
+        if (landing_early(state)) {
+            return true;
+        }
+        if (state.relative_altitude_m >= _params.climb_threshold_m) {
+            std::cout << "Altitude above " << _params.climb_threshold_m
+                      << " m, Hi, Monalisa and Lenna!\n";
+            return true;
+        }
+        return false;
+    };
+
+    // Switch to offboard, starting from the current heading
+    auto& offboard = _sequencer.add_phase("offboard");
+    offboard.enter = [this]() {
+        if (breach() != Geofence::Breach::None) {
+            return true;
+        }
+        _vehicle.set_rate_profile(rate_profiles::offboard_control);
+        std::cout << "Starting offboard...\n";
+        if (!_vehicle.start_offboard(_telemetry_cache.attitude().value.yaw_deg)) {
+            // Without offboard we can still land safely.
+            _sequencer.update([](FlightState& state) { state.offboard_failed = true; });
+        }
+        return true;
+    };
+
+    // Rotate while climbing to the target altitude
+    auto& rotate = _sequencer.add_phase("rotate");
+    rotate.done = [this](const FlightState& state) {
+        return landing_early(state) || state.relative_altitude_m >= _params.target_altitude_m;
+    };
+    rotate.deadline = [this]() { return _start + _params.max_wait; };
+    rotate.ends_at_deadline = true;
+
+    // Hover until the safety timeout since takeoff has run out, unless landing early
+    auto& hover = _sequencer.add_phase("hover");
+    hover.enter = [this]() {
+        if (landing_early(_sequencer.state())) {
+            return true;
+        }
+        _vehicle.hold();
+        std::cout << "Hovering...\n";
+        return true;
+    };
+    hover.done = [](const FlightState& state) { return landing_early(state); };
+    hover.deadline = [this]() { return _start + _params.max_wait; };
+    hover.ends_at_deadline = true;
+
+    // Land
+    auto& land = _sequencer.add_phase("land");
+    land.enter = [this]() {
+        _vehicle.set_rate_profile(rate_profiles::landing);
+        const auto fence_breach = breach();
+        if (fence_breach != Geofence::Breach::None &&
+            _geofence->response() == Geofence::Response::ReturnToLaunch) {
+            std::cout << "Geofence breach (" << fence_breach << "), returning to launch...\n";
+            if (!_vehicle.return_to_launch()) {
+                return false;
+            }
+            std::cout << "Vehicle is returning to launch...\n";
+            return true;
+        }
+        if (fence_breach != Geofence::Breach::None) {
+            std::cout << "Geofence breach (" << fence_breach << ")\n";
+        }
+        std::cout << "Landing...\n";
+        if (!_vehicle.land()) {
+            return false;
+        }
+        std::cout << "Vehicle is landing...\n";
+        return true;
+    };
+    land.done = [](const FlightState& state) { return !state.in_air; };
+}
+
+MavsdkMissionVehicle::MavsdkMissionVehicle(
+    Telemetry& telemetry,
+    Action& action,
+    Offboard& offboard,
+    const MissionParams& params) :
+    MavsdkMissionVehicle(telemetry, action, offboard, params, RuntimeClimbRotateLaw{params})
+{}
+
+MavsdkMissionVehicle::~MavsdkMissionVehicle()
+{
+    _streamer.stop();
+}
+
+void MavsdkMissionVehicle::set_rate_profile(const RateProfile& profile)
+{
+    _rates.apply(profile);
+}
+
+bool MavsdkMissionVehicle::arm()
+{
+    // Independent of arming, so both are in flight together.
+    _takeoff_altitude = _commands.set_takeoff_altitude(_params.takeoff_altitude_m);
+    const auto arm_result = _commands.arm().get();
+    if (arm_result != Action::Result::Success) {
+        std::cerr << "Arming failed: " << arm_result << '\n';
+        return false;
+    }
+    return true;
+}
+
+bool MavsdkMissionVehicle::takeoff(float altitude_m)
+{
+    if (!_takeoff_altitude.valid() || altitude_m != _params.takeoff_altitude_m) {
+        _takeoff_altitude = _commands.set_takeoff_altitude(altitude_m);
+    }
+    const auto altitude_result = _takeoff_altitude.get();
+    if (altitude_result != Action::Result::Success) {
+        std::cerr << "Setting takeoff altitude failed: " << altitude_result << '\n';
+    }
+    const auto takeoff_result = _commands.takeoff().get();
+    if (takeoff_result != Action::Result::Success) {
+        std::cerr << "Takeoff failed: " << takeoff_result << '\n';
+        return false;
+    }
+    return true;
+}
+
+bool MavsdkMissionVehicle::start_offboard(float yaw_deg)
+{
+    // Holding position until Offboard is confirmed.
+    _setpoint.yaw_deg = yaw_deg;
+    _climbing = false;
+    if (!_streamer.start()) {
+        std::cerr << "Sending first setpoint failed\n";
+        return false;
+    }
+    const auto offboard_result = _offboard.start();
+    if (offboard_result != Offboard::Result::Success) {
+        std::cerr << "Offboard start failed: " << offboard_result << '\n';
+        _streamer.stop();
+        return false;
+    }
+    _climbing = true;
+    return true;
+}
+
+void MavsdkMissionVehicle::hold()
+{
+    _climbing = false;
+}
+
+void MavsdkMissionVehicle::stop_offboard()
+{
+    if (_streamer.is_running()) {
+        const auto offboard_result = _offboard.stop();
+        if (offboard_result != Offboard::Result::Success) {
+            std::cerr << "Offboard stop failed: " << offboard_result << '\n';
+        }
+        _streamer.stop();
+    }
+}
+
+bool MavsdkMissionVehicle::land()
+{
+    stop_offboard();
+    const auto land_result = _commands.land().get();
+    if (land_result != Action::Result::Success) {
+        std::cerr << "Land failed: " << land_result << '\n';
+        return false;
+    }
+    return true;
+}
+
+bool MavsdkMissionVehicle::return_to_launch()
+{
+    stop_offboard();
+    const auto rtl_result = _commands.return_to_launch().get();
+    if (rtl_result != Action::Result::Success) {
+        std::cerr << "Return to launch failed: " << rtl_result << '\n';
+        return false;
+    }
+    return true;
+}
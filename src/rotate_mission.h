@@ -0,0 +1,200 @@
+#pragma once
+
+// rotate's single-vehicle mission: wait for health -> arm -> take off -> climb
+// -> Offboard rotate while climbing -> hover -> land.
+//
+// The mission sees the vehicle only through the on_*() telemetry callbacks and
+// the Vehicle commands. So the same phases and decisions can run against a
+// live MAVSDK system or against a recording played back by ReplaySource.
+//
+// With a Geofence, a breach while in the air cuts the climb, rotation or hover
+// short and goes straight to landing, or returns to launch instead.
+
+#include <atomic>
+#include <future>
+
+#include <mavsdk/plugins/action/action.h>
+#include <mavsdk/plugins/offboard/offboard.h>
+#include <mavsdk/plugins/telemetry/telemetry.h>
+
+#include "async_action.h"
+#include "flight_profile.h"
+#include "geofence.h"
+#include "health_gate.h"
+#include "mission_params.h"
+#include "mission_sequencer.h"
+#include "rate_profile.h"
+#include "setpoint_streamer.h"
+#include "telemetry_bus.h"
+#include "telemetry_cache.h"
+
+class RotateMission {
+public:
+    // Commands the mission sends. Returning false aborts the mission.
+    class Vehicle {
+    public:
+        virtual ~Vehicle() = default;
+
+        // Switches the telemetry rates for the phase that is starting.
+        // Must not block.
+        virtual void set_rate_profile(const RateProfile& profile) = 0;
+        virtual bool arm() = 0;
+        virtual bool takeoff(float altitude_m) = 0;
+        // Starts rotating while climbing from `yaw_deg` in Offboard. On
+        // failure the mission lands instead of aborting, as it is airborne.
+        virtual bool start_offboard(float yaw_deg) = 0;
+        // Stops climbing and rotating but stays in Offboard.
+        virtual void hold() = 0;
+        // Leaves Offboard if it was started, then lands.
+        virtual bool land() = 0;
+        // Leaves Offboard if it was started, then flies home and lands.
+        virtual bool return_to_launch() = 0;
+    };
+
+    explicit RotateMission(Vehicle& vehicle, const MissionParams& params = {});
+    ~RotateMission();
+
+    RotateMission(const RotateMission&) = delete;
+    RotateMission& operator=(const RotateMission&) = delete;
+
+    // Telemetry callbacks, with the signatures of Telemetry::subscribe_*().
+    void on_position(const mavsdk::Telemetry::Position& position);
+    void on_attitude(const mavsdk::Telemetry::EulerAngle& attitude);
+    void on_in_air(bool in_air);
+    void on_health(const mavsdk::Telemetry::Health& health);
+
+    // Subscribes the callbacks above to the bus's topics, each delivered on
+    // its own thread. The bus must outlive the mission, and the mission must
+    // outlive the subscriptions or call detach() first.
+    void attach(TelemetryBus& bus);
+    void detach();
+
+    // Checks every position sample against `fence` while in the air. Call
+    // before attach(); the fence must outlive the mission.
+    void set_geofence(const Geofence* fence) { _geofence = fence; }
+
+    // For set_clock(), set_phase_end_callback() and last_phase().
+    MissionSequencer& sequencer() { return _sequencer; }
+
+    // Flies the mission on the calling thread.
+    MissionSequencer::Result run() { return _sequencer.run(); }
+
+    // Names of the required health checks that are not ok, e.g. why the
+    // health phase timed out.
+    std::string health_missing() const;
+
+private:
+    void add_phases();
+    Geofence::Breach breach() const;
+    // Skip the rest of the climb, rotation and hover and land.
+    static bool landing_early(const FlightState& state)
+    {
+        return state.fence_breach != 0 || state.offboard_failed;
+    }
+
+    Vehicle& _vehicle;
+    const MissionParams _params;
+    MissionSequencer _sequencer;
+    TelemetryCache _telemetry_cache;
+    // Only touched inside _sequencer updates and phase conditions.
+    HealthGate _health_gate;
+    // _health_gate as the health phase passed, for arm to print outside the
+    // lock.
+    HealthGate _ready_gate;
+    // Takeoff time on the sequencer's clock; the hover deadline counts from it.
+    MissionSequencer::Clock::time_point _start{};
+
+    const Geofence* _geofence{nullptr};
+    // The altitude floor only counts once the vehicle has climbed above it.
+    // Only touched inside _sequencer updates.
+    bool _above_floor{false};
+
+    TelemetryBus* _bus{nullptr};
+    std::shared_ptr<BusTopic<mavsdk::Telemetry::Position>::Subscription> _position_subscription;
+    std::shared_ptr<BusTopic<mavsdk::Telemetry::EulerAngle>::Subscription> _attitude_subscription;
+    std::shared_ptr<BusTopic<bool>::Subscription> _in_air_subscription;
+    std::shared_ptr<BusTopic<mavsdk::Telemetry::Health>::Subscription> _health_subscription;
+};
+
+// RotateMission::Vehicle for a live system. Offboard control streams velocity
+// setpoints from a SetpointStreamer at setpoint_rate_hz, climbing at
+// climb_rate_m_s and yawing at yaw_rate_deg_s until hold(). Rate profiles go
+// through a RateSwitcher. Commands go out through AsyncAction; arm() also sends
+// the takeoff altitude, so that request is already answered when takeoff()
+// needs it.
+class MavsdkMissionVehicle : public RotateMission::Vehicle {
+public:
+    // Setpoints from a RuntimeClimbRotateLaw over `params`.
+    MavsdkMissionVehicle(
+        mavsdk::Telemetry& telemetry,
+        mavsdk::Action& action,
+        mavsdk::Offboard& offboard,
+        const MissionParams& params);
+
+    // Setpoints from a compiled profile's law, with its constants inlined into
+    // the streaming thread's generator.
+    template<typename Profile>
+    MavsdkMissionVehicle(
+        mavsdk::Telemetry& telemetry,
+        mavsdk::Action& action,
+        mavsdk::Offboard& offboard,
+        ClimbRotateLaw<Profile> law) :
+        MavsdkMissionVehicle(telemetry, action, offboard, Profile::params, law)
+    {}
+
+    // Setpoints from `law`: anything with the next() of RuntimeClimbRotateLaw,
+    // such as QuinticClimbRotateLaw. It is captured by value in the streaming
+    // thread's generator.
+    template<typename Law>
+    MavsdkMissionVehicle(
+        mavsdk::Telemetry& telemetry,
+        mavsdk::Action& action,
+        mavsdk::Offboard& offboard,
+        const MissionParams& params,
+        Law law) :
+        _commands(action),
+        _offboard(offboard),
+        _params(params),
+        _rates(telemetry),
+        _streamer(
+            params.setpoint_rate_hz,
+            [this, law](SetpointStreamer::Clock::time_point deadline) {
+                return law.next(_setpoint, _climbing.load(std::memory_order_relaxed), deadline);
+            },
+            SetpointStreamer::offboard_sink(offboard))
+    {}
+
+    ~MavsdkMissionVehicle() override;
+
+    void set_rate_profile(const RateProfile& profile) override;
+    bool arm() override;
+    bool takeoff(float altitude_m) override;
+    bool start_offboard(float yaw_deg) override;
+    void hold() override;
+    bool land() override;
+    bool return_to_launch() override;
+
+    // Stops the setpoint stream, e.g. when the mission was aborted.
+    void stop_streaming() { _streamer.stop(); }
+    SetpointStreamer::Stats stream_stats() const { return _streamer.stats(); }
+    // Real-time setup of the setpoint thread; see SetpointStreamer.
+    void set_realtime(const RealtimeOptions& options) { _streamer.set_realtime(options); }
+    const RealtimeStatus& realtime_status() const { return _streamer.realtime_status(); }
+    const RateSwitcher& rates() const { return _rates; }
+
+private:
+    void stop_offboard();
+
+    AsyncAction _commands;
+    mavsdk::Offboard& _offboard;
+    const MissionParams _params;
+    RateSwitcher _rates;
+    // set_takeoff_altitude sent by arm().
+    std::future<mavsdk::Action::Result> _takeoff_altitude;
+
+    std::atomic<bool> _climbing{false};
+    // Only touched by the streamer thread once it runs.
+    ClimbRotateState _setpoint{};
+
+    SetpointStreamer _streamer;
+};
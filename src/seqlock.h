@@ -0,0 +1,71 @@
+#pragma once
+
+// Single-writer sequence lock for small trivially copyable values.
+//
+// The writer never waits. Readers never block the writer and never take a
+// lock; a read only retries if it overlapped a write, which for a
+// telemetry-rate writer practically never happens twice in a row. The payload
+// is kept in relaxed atomic words so concurrent reads are data-race free.
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+template<typename T> class SeqLock {
+public:
+    static_assert(std::is_trivially_copyable_v<T>, "SeqLock requires a trivially copyable type");
+
+    SeqLock()
+    {
+        for (auto& word : _words) {
+            word.store(0, std::memory_order_relaxed);
+        }
+    }
+    explicit SeqLock(const T& value) { store(value); }
+
+    // Must only be called from one thread at a time.
+    void store(const T& value)
+    {
+        uint64_t words[word_count]{};
+        std::memcpy(words, &value, sizeof(T));
+
+        const auto sequence = _sequence.load(std::memory_order_relaxed);
+        _sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        for (size_t i = 0; i < word_count; ++i) {
+            _words[i].store(words[i], std::memory_order_relaxed);
+        }
+
+        _sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    T load() const
+    {
+        uint64_t words[word_count];
+        uint64_t before;
+        uint64_t after;
+        do {
+            before = _sequence.load(std::memory_order_acquire);
+            for (size_t i = 0; i < word_count; ++i) {
+                words[i] = _words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = _sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) != 0 || before != after);
+
+        T value;
+        std::memcpy(&value, words, sizeof(T));
+        return value;
+    }
+
+    // Number of completed stores. Lets readers skip values they have seen.
+    uint64_t version() const { return _sequence.load(std::memory_order_acquire) / 2; }
+
+private:
+    static constexpr size_t word_count = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    std::atomic<uint64_t> _sequence{0};
+    std::atomic<uint64_t> _words[word_count];
+};
@@ -0,0 +1,179 @@
+#include "setpoint_streamer.h"
+
+#include <algorithm>
+#include <future>
+#include <utility>
+
+#include "alloc_tracker.h"
+#include "deadline_timer.h"
+
+using namespace mavsdk;
+
+namespace {
+
+void update_max(std::atomic<uint64_t>& max, uint64_t value)
+{
+    auto current = max.load(std::memory_order_relaxed);
+    while (value > current &&
+           !max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+} // namespace
+
+Setpoint Setpoint::from_velocity(const Offboard::VelocityNedYaw& velocity)
+{
+    Setpoint setpoint;
+    setpoint.type = Type::Velocity;
+    setpoint.velocity = velocity;
+    return setpoint;
+}
+
+Setpoint Setpoint::from_position(const Offboard::PositionNedYaw& position)
+{
+    Setpoint setpoint;
+    setpoint.type = Type::Position;
+    setpoint.position = position;
+    return setpoint;
+}
+
+SetpointStreamer::SetpointStreamer(double rate_hz, Generator generator, Sink sink) :
+    _rate_hz(std::clamp(rate_hz, min_rate_hz, max_rate_hz)),
+    _period(std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(1.0 / _rate_hz))),
+    _generator(std::move(generator)),
+    _sink(std::move(sink))
+{}
+
+SetpointStreamer::~SetpointStreamer()
+{
+    stop();
+}
+
+bool SetpointStreamer::start()
+{
+    if (_running.load()) {
+        return true;
+    }
+
+    const auto now = Clock::now();
+    _last_send = now;
+    if (!_sink(_generator(now))) {
+        _send_failures.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    _sent.fetch_add(1, std::memory_order_relaxed);
+
+    _running = true;
+    std::promise<RealtimeStatus> realtime;
+    auto realtime_status = realtime.get_future();
+    _thread = std::thread([this, realtime = std::move(realtime)]() mutable {
+        const auto status = make_thread_realtime(_realtime);
+        // Offboard::start() follows start(), so the setup time is not a gap
+        // PX4 sees.
+        _last_send = Clock::now();
+        realtime.set_value(status);
+        run();
+    });
+    _realtime_status = realtime_status.get();
+    return true;
+}
+
+void SetpointStreamer::stop()
+{
+    _running = false;
+    if (_thread.joinable()) {
+        _thread.join();
+    }
+}
+
+void SetpointStreamer::run()
+{
+    auto deadline = Clock::now() + _period;
+
+    while (_running.load(std::memory_order_relaxed)) {
+        sleep_until_deadline(deadline);
+
+        const auto now = Clock::now();
+        const auto lateness = now - deadline;
+        record_jitter(lateness);
+
+        if (lateness >= _period) {
+            // Whole periods went by while we were not scheduled. Skip them
+            // instead of catching up with a burst of stale setpoints.
+            const auto missed = static_cast<uint64_t>(lateness / _period);
+            _missed_deadlines.fetch_add(missed, std::memory_order_relaxed);
+            deadline += _period * static_cast<Clock::rep>(missed);
+        }
+
+        Setpoint setpoint;
+        {
+            // The control law runs every period and must not allocate.
+            const alloc_tracking::HotRegion hot;
+            setpoint = _generator(deadline);
+        }
+        send(setpoint, now);
+        deadline += _period;
+    }
+}
+
+void SetpointStreamer::send(const Setpoint& setpoint, Clock::time_point now)
+{
+    if (_sink(setpoint)) {
+        _sent.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        _send_failures.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    const auto gap_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now - _last_send);
+    update_max(_gap_max_ns, static_cast<uint64_t>(gap_ns.count()));
+    _last_send = now;
+}
+
+void SetpointStreamer::record_jitter(Clock::duration lateness)
+{
+    const auto ns = static_cast<uint64_t>(std::max<int64_t>(
+        0, std::chrono::duration_cast<std::chrono::nanoseconds>(lateness).count()));
+
+    _jitter_samples.fetch_add(1, std::memory_order_relaxed);
+    _jitter_sum_ns.fetch_add(ns, std::memory_order_relaxed);
+    update_max(_jitter_max_ns, ns);
+
+    size_t bucket = 0;
+    while (bucket < jitter_bucket_us.size() && ns > jitter_bucket_us[bucket] * 1000ull) {
+        ++bucket;
+    }
+    _jitter_histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+SetpointStreamer::Stats SetpointStreamer::stats() const
+{
+    Stats stats;
+    stats.sent = _sent.load(std::memory_order_relaxed);
+    stats.send_failures = _send_failures.load(std::memory_order_relaxed);
+    stats.missed_deadlines = _missed_deadlines.load(std::memory_order_relaxed);
+
+    const auto samples = _jitter_samples.load(std::memory_order_relaxed);
+    if (samples > 0) {
+        stats.mean_jitter_us =
+            static_cast<double>(_jitter_sum_ns.load(std::memory_order_relaxed)) / 1e3 /
+            static_cast<double>(samples);
+    }
+    stats.max_jitter_us = static_cast<double>(_jitter_max_ns.load(std::memory_order_relaxed)) / 1e3;
+    stats.max_gap_us = static_cast<double>(_gap_max_ns.load(std::memory_order_relaxed)) / 1e3;
+
+    for (size_t i = 0; i < _jitter_histogram.size(); ++i) {
+        stats.jitter_histogram[i] = _jitter_histogram[i].load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+SetpointStreamer::Sink SetpointStreamer::offboard_sink(Offboard& offboard)
+{
+    return [&offboard](const Setpoint& setpoint) {
+        const auto result = setpoint.type == Setpoint::Type::Velocity ?
+                                offboard.set_velocity_ned(setpoint.velocity) :
+                                offboard.set_position_ned(setpoint.position);
+        return result == Offboard::Result::Success;
+    };
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+// Fixed-rate Offboard setpoint streamer.
+//
+// A dedicated thread sends one setpoint per period. Wakeups are scheduled on
+// absolute monotonic deadlines (clock_nanosleep with TIMER_ABSTIME on Linux),
+// so scheduling error does not accumulate the way it does with sleep_for().
+// If the thread falls behind by one or more whole periods, the missed slots are
+// counted and skipped rather than sent in a burst.
+//
+// set_realtime() opts the thread into pinning, SCHED_FIFO and locked memory
+// (realtime.h); the lateness histogram shows what that buys.
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <thread>
+
+#include <mavsdk/plugins/offboard/offboard.h>
+
+#include "realtime.h"
+
+struct Setpoint {
+    enum class Type {
+        Velocity,
+        Position,
+    };
+
+    Type type{Type::Velocity};
+    mavsdk::Offboard::VelocityNedYaw velocity{};
+    mavsdk::Offboard::PositionNedYaw position{};
+
+    static Setpoint from_velocity(const mavsdk::Offboard::VelocityNedYaw& velocity);
+    static Setpoint from_position(const mavsdk::Offboard::PositionNedYaw& position);
+};
+
+class SetpointStreamer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Produces the setpoint for the tick scheduled at `deadline`. Called on the
+    // streaming thread only.
+    using Generator = std::function<Setpoint(Clock::time_point deadline)>;
+    // Sends a setpoint. Returns false if sending failed.
+    using Sink = std::function<bool(const Setpoint& setpoint)>;
+
+    static constexpr double min_rate_hz = 50.0;
+    static constexpr double max_rate_hz = 250.0;
+
+    // Upper bounds (in us) of the lateness histogram buckets; the last bucket
+    // collects everything above the largest bound.
+    static constexpr std::array<uint32_t, 7> jitter_bucket_us{
+        {10, 50, 100, 500, 1000, 5000, 20000}};
+
+    struct Stats {
+        uint64_t sent{0};
+        uint64_t send_failures{0};
+        uint64_t missed_deadlines{0};
+        // Wakeup lateness relative to the scheduled deadline.
+        double mean_jitter_us{0.0};
+        double max_jitter_us{0.0};
+        // Longest interval between two consecutive sends. This is what PX4's
+        // offboard loss timeout sees.
+        double max_gap_us{0.0};
+        std::array<uint64_t, jitter_bucket_us.size() + 1> jitter_histogram{};
+    };
+
+    // `rate_hz` is clamped to [min_rate_hz, max_rate_hz].
+    SetpointStreamer(double rate_hz, Generator generator, Sink sink);
+    ~SetpointStreamer();
+
+    SetpointStreamer(const SetpointStreamer&) = delete;
+    SetpointStreamer& operator=(const SetpointStreamer&) = delete;
+
+    // Sends the first setpoint synchronously (Offboard::start() refuses to
+    // switch modes before one has been set), then starts the streaming thread.
+    // Returns false if that first setpoint could not be sent.
+    bool start();
+    void stop();
+
+    // Real-time setup for the streaming thread, applied as it starts. Call
+    // before start().
+    void set_realtime(const RealtimeOptions& options) { _realtime = options; }
+    // What the last start() could apply of those options.
+    const RealtimeStatus& realtime_status() const { return _realtime_status; }
+    bool is_running() const { return _running.load(std::memory_order_relaxed); }
+
+    double rate_hz() const { return _rate_hz; }
+    Stats stats() const;
+
+    // Sink that forwards setpoints to an Offboard plugin instance.
+    static Sink offboard_sink(mavsdk::Offboard& offboard);
+
+private:
+    void run();
+    void send(const Setpoint& setpoint, Clock::time_point now);
+    void record_jitter(Clock::duration lateness);
+
+    const double _rate_hz;
+    const Clock::duration _period;
+    Generator _generator;
+    Sink _sink;
+
+    std::thread _thread;
+    std::atomic<bool> _running{false};
+    RealtimeOptions _realtime{};
+    RealtimeStatus _realtime_status{};
+
+    // Written by the streaming thread only, read by stats().
+    std::atomic<uint64_t> _sent{0};
+    std::atomic<uint64_t> _send_failures{0};
+    std::atomic<uint64_t> _missed_deadlines{0};
+    std::atomic<uint64_t> _jitter_samples{0};
+    std::atomic<uint64_t> _jitter_sum_ns{0};
+    std::atomic<uint64_t> _jitter_max_ns{0};
+    std::atomic<uint64_t> _gap_max_ns{0};
+    std::array<std::atomic<uint64_t>, jitter_bucket_us.size() + 1> _jitter_histogram{};
+    Clock::time_point _last_send{};
+};
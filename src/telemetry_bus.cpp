@@ -0,0 +1,45 @@
+#include "telemetry_bus.h"
+
+using namespace mavsdk;
+
+TelemetryBus::TelemetryBus(std::pmr::memory_resource* resource) :
+    _position(resource),
+    _attitude(resource),
+    _velocity(resource),
+    _in_air(resource),
+    _health(resource)
+{}
+
+TelemetryBus::~TelemetryBus()
+{
+    detach();
+}
+
+void TelemetryBus::attach(Telemetry& telemetry)
+{
+    detach();
+    _telemetry = &telemetry;
+
+    _position_handle = telemetry.subscribe_position(
+        [this](Telemetry::Position position) { _position.publish(position); });
+    _attitude_handle = telemetry.subscribe_attitude_euler(
+        [this](Telemetry::EulerAngle attitude) { _attitude.publish(attitude); });
+    _velocity_handle = telemetry.subscribe_velocity_ned(
+        [this](Telemetry::VelocityNed velocity) { _velocity.publish(velocity); });
+    _in_air_handle = telemetry.subscribe_in_air([this](bool in_air) { _in_air.publish(in_air); });
+    _health_handle =
+        telemetry.subscribe_health([this](Telemetry::Health health) { _health.publish(health); });
+}
+
+void TelemetryBus::detach()
+{
+    if (_telemetry == nullptr) {
+        return;
+    }
+    _telemetry->unsubscribe_position(_position_handle);
+    _telemetry->unsubscribe_attitude_euler(_attitude_handle);
+    _telemetry->unsubscribe_velocity_ned(_velocity_handle);
+    _telemetry->unsubscribe_in_air(_in_air_handle);
+    _telemetry->unsubscribe_health(_health_handle);
+    _telemetry = nullptr;
+}
@@ -0,0 +1,310 @@
+#pragma once
+
+// Typed fan-out of Telemetry samples to many consumers.
+//
+// MAVSDK runs every subscription callback of a stream one after another on
+// its callback thread, so one slow consumer delays all the others. A
+// TelemetryBus subscribes to each stream once and publishes every sample to
+// a BusTopic<T>. The topic stamps the sample and pushes it into one bounded
+// single-producer/single-consumer ring per subscriber. Each subscriber drains
+// its ring on its own thread and gets the sample by reference, read in place
+// from the ring. Publishing never waits for a subscriber. When a
+// subscriber's ring is full the sample is dropped for that subscriber alone,
+// and counted. The rings are allocated once, on subscribe(), from the
+// memory resource the bus was given (e.g. a VehicleArena).
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <mavsdk/plugins/telemetry/telemetry.h>
+
+#include "alloc_tracker.h"
+#include "telemetry_cache.h"
+
+// Bounded lock-free queue for one producer and one consumer thread.
+template<typename T> class SpscRing {
+public:
+    // `capacity` is rounded up to a power of two.
+    explicit SpscRing(
+        size_t capacity, std::pmr::memory_resource* resource = std::pmr::get_default_resource()) :
+        _slots(resource)
+    {
+        size_t size = 2;
+        while (size < capacity) {
+            size *= 2;
+        }
+        _mask = size - 1;
+        _slots.resize(size);
+    }
+
+    // Producer. Returns false if the ring is full.
+    bool push(const T& value)
+    {
+        const size_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail - _cached_head > _mask) {
+            _cached_head = _head.load(std::memory_order_acquire);
+            if (tail - _cached_head > _mask) {
+                return false;
+            }
+        }
+        _slots[tail & _mask] = value;
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer: the oldest element, or nullptr if the ring is empty. It stays
+    // valid until pop().
+    const T* front()
+    {
+        const size_t head = _head.load(std::memory_order_relaxed);
+        if (head == _cached_tail) {
+            _cached_tail = _tail.load(std::memory_order_acquire);
+            if (head == _cached_tail) {
+                return nullptr;
+            }
+        }
+        return &_slots[head & _mask];
+    }
+
+    void pop()
+    {
+        _head.store(_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // From either side; exact only when called by the consumer.
+    bool empty() const
+    {
+        return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire);
+    }
+
+private:
+    std::pmr::vector<T> _slots;
+    size_t _mask{0};
+
+    alignas(64) std::atomic<size_t> _tail{0};
+    // Producer's copy of _head.
+    size_t _cached_head{0};
+    alignas(64) std::atomic<size_t> _head{0};
+    // Consumer's copy of _tail.
+    size_t _cached_tail{0};
+};
+
+template<typename T> class BusTopic {
+public:
+    using Handler = std::function<void(const Stamped<T>& sample)>;
+
+    class Subscription {
+        // Only the topic can make one; public for std::allocate_shared.
+        struct Key {
+            explicit Key() = default;
+        };
+
+    public:
+        Subscription(
+            Key, Handler handler, size_t capacity, std::pmr::memory_resource* resource) :
+            _ring(capacity, resource),
+            _handler(std::move(handler))
+        {}
+
+        uint64_t delivered() const { return _delivered.load(std::memory_order_relaxed); }
+        uint64_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+    private:
+        friend class BusTopic;
+
+        void run()
+        {
+            while (true) {
+                if (const auto* sample = _ring.front()) {
+                    _handler(*sample);
+                    _ring.pop();
+                    _delivered.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                if (!_running.load(std::memory_order_acquire)) {
+                    return;
+                }
+                wait();
+            }
+        }
+
+        void wait()
+        {
+            // A sample usually follows soon at telemetry rates above 100 Hz;
+            // look again briefly before sleeping.
+            for (int spin = 0; spin < 64; ++spin) {
+                if (!_ring.empty()) {
+                    return;
+                }
+                std::this_thread::yield();
+            }
+            std::unique_lock<std::mutex> lock(_mutex);
+            _sleeping.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            _cv.wait(lock, [this]() {
+                return !_ring.empty() || !_running.load(std::memory_order_acquire);
+            });
+            _sleeping.store(false, std::memory_order_relaxed);
+        }
+
+        // Publisher side.
+        void push(const Stamped<T>& sample)
+        {
+            if (!_ring.push(sample)) {
+                _dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            wake();
+        }
+
+        void wake()
+        {
+            // Pairs with the fence in wait(): either the consumer sees the
+            // sample before sleeping, or we see it sleeping.
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (_sleeping.load(std::memory_order_relaxed)) {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _cv.notify_one();
+            }
+        }
+
+        void stop()
+        {
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _running.store(false, std::memory_order_release);
+            }
+            _cv.notify_one();
+            if (_thread.joinable()) {
+                _thread.join();
+            }
+        }
+
+        SpscRing<Stamped<T>> _ring;
+        Handler _handler;
+        std::thread _thread;
+        std::atomic<bool> _running{true};
+        std::atomic<bool> _sleeping{false};
+        std::mutex _mutex;
+        std::condition_variable _cv;
+        alignas(64) std::atomic<uint64_t> _delivered{0};
+        std::atomic<uint64_t> _dropped{0};
+    };
+
+    explicit BusTopic(std::pmr::memory_resource* resource = std::pmr::get_default_resource()) :
+        _resource(resource),
+        _subscriptions(resource)
+    {}
+    ~BusTopic()
+    {
+        std::lock_guard<std::mutex> lock(_subscriptions_mutex);
+        for (auto& subscription : _subscriptions) {
+            subscription->stop();
+        }
+    }
+
+    BusTopic(const BusTopic&) = delete;
+    BusTopic& operator=(const BusTopic&) = delete;
+
+    // Starts a thread that calls `handler` with every sample published from
+    // now on, in order. Up to `capacity` samples queue up for it; beyond that
+    // they are dropped for this subscription. The subscription, like its
+    // ring, comes from the topic's memory resource, which must outlive it.
+    std::shared_ptr<Subscription> subscribe(Handler handler, size_t capacity = 256)
+    {
+        auto subscription = std::allocate_shared<Subscription>(
+            std::pmr::polymorphic_allocator<Subscription>(_resource),
+            typename Subscription::Key{},
+            std::move(handler),
+            capacity,
+            _resource);
+        subscription->_thread = std::thread(&Subscription::run, subscription.get());
+        std::lock_guard<std::mutex> lock(_subscriptions_mutex);
+        _subscriptions.push_back(subscription);
+        return subscription;
+    }
+
+    // Delivers what is already queued, then stops the subscription's thread.
+    void unsubscribe(const std::shared_ptr<Subscription>& subscription)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_subscriptions_mutex);
+            for (auto it = _subscriptions.begin(); it != _subscriptions.end(); ++it) {
+                if (*it == subscription) {
+                    _subscriptions.erase(it);
+                    break;
+                }
+            }
+        }
+        subscription->stop();
+    }
+
+    // From one thread at a time, e.g. the MAVSDK callback of the stream.
+    void publish(const T& value)
+    {
+        const alloc_tracking::HotRegion hot;
+        Stamped<T> sample;
+        sample.value = value;
+        sample.received_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                 std::chrono::steady_clock::now().time_since_epoch())
+                                 .count();
+        sample.sequence = _sequence.fetch_add(1, std::memory_order_relaxed) + 1;
+
+        // Only contended by subscribe() and unsubscribe().
+        std::lock_guard<std::mutex> lock(_subscriptions_mutex);
+        for (auto& subscription : _subscriptions) {
+            subscription->push(sample);
+        }
+    }
+
+    uint64_t published() const { return _sequence.load(std::memory_order_relaxed); }
+
+private:
+    std::pmr::memory_resource* _resource;
+    std::mutex _subscriptions_mutex;
+    std::pmr::vector<std::shared_ptr<Subscription>> _subscriptions;
+    std::atomic<uint64_t> _sequence{0};
+};
+
+class TelemetryBus {
+public:
+    explicit TelemetryBus(
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+    ~TelemetryBus();
+
+    TelemetryBus(const TelemetryBus&) = delete;
+    TelemetryBus& operator=(const TelemetryBus&) = delete;
+
+    // Subscribes once to position, attitude, velocity, in-air and health and
+    // publishes every sample to the topics below. The bus must outlive the
+    // subscriptions, or detach() must be called first.
+    void attach(mavsdk::Telemetry& telemetry);
+    void detach();
+
+    BusTopic<mavsdk::Telemetry::Position>& position() { return _position; }
+    BusTopic<mavsdk::Telemetry::EulerAngle>& attitude() { return _attitude; }
+    BusTopic<mavsdk::Telemetry::VelocityNed>& velocity() { return _velocity; }
+    BusTopic<bool>& in_air() { return _in_air; }
+    BusTopic<mavsdk::Telemetry::Health>& health() { return _health; }
+
+private:
+    BusTopic<mavsdk::Telemetry::Position> _position;
+    BusTopic<mavsdk::Telemetry::EulerAngle> _attitude;
+    BusTopic<mavsdk::Telemetry::VelocityNed> _velocity;
+    BusTopic<bool> _in_air;
+    BusTopic<mavsdk::Telemetry::Health> _health;
+
+    mavsdk::Telemetry* _telemetry{nullptr};
+    mavsdk::Telemetry::PositionHandle _position_handle{};
+    mavsdk::Telemetry::AttitudeEulerHandle _attitude_handle{};
+    mavsdk::Telemetry::VelocityNedHandle _velocity_handle{};
+    mavsdk::Telemetry::InAirHandle _in_air_handle{};
+    mavsdk::Telemetry::HealthHandle _health_handle{};
+};
@@ -0,0 +1,73 @@
+#include "telemetry_cache.h"
+
+using namespace mavsdk;
+
+TelemetryCache::~TelemetryCache()
+{
+    detach();
+}
+
+void TelemetryCache::attach(Telemetry& telemetry)
+{
+    detach();
+    _telemetry = &telemetry;
+
+    _position_handle = telemetry.subscribe_position(
+        [this](Telemetry::Position position) { update_position(position); });
+    _attitude_handle = telemetry.subscribe_attitude_euler(
+        [this](Telemetry::EulerAngle attitude) { update_attitude(attitude); });
+    _velocity_handle = telemetry.subscribe_velocity_ned(
+        [this](Telemetry::VelocityNed velocity) { update_velocity(velocity); });
+    _in_air_handle = telemetry.subscribe_in_air([this](bool in_air) { update_in_air(in_air); });
+    _health_handle =
+        telemetry.subscribe_health([this](Telemetry::Health health) { update_health(health); });
+}
+
+void TelemetryCache::detach()
+{
+    if (_telemetry == nullptr) {
+        return;
+    }
+    _telemetry->unsubscribe_position(_position_handle);
+    _telemetry->unsubscribe_attitude_euler(_attitude_handle);
+    _telemetry->unsubscribe_velocity_ned(_velocity_handle);
+    _telemetry->unsubscribe_in_air(_in_air_handle);
+    _telemetry->unsubscribe_health(_health_handle);
+    _telemetry = nullptr;
+}
+
+template<typename T> void TelemetryCache::store(SeqLock<Stamped<T>>& slot, const T& value)
+{
+    Stamped<T> stamped;
+    stamped.value = value;
+    stamped.received_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now().time_since_epoch())
+                              .count();
+    stamped.sequence = slot.version() + 1;
+    slot.store(stamped);
+}
+
+void TelemetryCache::update_position(const Telemetry::Position& position)
+{
+    store(_position, position);
+}
+
+void TelemetryCache::update_attitude(const Telemetry::EulerAngle& attitude)
+{
+    store(_attitude, attitude);
+}
+
+void TelemetryCache::update_velocity(const Telemetry::VelocityNed& velocity)
+{
+    store(_velocity, velocity);
+}
+
+void TelemetryCache::update_in_air(bool in_air)
+{
+    store(_in_air, in_air);
+}
+
+void TelemetryCache::update_health(const Telemetry::Health& health)
+{
+    store(_health, health);
+}
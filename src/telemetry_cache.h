@@ -0,0 +1,79 @@
+#pragma once
+
+// Latest-value cache for the Telemetry streams.
+//
+// Each stream is kept in its own SeqLock, written from the MAVSDK callback that
+// feeds it and readable from any number of threads without locks. Every value
+// carries the local receive time and a per-stream sequence number, so a reader
+// can tell how old a sample is and whether it has already seen it.
+
+#include <chrono>
+#include <cstdint>
+
+#include <mavsdk/plugins/telemetry/telemetry.h>
+
+#include "seqlock.h"
+
+template<typename T> struct Stamped {
+    T value{};
+    // steady_clock time the sample was received, in ns since the clock's epoch.
+    int64_t received_ns{0};
+    // 0 until the first sample arrives, then counts up with every sample.
+    uint64_t sequence{0};
+
+    bool valid() const { return sequence != 0; }
+    std::chrono::steady_clock::time_point received() const
+    {
+        return std::chrono::steady_clock::time_point{std::chrono::nanoseconds{received_ns}};
+    }
+};
+
+class TelemetryCache {
+public:
+    TelemetryCache() = default;
+    ~TelemetryCache();
+
+    TelemetryCache(const TelemetryCache&) = delete;
+    TelemetryCache& operator=(const TelemetryCache&) = delete;
+
+    // Subscribes to position, attitude, velocity, in-air and health. The cache
+    // must outlive the subscriptions, or detach() must be called first.
+    void attach(mavsdk::Telemetry& telemetry);
+    void detach();
+
+    // Writers. Each stream must only be written from one thread at a time,
+    // which holds for MAVSDK callbacks.
+    void update_position(const mavsdk::Telemetry::Position& position);
+    void update_attitude(const mavsdk::Telemetry::EulerAngle& attitude);
+    void update_velocity(const mavsdk::Telemetry::VelocityNed& velocity);
+    void update_in_air(bool in_air);
+    void update_health(const mavsdk::Telemetry::Health& health);
+
+    // Readers: lock-free, callable from any thread.
+    Stamped<mavsdk::Telemetry::Position> position() const { return _position.load(); }
+    Stamped<mavsdk::Telemetry::EulerAngle> attitude() const { return _attitude.load(); }
+    Stamped<mavsdk::Telemetry::VelocityNed> velocity() const { return _velocity.load(); }
+    Stamped<bool> in_air() const { return _in_air.load(); }
+    Stamped<mavsdk::Telemetry::Health> health() const { return _health.load(); }
+
+    // Sequence number of the newest position, without copying the sample.
+    uint64_t position_sequence() const { return _position.version(); }
+
+private:
+    template<typename T> static void store(SeqLock<Stamped<T>>& slot, const T& value);
+
+    // Each on its own cache line so writers of one stream do not invalidate
+    // readers of another.
+    alignas(64) SeqLock<Stamped<mavsdk::Telemetry::Position>> _position;
+    alignas(64) SeqLock<Stamped<mavsdk::Telemetry::EulerAngle>> _attitude;
+    alignas(64) SeqLock<Stamped<mavsdk::Telemetry::VelocityNed>> _velocity;
+    alignas(64) SeqLock<Stamped<bool>> _in_air;
+    alignas(64) SeqLock<Stamped<mavsdk::Telemetry::Health>> _health;
+
+    mavsdk::Telemetry* _telemetry{nullptr};
+    mavsdk::Telemetry::PositionHandle _position_handle{};
+    mavsdk::Telemetry::AttitudeEulerHandle _attitude_handle{};
+    mavsdk::Telemetry::VelocityNedHandle _velocity_handle{};
+    mavsdk::Telemetry::InAirHandle _in_air_handle{};
+    mavsdk::Telemetry::HealthHandle _health_handle{};
+};
@@ -0,0 +1,306 @@
+#include "trajectory.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define TRAJECTORY_X86 1
+#include <immintrin.h>
+#endif
+
+namespace trajectory {
+
+namespace {
+
+// Portable batch loops, also used for the tails of the AVX2+FMA ones.
+inline void sample_times(
+    const float* __restrict c,
+    const float* __restrict d,
+    float duration_s,
+    const float* __restrict t,
+    size_t count,
+    float* __restrict position,
+    float* __restrict velocity)
+{
+    if (position != nullptr) {
+        for (size_t i = 0; i < count; ++i) {
+            const float x = std::min(std::max(t[i], 0.0f), duration_s);
+            position[i] = ((((c[5] * x + c[4]) * x + c[3]) * x + c[2]) * x + c[1]) * x + c[0];
+        }
+    }
+    if (velocity != nullptr) {
+        for (size_t i = 0; i < count; ++i) {
+            const float x = std::min(std::max(t[i], 0.0f), duration_s);
+            velocity[i] = (((d[4] * x + d[3]) * x + d[2]) * x + d[1]) * x + d[0];
+        }
+    }
+}
+
+inline void sample_lanes(
+    const QuinticLanes& lanes,
+    const float* __restrict t,
+    float* __restrict position,
+    float* __restrict velocity)
+{
+    const float* __restrict duration = lanes.duration_s;
+    if (position != nullptr) {
+        const float* __restrict c0 = lanes.position[0];
+        const float* __restrict c1 = lanes.position[1];
+        const float* __restrict c2 = lanes.position[2];
+        const float* __restrict c3 = lanes.position[3];
+        const float* __restrict c4 = lanes.position[4];
+        const float* __restrict c5 = lanes.position[5];
+        for (size_t i = 0; i < lanes.count; ++i) {
+            const float x = std::min(std::max(t[i], 0.0f), duration[i]);
+            position[i] =
+                ((((c5[i] * x + c4[i]) * x + c3[i]) * x + c2[i]) * x + c1[i]) * x + c0[i];
+        }
+    }
+    if (velocity != nullptr) {
+        const float* __restrict d0 = lanes.velocity[0];
+        const float* __restrict d1 = lanes.velocity[1];
+        const float* __restrict d2 = lanes.velocity[2];
+        const float* __restrict d3 = lanes.velocity[3];
+        const float* __restrict d4 = lanes.velocity[4];
+        for (size_t i = 0; i < lanes.count; ++i) {
+            const float x = std::min(std::max(t[i], 0.0f), duration[i]);
+            velocity[i] = (((d4[i] * x + d3[i]) * x + d2[i]) * x + d1[i]) * x + d0[i];
+        }
+    }
+}
+
+void sample_times_portable(
+    const float* c,
+    const float* d,
+    float duration_s,
+    const float* t,
+    size_t count,
+    float* position,
+    float* velocity)
+{
+    sample_times(c, d, duration_s, t, count, position, velocity);
+}
+
+void sample_lanes_portable(
+    const QuinticLanes& lanes, const float* t, float* position, float* velocity)
+{
+    sample_lanes(lanes, t, position, velocity);
+}
+
+#ifdef TRAJECTORY_X86
+
+// Eight samples per iteration; the tail goes to the portable loop.
+__attribute__((target("avx2,fma"))) void sample_times_avx2(
+    const float* c,
+    const float* d,
+    float duration_s,
+    const float* t,
+    size_t count,
+    float* position,
+    float* velocity)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 end = _mm256_set1_ps(duration_s);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256 x = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(t + i), zero), end);
+        if (position != nullptr) {
+            __m256 p = _mm256_fmadd_ps(_mm256_set1_ps(c[5]), x, _mm256_set1_ps(c[4]));
+            p = _mm256_fmadd_ps(p, x, _mm256_set1_ps(c[3]));
+            p = _mm256_fmadd_ps(p, x, _mm256_set1_ps(c[2]));
+            p = _mm256_fmadd_ps(p, x, _mm256_set1_ps(c[1]));
+            _mm256_storeu_ps(position + i, _mm256_fmadd_ps(p, x, _mm256_set1_ps(c[0])));
+        }
+        if (velocity != nullptr) {
+            __m256 v = _mm256_fmadd_ps(_mm256_set1_ps(d[4]), x, _mm256_set1_ps(d[3]));
+            v = _mm256_fmadd_ps(v, x, _mm256_set1_ps(d[2]));
+            v = _mm256_fmadd_ps(v, x, _mm256_set1_ps(d[1]));
+            _mm256_storeu_ps(velocity + i, _mm256_fmadd_ps(v, x, _mm256_set1_ps(d[0])));
+        }
+    }
+    sample_times(
+        c,
+        d,
+        duration_s,
+        t + i,
+        count - i,
+        position != nullptr ? position + i : nullptr,
+        velocity != nullptr ? velocity + i : nullptr);
+}
+
+__attribute__((target("avx2,fma"))) __m256 load(const float* lane, size_t i)
+{
+    return _mm256_loadu_ps(lane + i);
+}
+
+__attribute__((target("avx2,fma"))) void
+sample_lanes_avx2(const QuinticLanes& lanes, const float* t, float* position, float* velocity)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const auto& c = lanes.position;
+    const auto& d = lanes.velocity;
+    size_t i = 0;
+    for (; i + 8 <= lanes.count; i += 8) {
+        const __m256 x = _mm256_min_ps(
+            _mm256_max_ps(_mm256_loadu_ps(t + i), zero), _mm256_loadu_ps(lanes.duration_s + i));
+        if (position != nullptr) {
+            __m256 p = _mm256_fmadd_ps(load(c[5], i), x, load(c[4], i));
+            p = _mm256_fmadd_ps(p, x, load(c[3], i));
+            p = _mm256_fmadd_ps(p, x, load(c[2], i));
+            p = _mm256_fmadd_ps(p, x, load(c[1], i));
+            _mm256_storeu_ps(position + i, _mm256_fmadd_ps(p, x, load(c[0], i)));
+        }
+        if (velocity != nullptr) {
+            __m256 v = _mm256_fmadd_ps(load(d[4], i), x, load(d[3], i));
+            v = _mm256_fmadd_ps(v, x, load(d[2], i));
+            v = _mm256_fmadd_ps(v, x, load(d[1], i));
+            _mm256_storeu_ps(velocity + i, _mm256_fmadd_ps(v, x, load(d[0], i)));
+        }
+    }
+    if (i == lanes.count) {
+        return;
+    }
+    // The tail as a QuinticLanes view starting at lane i.
+    QuinticLanes tail;
+    for (size_t k = 0; k < c.size(); ++k) {
+        tail.position[k] = c[k] + i;
+    }
+    for (size_t k = 0; k < d.size(); ++k) {
+        tail.velocity[k] = d[k] + i;
+    }
+    tail.duration_s = lanes.duration_s + i;
+    tail.count = lanes.count - i;
+    sample_lanes(
+        tail,
+        t + i,
+        position != nullptr ? position + i : nullptr,
+        velocity != nullptr ? velocity + i : nullptr);
+}
+
+#endif // TRAJECTORY_X86
+
+bool detect_simd()
+{
+#ifdef TRAJECTORY_X86
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+    return false;
+#endif
+}
+
+bool cpu_has_simd()
+{
+    static const bool has = detect_simd();
+    return has;
+}
+
+std::atomic<bool>& use_simd()
+{
+    static std::atomic<bool> enabled{cpu_has_simd()};
+    return enabled;
+}
+
+} // namespace
+
+Quintic::Quintic(const State& start, const State& end, float duration_s) :
+    _duration_s(duration_s)
+{
+    const float T = duration_s;
+    const float T2 = T * T;
+    const float T3 = T2 * T;
+    const float delta = end.position - start.position;
+    const float v0 = start.velocity;
+    const float v1 = end.velocity;
+    const float a0 = start.acceleration;
+    const float a1 = end.acceleration;
+
+    auto& c = _position;
+    c[0] = start.position;
+    c[1] = v0;
+    c[2] = a0 / 2.0f;
+    c[3] = (20.0f * delta - (8.0f * v1 + 12.0f * v0) * T - (3.0f * a0 - a1) * T2) / (2.0f * T3);
+    c[4] = (-30.0f * delta + (14.0f * v1 + 16.0f * v0) * T + (3.0f * a0 - 2.0f * a1) * T2) /
+           (2.0f * T3 * T);
+    c[5] = (12.0f * delta - 6.0f * (v1 + v0) * T + (a1 - a0) * T2) / (2.0f * T3 * T2);
+
+    for (size_t k = 0; k < _velocity.size(); ++k) {
+        _velocity[k] = static_cast<float>(k + 1) * c[k + 1];
+    }
+    for (size_t k = 0; k < _acceleration.size(); ++k) {
+        _acceleration[k] = static_cast<float>(k + 1) * _velocity[k + 1];
+    }
+}
+
+void Quintic::sample(const float* t, size_t count, float* position, float* velocity) const
+{
+#ifdef TRAJECTORY_X86
+    if (use_simd().load(std::memory_order_relaxed)) {
+        sample_times_avx2(
+            _position.data(), _velocity.data(), _duration_s, t, count, position, velocity);
+        return;
+    }
+#endif
+    sample_times_portable(
+        _position.data(), _velocity.data(), _duration_s, t, count, position, velocity);
+}
+
+void QuinticLanes::set(size_t index, const Quintic& quintic) const
+{
+    for (size_t k = 0; k < position.size(); ++k) {
+        position[k][index] = quintic.position_coefficients()[k];
+    }
+    for (size_t k = 0; k < velocity.size(); ++k) {
+        velocity[k][index] = quintic.velocity_coefficients()[k];
+    }
+    duration_s[index] = quintic.duration_s();
+}
+
+void sample(const QuinticLanes& lanes, const float* t, float* position, float* velocity)
+{
+#ifdef TRAJECTORY_X86
+    if (use_simd().load(std::memory_order_relaxed)) {
+        sample_lanes_avx2(lanes, t, position, velocity);
+        return;
+    }
+#endif
+    sample_lanes_portable(lanes, t, position, velocity);
+}
+
+const char* batch_path()
+{
+    return use_simd().load(std::memory_order_relaxed) ? "avx2+fma" : "scalar";
+}
+
+void set_batch_simd(bool enabled)
+{
+    use_simd().store(enabled && cpu_has_simd(), std::memory_order_relaxed);
+}
+
+} // namespace trajectory
+
+QuinticClimbRotateLaw::QuinticClimbRotateLaw(const MissionParams& params)
+{
+    const float climb_m = std::max(params.target_altitude_m - params.climb_threshold_m, 0.1f);
+    const float duration_s = climb_m / params.climb_rate_m_s;
+    _altitude = trajectory::Quintic::min_jerk(0.0f, climb_m, duration_s);
+    _yaw = trajectory::Quintic::min_jerk(0.0f, params.yaw_rate_deg_s * duration_s, duration_s);
+}
+
+Setpoint QuinticClimbRotateLaw::next(
+    ClimbRotateState& state, bool climbing, SetpointStreamer::Clock::time_point deadline) const
+{
+    state.last = deadline;
+    if (!climbing) {
+        return Setpoint::from_velocity({0.0f, 0.0f, 0.0f, state.yaw_deg});
+    }
+    if (state.climb_start == SetpointStreamer::Clock::time_point{}) {
+        state.climb_start = deadline;
+        state.climb_start_yaw_deg = state.yaw_deg;
+    }
+    const float t = std::chrono::duration<float>(deadline - state.climb_start).count();
+    state.yaw_deg = std::fmod(state.climb_start_yaw_deg + _yaw.position(t), 360.0f);
+    // Up is negative down.
+    return Setpoint::from_velocity({0.0f, 0.0f, -_altitude.velocity(t), state.yaw_deg});
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+// Minimum-jerk (quintic) trajectories for the Offboard setpoint stream.
+//
+// A Quintic is a fifth-order polynomial between two position/velocity/
+// acceleration states. Its position, velocity and acceleration coefficients
+// are computed once, so a sample is a few fused multiply-adds with no
+// allocation. Time is clamped to [0, duration], so sampling past the end holds
+// the final state.
+//
+// Batch evaluation works on structure-of-arrays data: one segment at many
+// times, or many segments (vehicles) at one time each. It runs eight samples
+// at a time with AVX2+FMA when the CPU has them, picked at runtime, so no
+// special compiler flags are needed.
+
+#include <array>
+#include <cstddef>
+
+#include "flight_profile.h"
+#include "mission_params.h"
+#include "setpoint_streamer.h"
+
+namespace trajectory {
+
+struct State {
+    float position{0.0f};
+    float velocity{0.0f};
+    float acceleration{0.0f};
+};
+
+class Quintic {
+public:
+    Quintic() = default;
+
+    // From `start` to `end` in `duration_s` (> 0).
+    Quintic(const State& start, const State& end, float duration_s);
+
+    // At rest at both ends: the minimum-jerk move from p0 to p1.
+    static Quintic min_jerk(float p0, float p1, float duration_s)
+    {
+        return Quintic{State{p0}, State{p1}, duration_s};
+    }
+
+    float duration_s() const { return _duration_s; }
+
+    float position(float t) const
+    {
+        t = clamp(t);
+        const auto& c = _position;
+        return ((((c[5] * t + c[4]) * t + c[3]) * t + c[2]) * t + c[1]) * t + c[0];
+    }
+
+    float velocity(float t) const
+    {
+        t = clamp(t);
+        const auto& c = _velocity;
+        return (((c[4] * t + c[3]) * t + c[2]) * t + c[1]) * t + c[0];
+    }
+
+    float acceleration(float t) const
+    {
+        t = clamp(t);
+        const auto& c = _acceleration;
+        return ((c[3] * t + c[2]) * t + c[1]) * t + c[0];
+    }
+
+    State sample(float t) const { return State{position(t), velocity(t), acceleration(t)}; }
+
+    // position[i] and velocity[i] at t[i], for i < count. Either output may be
+    // nullptr.
+    void sample(const float* t, size_t count, float* position, float* velocity) const;
+
+    // p(t) = sum position_coefficients()[k] * t^k.
+    const std::array<float, 6>& position_coefficients() const { return _position; }
+    const std::array<float, 5>& velocity_coefficients() const { return _velocity; }
+
+private:
+    float clamp(float t) const { return t < 0.0f ? 0.0f : (t > _duration_s ? _duration_s : t); }
+
+    float _duration_s{0.0f};
+    std::array<float, 6> _position{};
+    std::array<float, 5> _velocity{};
+    std::array<float, 4> _acceleration{};
+};
+
+// Many segments in structure-of-arrays form, e.g. one per vehicle. The
+// caller owns the arrays; `count` entries of each are used.
+struct QuinticLanes {
+    // position_coefficients()[k] of every segment.
+    std::array<float*, 6> position{};
+    std::array<float*, 5> velocity{};
+    float* duration_s{nullptr};
+    size_t count{0};
+
+    // Copies `quintic` into lane `index`.
+    void set(size_t index, const Quintic& quintic) const;
+};
+
+// position[i] and velocity[i] of lane i at t[i]. Either output may be nullptr.
+void sample(const QuinticLanes& lanes, const float* t, float* position, float* velocity);
+
+// "avx2+fma" or "scalar": the batch path this CPU uses.
+const char* batch_path();
+// For benchmarks: forces the portable batch loops when false.
+void set_batch_simd(bool enabled);
+
+} // namespace trajectory
+
+// Setpoint law for MavsdkMissionVehicle: once climbing starts, follows a
+// minimum-jerk climb from climb_threshold_m to target_altitude_m, at
+// climb_rate_m_s on average, and a minimum-jerk turn of yaw_rate_deg_s times
+// that duration. The vertical velocity and yaw ramp up and down smoothly
+// instead of stepping. After hold() it holds altitude and heading.
+class QuinticClimbRotateLaw {
+public:
+    explicit QuinticClimbRotateLaw(const MissionParams& params);
+
+    Setpoint next(
+        ClimbRotateState& state, bool climbing, SetpointStreamer::Clock::time_point deadline) const;
+
+    const trajectory::Quintic& altitude() const { return _altitude; }
+    const trajectory::Quintic& yaw() const { return _yaw; }
+
+private:
+    trajectory::Quintic _altitude;
+    trajectory::Quintic _yaw;
+};
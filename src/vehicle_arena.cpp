@@ -0,0 +1,50 @@
+#include "vehicle_arena.h"
+
+void* CountingResource::do_allocate(size_t bytes, size_t alignment)
+{
+    void* p = _upstream->allocate(bytes, alignment);
+    _allocations.fetch_add(1, std::memory_order_relaxed);
+    _bytes_in_use.fetch_add(bytes, std::memory_order_relaxed);
+    return p;
+}
+
+void CountingResource::do_deallocate(void* p, size_t bytes, size_t alignment)
+{
+    _upstream->deallocate(p, bytes, alignment);
+    _deallocations.fetch_add(1, std::memory_order_relaxed);
+    _bytes_in_use.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+VehicleArena::VehicleArena() : VehicleArena(Options{}) {}
+
+VehicleArena::VehicleArena(const Options& options) :
+    _upstream(options.upstream),
+    _buffer(options.initial_bytes, &_upstream),
+    _pool(&_buffer)
+{}
+
+void VehicleArena::seal()
+{
+    _sealed_at.store(_upstream.allocations(), std::memory_order_relaxed);
+}
+
+uint64_t VehicleArena::allocations_since_seal() const
+{
+    const auto sealed_at = _sealed_at.load(std::memory_order_relaxed);
+    return sealed_at == not_sealed ? 0 : _upstream.allocations() - sealed_at;
+}
+
+VehicleArena::Stats VehicleArena::stats() const
+{
+    Stats stats;
+    stats.upstream_allocations = _upstream.allocations();
+    stats.upstream_bytes = _upstream.bytes_in_use();
+    stats.allocations_since_seal = allocations_since_seal();
+    return stats;
+}
+
+std::ostream& operator<<(std::ostream& str, VehicleArena::Stats const& stats)
+{
+    return str << stats.upstream_allocations << " chunks (" << stats.upstream_bytes / 1024
+               << " KiB) from the heap, " << stats.allocations_since_seal << " after setup";
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+// Per-vehicle memory for the objects a mission keeps for its whole flight.
+//
+// A VehicleArena hands out memory through std::pmr. Behind it sits a pool
+// resource, which recycles freed blocks by size, on top of a monotonic buffer
+// that takes large chunks from the global heap and never gives them back.
+// Telemetry rings, log records and the containers of one vehicle are carved
+// out of its own arena, so vehicles never contend on the global allocator
+// and a flight's memory is released in one go.
+//
+// Every request the arena passes on to the global heap is counted. Once
+// setup is done, seal() the arena: allocations_since_seal() staying at zero
+// shows the flight loop did not need more memory.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <ostream>
+
+// Forwards to `upstream` and counts what passes through. Thread-safe if the
+// upstream is.
+class CountingResource : public std::pmr::memory_resource {
+public:
+    explicit CountingResource(
+        std::pmr::memory_resource* upstream = std::pmr::get_default_resource()) :
+        _upstream(upstream)
+    {}
+
+    uint64_t allocations() const { return _allocations.load(std::memory_order_relaxed); }
+    uint64_t deallocations() const { return _deallocations.load(std::memory_order_relaxed); }
+    // Currently allocated through this resource.
+    uint64_t bytes_in_use() const { return _bytes_in_use.load(std::memory_order_relaxed); }
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    std::pmr::memory_resource* _upstream;
+    std::atomic<uint64_t> _allocations{0};
+    std::atomic<uint64_t> _deallocations{0};
+    std::atomic<uint64_t> _bytes_in_use{0};
+};
+
+class VehicleArena {
+public:
+    struct Options {
+        // First chunk taken from the heap. Sized so rotate's mission, with a
+        // default AsyncLog and its telemetry rings, fits in it.
+        size_t initial_bytes{1024 * 1024};
+        std::pmr::memory_resource* upstream{std::pmr::get_default_resource()};
+    };
+
+    struct Stats {
+        // Chunks taken from the upstream resource.
+        uint64_t upstream_allocations{0};
+        uint64_t upstream_bytes{0};
+        // Chunks taken after seal().
+        uint64_t allocations_since_seal{0};
+    };
+
+    VehicleArena();
+    explicit VehicleArena(const Options& options);
+
+    VehicleArena(const VehicleArena&) = delete;
+    VehicleArena& operator=(const VehicleArena&) = delete;
+
+    // Thread-safe. Everything allocated from it must be freed before the
+    // arena is destroyed.
+    std::pmr::memory_resource* resource() { return &_pool; }
+
+    // Marks the end of setup.
+    void seal();
+    // 0 until sealed.
+    uint64_t allocations_since_seal() const;
+
+    Stats stats() const;
+
+private:
+    CountingResource _upstream;
+    std::pmr::monotonic_buffer_resource _buffer;
+    // Guards the buffer too: the pool is its only user.
+    std::pmr::synchronized_pool_resource _pool;
+    static constexpr uint64_t not_sealed = UINT64_MAX;
+    std::atomic<uint64_t> _sealed_at{not_sealed};
+};
+
+std::ostream& operator<<(std::ostream& str, VehicleArena::Stats const& stats);
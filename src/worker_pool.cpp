@@ -0,0 +1,79 @@
+#include "worker_pool.h"
+
+#include <algorithm>
+#include <utility>
+
+WorkerPool::WorkerPool(size_t workers)
+{
+    if (workers == 0) {
+        workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+    _workers.reserve(workers);
+    for (size_t i = 0; i < workers; ++i) {
+        _workers.emplace_back(&WorkerPool::run, this);
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _task_available.notify_all();
+    for (auto& worker : _workers) {
+        worker.join();
+    }
+}
+
+void WorkerPool::post(Task task)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _tasks.push_back(std::move(task));
+    }
+    _task_available.notify_one();
+}
+
+void WorkerPool::reserve(size_t tasks)
+{
+    // Grows the queue and shrinks it back under the lock, so no worker sees
+    // the placeholders. The freed blocks stay in _task_memory. Four times as
+    // many, so a queue sliding along its blocks finds room to recenter in the
+    // deque's block map instead of growing it.
+    std::lock_guard<std::mutex> lock(_mutex);
+    const size_t queued = _tasks.size();
+    _tasks.resize(queued + 4 * tasks);
+    _tasks.resize(queued);
+}
+
+void WorkerPool::wait_idle()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _idle.wait(lock, [this]() { return _tasks.empty() && _busy == 0; });
+}
+
+void WorkerPool::run()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (true) {
+        _task_available.wait(lock, [this]() { return _stopping || !_tasks.empty(); });
+        if (_tasks.empty()) {
+            // Only reached when stopping.
+            return;
+        }
+
+        auto task = std::move(_tasks.front());
+        _tasks.pop_front();
+        ++_busy;
+
+        lock.unlock();
+        task();
+        lock.lock();
+
+        --_busy;
+        if (_tasks.empty() && _busy == 0) {
+            _idle.notify_all();
+        }
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+// Fixed-size thread pool with a FIFO task queue.
+//
+// The queue's memory is recycled, so once it has been as long as it gets,
+// post() only allocates if the task is too big for std::function to store in
+// place (more than a couple of pointers, or not trivially copyable).
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory_resource>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkerPool {
+public:
+    using Task = std::function<void()>;
+
+    // 0 workers means one per hardware thread.
+    explicit WorkerPool(size_t workers = 0);
+    // Finishes the queued tasks, then joins the workers.
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    void post(Task task);
+
+    // Makes room for `tasks` queued tasks up front, so post() does not
+    // allocate as long as the queue stays that short.
+    void reserve(size_t tasks);
+
+    // Blocks until the queue is empty and no task is running.
+    void wait_idle();
+
+    size_t size() const { return _workers.size(); }
+
+private:
+    void run();
+
+    std::mutex _mutex;
+    std::condition_variable _task_available;
+    std::condition_variable _idle;
+    // Both guarded by _mutex.
+    std::pmr::unsynchronized_pool_resource _task_memory;
+    std::pmr::deque<Task> _tasks{&_task_memory};
+    size_t _busy{0};
+    bool _stopping{false};
+    std::vector<std::thread> _workers;
+};
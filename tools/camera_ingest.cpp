@@ -0,0 +1,180 @@
+// ROS 2 node that ingests the x500 camera topic into a shared-memory FrameRing,
+// so C++ and Python consumers (vision.py --frame-ring) read frames in place
+// instead of each deserializing and copying them.
+//
+//   build/camera_ingest --ros-args -p ring:=/rotate_frames -p slots:=8
+//   python3 vision.py --frame-ring /rotate_frames
+//
+// With `bgr` (the default) frames are converted to what OpenCV displays while
+// they are copied in, using the SIMD kernels in image_kernels.h, and with
+// `downscale` they are also halved in the same pass. With `bgr:=false` a
+// halved frame keeps the camera's channel order and encoding.
+//
+// Parameters: topic, ring, slots, max_frame_bytes, bgr, downscale.
+
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include <rclcpp/rclcpp.hpp>
+#include <sensor_msgs/msg/image.hpp>
+
+#include "frame_ring.h"
+#include "image_kernels.h"
+
+namespace {
+
+const char* default_topic =
+    "/world/default/model/x500_mono_cam_0/link/camera_link/sensor/camera/image";
+
+image_kernels::Format format_of(FrameRing::Encoding encoding)
+{
+    switch (encoding) {
+        case FrameRing::Encoding::Rgb8:
+            return image_kernels::Format::Rgb8;
+        case FrameRing::Encoding::Bgr8:
+            return image_kernels::Format::Bgr8;
+        default:
+            return image_kernels::Format::Mono8;
+    }
+}
+
+FrameRing::Encoding encoding_of(const std::string& encoding)
+{
+    if (encoding == "rgb8") {
+        return FrameRing::Encoding::Rgb8;
+    }
+    if (encoding == "bgr8") {
+        return FrameRing::Encoding::Bgr8;
+    }
+    if (encoding == "mono8" || encoding == "8UC1") {
+        return FrameRing::Encoding::Mono8;
+    }
+    return FrameRing::Encoding::Unknown;
+}
+
+class CameraIngest : public rclcpp::Node {
+public:
+    CameraIngest() : Node("camera_ingest")
+    {
+        const auto topic = declare_parameter<std::string>("topic", default_topic);
+        const auto ring_name = declare_parameter<std::string>("ring", "/rotate_frames");
+        const auto slots = declare_parameter<int>("slots", 8);
+        const auto max_frame_bytes = declare_parameter<int>("max_frame_bytes", 1920 * 1080 * 3);
+        _bgr = declare_parameter<bool>("bgr", true);
+        _downscale = declare_parameter<bool>("downscale", false);
+
+        _ring = FrameRing::create(
+            ring_name, static_cast<uint32_t>(slots), static_cast<size_t>(max_frame_bytes));
+        if (!_ring) {
+            throw std::runtime_error("could not create frame ring " + ring_name);
+        }
+        std::ostringstream isa;
+        isa << image_kernels::isa();
+        RCLCPP_INFO(
+            get_logger(),
+            "Ingesting %s into %s (bgr: %d, downscale: %d, kernels: %s)",
+            topic.c_str(),
+            ring_name.c_str(),
+            _bgr,
+            _downscale,
+            isa.str().c_str());
+
+        _subscription = create_subscription<sensor_msgs::msg::Image>(
+            topic, 10, [this](sensor_msgs::msg::Image::ConstSharedPtr msg) { on_image(*msg); });
+        _stats_timer = create_wall_timer(std::chrono::seconds(5), [this]() { log_stats(); });
+    }
+
+private:
+    void on_image(const sensor_msgs::msg::Image& msg)
+    {
+        const auto encoding = encoding_of(msg.encoding);
+        if (encoding == FrameRing::Encoding::Unknown) {
+            RCLCPP_WARN_ONCE(get_logger(), "Unsupported encoding: %s", msg.encoding.c_str());
+            return;
+        }
+
+        FrameRing::FrameInfo info;
+        info.stamp_ns = rclcpp::Time(msg.header.stamp).nanoseconds();
+
+        if (!_bgr && !_downscale) {
+            uint8_t* slot = _ring->claim(msg.data.size());
+            if (slot == nullptr) {
+                return; // Counted as dropped by the ring.
+            }
+            // The only copy: from the message into shared memory.
+            std::memcpy(slot, msg.data.data(), msg.data.size());
+            info.width = msg.width;
+            info.height = msg.height;
+            info.step = msg.step;
+            info.encoding = encoding;
+            info.size = msg.data.size();
+            _ring->publish(info);
+            return;
+        }
+
+        // Convert and/or halve on the way into shared memory, in one pass.
+        const auto format = format_of(encoding);
+        const bool mono = format == image_kernels::Format::Mono8;
+        info.width = image_kernels::output_width(msg.width, _downscale);
+        info.height = image_kernels::output_height(msg.height, _downscale);
+        info.step = info.width * image_kernels::channels(format);
+        if (_bgr) {
+            info.encoding = mono ? FrameRing::Encoding::Mono8 : FrameRing::Encoding::Bgr8;
+        } else {
+            info.encoding = encoding;
+        }
+        info.size = size_t{info.step} * info.height;
+
+        uint8_t* slot = _ring->claim(info.size);
+        if (slot == nullptr) {
+            return;
+        }
+        if (_bgr) {
+            image_kernels::to_display(
+                format,
+                msg.data.data(),
+                msg.step,
+                slot,
+                info.step,
+                msg.width,
+                msg.height,
+                _downscale);
+        } else if (mono) {
+            image_kernels::downscale2x_mono(
+                msg.data.data(), msg.step, slot, info.step, msg.width, msg.height);
+        } else {
+            image_kernels::downscale2x_rgb(
+                msg.data.data(), msg.step, slot, info.step, msg.width, msg.height, false);
+        }
+        _ring->publish(info);
+    }
+
+    void log_stats()
+    {
+        RCLCPP_INFO(
+            get_logger(),
+            "Frames published: %llu, dropped: %llu",
+            static_cast<unsigned long long>(_ring->published()),
+            static_cast<unsigned long long>(_ring->dropped()));
+    }
+
+    bool _bgr{true};
+    bool _downscale{false};
+    std::unique_ptr<FrameRing> _ring;
+    rclcpp::Subscription<sensor_msgs::msg::Image>::SharedPtr _subscription;
+    rclcpp::TimerBase::SharedPtr _stats_timer;
+};
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    rclcpp::init(argc, argv);
+    rclcpp::spin(std::make_shared<CameraIngest>());
+    rclcpp::shutdown();
+    return 0;
+}
@@ -0,0 +1,116 @@
+// Prints a time window of a flight recorder file as CSV.
+//
+// The window is located by binary search, so only the records inside it are
+// read, however long the recording is.
+//
+//   build/rotate udpin://0.0.0.0:14540 --record flight.bin
+//   build/flight_log flight.bin --from 10 --to 12 --type position
+//
+// Usage: flight_log <file> [--from S] [--to S] [--type NAME] [--info]
+
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+#include "flight_log.h"
+
+namespace {
+
+const char* arg(int argc, char** argv, const char* name, const char* fallback)
+{
+    for (int i = 2; i + 1 < argc; ++i) {
+        if (std::strcmp(argv[i], name) == 0) {
+            return argv[i + 1];
+        }
+    }
+    return fallback;
+}
+
+bool flag(int argc, char** argv, const char* name)
+{
+    for (int i = 2; i < argc; ++i) {
+        if (std::strcmp(argv[i], name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string type_name(flight_record::Type type)
+{
+    std::ostringstream str;
+    str << type;
+    return str.str();
+}
+
+void print_record(const FlightLog& log, const flight_record::Record& record)
+{
+    std::cout << log.seconds(record) << ',' << record.type;
+
+    flight_record::Position position;
+    flight_record::Attitude attitude;
+    flight_record::VelocityNed velocity;
+    flight_record::InAir in_air;
+    flight_record::Health health;
+
+    if (FlightLog::get(record, position)) {
+        std::cout << ',' << std::setprecision(9) << position.latitude_deg << ','
+                  << position.longitude_deg << std::setprecision(6) << ','
+                  << position.absolute_altitude_m << ',' << position.relative_altitude_m;
+    } else if (FlightLog::get(record, attitude)) {
+        std::cout << ',' << attitude.roll_deg << ',' << attitude.pitch_deg << ','
+                  << attitude.yaw_deg;
+    } else if (FlightLog::get(record, velocity)) {
+        std::cout << ',' << velocity.north_m_s << ',' << velocity.east_m_s << ','
+                  << velocity.down_m_s;
+    } else if (FlightLog::get(record, in_air)) {
+        std::cout << ',' << static_cast<int>(in_air.in_air);
+    } else if (FlightLog::get(record, health)) {
+        std::cout << ",0x" << std::hex << health.bits << std::dec;
+    }
+    std::cout << '\n';
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0]
+                  << " <file> [--from S] [--to S] [--type NAME] [--info]\n";
+        return 1;
+    }
+
+    FlightLog log;
+    if (!log.open(argv[1])) {
+        std::cerr << "Could not open " << argv[1] << " as a flight recording\n";
+        return 1;
+    }
+
+    const double duration_s = log.size() > 0 ? log.seconds(log[log.size() - 1]) : 0.0;
+    std::cerr << argv[1] << ": " << log.size() << " records, " << duration_s << " s"
+              << (log.header().record_count == 0 ? " (not closed cleanly)" : "") << '\n';
+    if (flag(argc, argv, "--info")) {
+        return 0;
+    }
+
+    const double from_s = std::atof(arg(argc, argv, "--from", "0"));
+    const char* to = arg(argc, argv, "--to", nullptr);
+    const int64_t to_ns =
+        to != nullptr ? log.time_ns_at(std::atof(to)) : std::numeric_limits<int64_t>::max();
+    const std::string type = arg(argc, argv, "--type", "");
+
+    std::cout << std::fixed << std::setprecision(6);
+    for (size_t i = log.lower_bound(log.time_ns_at(from_s));
+         i < log.size() && log[i].time_ns < to_ns;
+         ++i) {
+        if (!type.empty() && type_name(log[i].type) != type) {
+            continue;
+        }
+        print_record(log, log[i]);
+    }
+    return 0;
+}
@@ -0,0 +1,82 @@
+// Runs one or more mock autopilots until interrupted, so rotate can be tried
+// without PX4 SITL:
+//
+//   build/mock_autopilot --vehicles 1 --port 14540
+//   build/rotate udpin://0.0.0.0:14540
+//
+// Usage: mock_autopilot [--port PORT] [--host HOST] [--vehicles N]
+//                       [--time-scale X] [--health-delay-s S]
+
+#include <atomic>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "mock_autopilot.h"
+
+namespace {
+
+std::atomic<bool> interrupted{false};
+
+const char* arg(int argc, char** argv, const char* name, const char* fallback)
+{
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::strcmp(argv[i], name) == 0) {
+            return argv[i + 1];
+        }
+    }
+    return fallback;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const int vehicles = std::atoi(arg(argc, argv, "--vehicles", "1"));
+
+    MockAutopilot::Options options;
+    options.remote_host = arg(argc, argv, "--host", "127.0.0.1");
+    options.remote_port = static_cast<uint16_t>(std::atoi(arg(argc, argv, "--port", "14540")));
+    options.time_scale = std::atof(arg(argc, argv, "--time-scale", "1.0"));
+    options.health_delay_s = std::atof(arg(argc, argv, "--health-delay-s", "0.0"));
+
+    if (vehicles < 1 || vehicles > 255 || options.time_scale <= 0.0) {
+        std::cerr << "Usage: " << argv[0]
+                  << " [--port PORT] [--host HOST] [--vehicles N] [--time-scale X]"
+                     " [--health-delay-s S]\n";
+        return 1;
+    }
+
+    std::vector<std::unique_ptr<MockAutopilot>> autopilots;
+    for (int i = 0; i < vehicles; ++i) {
+        options.system_id = static_cast<uint8_t>(i + 1);
+        autopilots.push_back(std::make_unique<MockAutopilot>(options));
+        if (!autopilots.back()->start()) {
+            std::cerr << "Could not start mock autopilot " << i + 1 << '\n';
+            return 1;
+        }
+    }
+
+    std::signal(SIGINT, [](int) { interrupted = true; });
+    std::signal(SIGTERM, [](int) { interrupted = true; });
+
+    std::cout << "Running " << vehicles << " mock autopilot(s) towards " << options.remote_host
+              << ':' << options.remote_port << ", time scale " << options.time_scale << '\n';
+
+    while (!interrupted) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    for (size_t i = 0; i < autopilots.size(); ++i) {
+        autopilots[i]->stop();
+        const auto stats = autopilots[i]->stats();
+        std::cout << "Vehicle " << i + 1 << ": sent "
+                  << stats.messages_sent << " messages (" << stats.bytes_sent << " bytes), "
+                  << "received " << stats.messages_received << '\n';
+    }
+    return 0;
+}
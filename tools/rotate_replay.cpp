@@ -0,0 +1,197 @@
+// Re-runs rotate's mission logic against a recorded flight, without a vehicle.
+//
+// Telemetry from a `rotate --record` file is played back through the same
+// callbacks rotate subscribes live. Commands are only printed and always
+// succeed. The sequencer runs on the recording's clock, so phase changes land
+// on the same recorded instants at any playback speed. That makes this useful
+// for regression-testing and profiling sequencer changes offline. Pass the
+// --profile and --geofence the flight was flown with to replay it as flown,
+// or others to see what they would have changed.
+//
+//   build/rotate udpin://0.0.0.0:14540 --record flight.bin
+//   build/rotate_replay flight.bin --speed 0
+//
+// Usage: rotate_replay <file> [--speed X] [--profile <file>] [--geofence <file>]
+//        (X = 0 plays as fast as possible)
+
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <thread>
+
+#include "flight_log.h"
+#include "flight_profile.h"
+#include "geofence.h"
+#include "replay_source.h"
+#include "rotate_mission.h"
+
+using namespace mavsdk;
+
+namespace {
+
+// Prints each command with the recorded time it was sent at.
+class ReplayVehicle : public RotateMission::Vehicle {
+public:
+    ReplayVehicle(const FlightLog& log, const ReplaySource& replay) : _log(log), _replay(replay)
+    {}
+
+    void set_rate_profile(const RateProfile& profile) override
+    {
+        std::cout << "  [" << seconds() << " s] rate profile " << profile.name << '\n';
+    }
+    bool arm() override { return command("arm"); }
+    bool takeoff(float altitude_m) override
+    {
+        std::cout << "  [" << seconds() << " s] set takeoff altitude " << altitude_m << " m\n";
+        return command("takeoff");
+    }
+    bool start_offboard(float yaw_deg) override
+    {
+        std::cout << "  [" << seconds() << " s] first setpoint, yaw " << yaw_deg << " deg\n";
+        return command("start offboard");
+    }
+    void hold() override { command("hold"); }
+    bool land() override { return command("land"); }
+    bool return_to_launch() override { return command("return to launch"); }
+
+private:
+    double seconds() const
+    {
+        return static_cast<double>(
+                   _replay.now().time_since_epoch().count() - _log.header().start_steady_ns) *
+               1e-9;
+    }
+
+    bool command(const char* name) const
+    {
+        std::cout << "  [" << seconds() << " s] " << name << '\n';
+        return true;
+    }
+
+    const FlightLog& _log;
+    const ReplaySource& _replay;
+};
+
+void usage(const std::string& bin_name)
+{
+    std::cerr << "Usage: " << bin_name
+              << " <file> [--speed X] [--profile <file>] [--geofence <file>]\n";
+}
+
+// Parses a whole argument as a finite, non-negative speed factor.
+bool parse_speed(const char* text, double& speed)
+{
+    char* end = nullptr;
+    errno = 0;
+    const double value = std::strtod(text, &end);
+    if (end == text || *end != '\0' || errno != 0 || !std::isfinite(value) || value < 0.0) {
+        return false;
+    }
+    speed = value;
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc < 2 || argc % 2 != 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    ReplaySource::Options options;
+    std::string profile_path;
+    std::string geofence_path;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        const std::string option = argv[i];
+        if (option == "--speed") {
+            if (!parse_speed(argv[i + 1], options.speed)) {
+                std::cerr << "Invalid speed: " << argv[i + 1] << '\n';
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (option == "--profile") {
+            profile_path = argv[i + 1];
+        } else if (option == "--geofence") {
+            geofence_path = argv[i + 1];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // The same defaults and loaders as rotate.
+    MissionParams params = flight_profiles::X500Sitl::params;
+    if (!profile_path.empty()) {
+        std::string error;
+        if (!load_mission_params(profile_path, params, error)) {
+            std::cerr << "Invalid profile: " << error << '\n';
+            return 1;
+        }
+    }
+    std::optional<Geofence> geofence;
+    if (!geofence_path.empty()) {
+        Geofence::Description fence;
+        std::string error;
+        if (!load_geofence(geofence_path, fence, error)) {
+            std::cerr << "Invalid geofence: " << error << '\n';
+            return 1;
+        }
+        geofence.emplace(fence);
+    }
+
+    FlightLog log;
+    if (!log.open(argv[1])) {
+        std::cerr << "Could not open " << argv[1] << " as a flight recording\n";
+        return 1;
+    }
+
+    ReplaySource replay{log, options};
+
+    ReplayVehicle vehicle{log, replay};
+    RotateMission mission{vehicle, params};
+    if (geofence) {
+        mission.set_geofence(&*geofence);
+    }
+
+    replay.subscribe_position([&](Telemetry::Position position) { mission.on_position(position); });
+    replay.subscribe_attitude_euler(
+        [&](Telemetry::EulerAngle attitude) { mission.on_attitude(attitude); });
+    replay.subscribe_health([&](Telemetry::Health health) { mission.on_health(health); });
+    replay.subscribe_in_air([&](bool in_air) { mission.on_in_air(in_air); });
+
+    auto& sequencer = mission.sequencer();
+    sequencer.set_clock([&replay]() { return replay.now(); });
+    sequencer.set_phase_end_callback(
+        [&](const MissionSequencer::Phase& phase,
+            MissionSequencer::Result result,
+            MissionSequencer::Clock::duration elapsed) {
+            std::cout << "Phase " << phase.name << ": " << result << " after "
+                      << std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count()
+                      << " ms\n";
+        });
+
+    std::cout << std::fixed << std::setprecision(3);
+
+    const auto started = std::chrono::steady_clock::now();
+    size_t played = 0;
+    std::thread player{[&]() { played = replay.play(sequencer); }};
+    const auto result = mission.run();
+    replay.stop();
+    player.join();
+    const double wall_s =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    if (result != MissionSequencer::Result::Success && sequencer.last_phase() == "health") {
+        std::cout << "Still waiting for: " << mission.health_missing() << '\n';
+    }
+    std::cout << "Mission " << result << " in phase " << sequencer.last_phase() << "; played "
+              << played << " of " << log.size() << " samples in " << wall_s << " s ("
+              << static_cast<double>(played) / wall_s << " samples/s)\n";
+    return result == MissionSequencer::Result::Success ? 0 : 1;
+}
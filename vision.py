@@ -1,35 +1,156 @@
 #!/usr/bin/env python3
+import argparse
+import sys
+import threading
+import time
+
 import rclpy
+from rclpy.executors import SingleThreadedExecutor
 from rclpy.node import Node
 from sensor_msgs.msg import Image
 import numpy as np
 import cv2
 
+from frame_dump import FORMATS, FrameDumper
+
+
+class DisplayFrame:
+    """A frame waiting to be shown, with the times its latency is measured from."""
+
+    def __init__(self, img, stamp_ns, received_ns, pinned=None):
+        self.img = img
+        # Header stamp, on the node's (possibly simulated) clock
+        self.stamp_ns = stamp_ns
+        # time.monotonic_ns() when the frame reached this process (or, from the
+        # ring, when camera_ingest published it)
+        self.received_ns = received_ns
+        # Ring frame kept pinned until it has been shown
+        self._pinned = pinned
+
+    def release(self):
+        if self._pinned is not None:
+            self._pinned.release()
+            self._pinned = None
+        self.img = None
+
+
+class LatestFrame:
+    """Single-slot mailbox between ingestion and rendering.
+
+    put() replaces a frame that has not been taken yet, so the renderer always
+    gets the newest one and a slow GUI never builds a backlog.
+    """
+
+    def __init__(self):
+        self._cond = threading.Condition()
+        self._frame = None
+        self.replaced = 0
+
+    def put(self, frame):
+        with self._cond:
+            old, self._frame = self._frame, frame
+            if old is not None:
+                self.replaced += 1
+            self._cond.notify()
+        if old is not None:
+            old.release()
+
+    def take(self, timeout):
+        with self._cond:
+            if self._frame is None:
+                self._cond.wait(timeout)
+            frame, self._frame = self._frame, None
+        return frame
+
+
+class LatencyWindow:
+    """Latency samples in ms since the last report."""
 
-class X500MonoCam(Node):
     def __init__(self):
+        self._lock = threading.Lock()
+        self._samples = []
+
+    def add(self, ms):
+        with self._lock:
+            self._samples.append(ms)
+
+    def take(self):
+        with self._lock:
+            samples, self._samples = self._samples, []
+        return sorted(samples)
+
+    @staticmethod
+    def summary(samples):
+        if not samples:
+            return 'n/a'
+
+        def at(q):
+            return samples[min(len(samples) - 1, int(q * len(samples)))]
+        return f'p50 {at(0.5):.1f} p99 {at(0.99):.1f} max {samples[-1]:.1f} ms'
+
+
+class X500MonoCam(Node):
+    def __init__(self, frame_ring=None, dumper=None, dump_every=0):
         super().__init__('x500_mono_cam_node')
 
         # Create a resizable OpenCV window and set an initial size
         cv2.namedWindow('x500 mono cam', cv2.WINDOW_NORMAL)
         cv2.resizeWindow('x500 mono cam', 800, 600)
 
+        self.frame_count = 0
+        self.displayed_count = 0
+        self.logged_encoding = False
+
+        # Ingestion (this node's callbacks, on the executor thread) hands frames
+        # to the render loop (render(), on the main thread) through `latest`.
+        self.latest = LatestFrame()
+        self.stamp_latency = LatencyWindow()
+        self.queue_latency = LatencyWindow()
+        self.stats_timer = self.create_timer(5.0, self.log_stats)
+
+        # Frames are saved off the callback by a FrameDumper. Without --dump-dir
+        # there is still one, for the first frame only.
+        self.dump_every = dump_every
+        self.dumper = dumper or FrameDumper('.', fmt='png', workers=1, queue_size=1)
+        self.log_dumps = dumper is not None
+
+        if frame_ring is not None:
+            # Frames ingested by camera_ingest, read in place from shared memory
+            from frame_ring import FrameRing
+            self.ring = FrameRing(frame_ring)
+            self.last_sequence = 0
+            self.get_logger().info(f'Reading frames from ring: {frame_ring}')
+            self.timer = self.create_timer(0.001, self.poll_ring)
+            return
+
         # ROS 2 image topic published by ros_gz_image image_bridge
         self.topic = '/world/default/model/x500_mono_cam_0/link/camera_link/sensor/camera/image'
         self.get_logger().info(f'Subscribing to: {self.topic}')
 
-        # Subscription to the image topic
+        # Subscription to the image topic. Only the newest frame is shown, so
+        # there is no point queueing more than one.
         self.sub = self.create_subscription(
             Image,
             self.topic,
             self.image_callback,
-            10
+            1
         )
 
-        self.frame_count = 0
-        self.logged_encoding = False
+    def poll_ring(self):
+        frame = self.ring.acquire_latest(self.last_sequence)
+        if frame is None:
+            return
+        self.last_sequence = frame.sequence
+        img = frame.image
+        if frame.encoding == 'rgb8':
+            img = cv2.cvtColor(img, cv2.COLOR_RGB2BGR)
+        # Shown in place: the slot stays pinned until the renderer is done
+        # with it, or until a newer frame replaces it.
+        self.ingest(DisplayFrame(img, frame.stamp_ns, frame.publish_ns, pinned=frame))
 
     def image_callback(self, msg: Image):
+        received_ns = time.monotonic_ns()
+
         # Log encoding info only once
         if not self.logged_encoding:
             self.get_logger().info(
@@ -59,28 +180,105 @@ class X500MonoCam(Node):
         if msg.encoding == 'rgb8':
             img = cv2.cvtColor(img, cv2.COLOR_RGB2BGR)
 
+        stamp_ns = msg.header.stamp.sec * 1_000_000_000 + msg.header.stamp.nanosec
+        self.ingest(DisplayFrame(img, stamp_ns, received_ns))
+
+    def ingest(self, frame):
+        img = frame.img
+
+        # Save the first frame to disk for debugging
+        if self.frame_count == 0:
+            self.dumper.submit(img, 'x500_first_frame', fmt='png')
+            self.get_logger().info('Saving x500_first_frame.png')
+
+        # Keep every Nth frame
+        if self.dump_every and self.frame_count % self.dump_every == 0:
+            self.dumper.submit(img, f'frame_{self.frame_count:06d}')
+
+        self.frame_count += 1
+        self.latest.put(frame)
+
+    def render(self, timeout=0.1):
+        """Shows the newest frame, if there is one. Call from the GUI thread."""
+        frame = self.latest.take(timeout)
+        if frame is None:
+            cv2.waitKey(1)
+            return
+
         # Optionally scale down the image before displaying (uncomment if needed)
         # img = cv2.resize(img, None, fx=0.5, fy=0.5, interpolation=cv2.INTER_AREA)
 
         # Show image in the OpenCV window
-        cv2.imshow('x500 mono cam', img)
+        cv2.imshow('x500 mono cam', frame.img)
         cv2.waitKey(1)
 
-        # Save the first frame to disk for debugging
-        if self.frame_count == 0:
-            cv2.imwrite('x500_first_frame.png', img)
-            self.get_logger().info('Saved x500_first_frame.png')
+        # Measured once the frame has been handed to the window
+        displayed_ns = time.monotonic_ns()
+        now_ns = self.get_clock().now().nanoseconds
+        if frame.stamp_ns > 0:
+            self.stamp_latency.add((now_ns - frame.stamp_ns) / 1e6)
+        self.queue_latency.add((displayed_ns - frame.received_ns) / 1e6)
+        self.displayed_count += 1
+        frame.release()
 
-        self.frame_count += 1
+    def log_stats(self):
+        self.get_logger().info(
+            f'Display: {self.displayed_count} shown, {self.latest.replaced} replaced '
+            f'before shown; stamp->display '
+            f'{LatencyWindow.summary(self.stamp_latency.take())}; receive->display '
+            f'{LatencyWindow.summary(self.queue_latency.take())}')
+        if self.log_dumps:
+            self.log_dump_stats()
+
+    def log_dump_stats(self):
+        stats = self.dumper.stats()
+        self.get_logger().info(
+            f"Frame dump: {stats['written']} written, {stats['dropped']} dropped, "
+            f"{stats['failed']} failed, queue {stats['queue_depth']} "
+            f"(max {stats['max_queue_depth']})")
 
 
 def main():
-    rclpy.init()
-    node = X500MonoCam()
+    parser = argparse.ArgumentParser()
+    parser.add_argument('--frame-ring', metavar='NAME',
+                        help='read frames from camera_ingest\'s shared-memory ring, '
+                             'e.g. /rotate_frames, instead of subscribing to the topic')
+    parser.add_argument('--dump-dir', metavar='DIR',
+                        help='save frames to DIR in the background')
+    parser.add_argument('--dump-every', type=int, default=30, metavar='N',
+                        help='with --dump-dir, save every Nth frame (default 30)')
+    parser.add_argument('--dump-format', choices=FORMATS, default='png')
+    parser.add_argument('--dump-workers', type=int, default=2, metavar='N',
+                        help='encoder threads (default 2)')
+    parser.add_argument('--dump-queue', type=int, default=16, metavar='N',
+                        help='frames waiting to be written before new ones are dropped '
+                             '(default 16)')
+    args, ros_args = parser.parse_known_args()
+
+    dumper = None
+    if args.dump_dir:
+        dumper = FrameDumper(args.dump_dir, fmt=args.dump_format,
+                             workers=args.dump_workers, queue_size=args.dump_queue)
+
+    rclpy.init(args=[sys.argv[0]] + ros_args)
+    node = X500MonoCam(args.frame_ring, dumper, args.dump_every if dumper else 0)
+
+    # Ingestion spins on its own thread; the main thread only renders, so a
+    # slow window never holds up the callbacks.
+    executor = SingleThreadedExecutor()
+    executor.add_node(node)
+    spinner = threading.Thread(target=executor.spin, name='ingest', daemon=True)
+    spinner.start()
     try:
-        rclpy.spin(node)
+        while rclpy.ok():
+            node.render()
     except KeyboardInterrupt:
         pass
+    executor.shutdown()
+    spinner.join()
+    node.dumper.close()
+    if dumper is not None:
+        node.log_dump_stats()
     node.destroy_node()
     cv2.destroyAllWindows()
     rclpy.shutdown()